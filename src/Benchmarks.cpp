@@ -0,0 +1,339 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+#include "Benchmarks.h"
+
+#ifdef _DEBUG
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "CpuFeatures.h"
+#include "JpegWriter.h"
+#include "OverlayControl.h"
+#include "PixelPacking.h"
+#include "Qoi.h"
+#include "fpng.h"
+#include "std_image_write.h"
+#include "Utils.h"
+
+namespace IGCS::Benchmarks
+{
+	namespace
+	{
+		struct BenchmarkResolution
+		{
+			const char* name;
+			uint32_t width;
+			uint32_t height;
+		};
+
+		const BenchmarkResolution g_resolutions[] = { { "1080p", 1920, 1080 }, { "4K", 3840, 2160 }, { "8K", 7680, 4320 } };
+		const int NumberOfIterations = 10;
+		const int NumberOfEncodeIterations = 3;		// encoding an image takes a lot longer than packing pixels.
+
+
+		/// <summary>
+		/// Runs func numberOfIterations times and returns the fastest run in milliseconds.
+		/// </summary>
+		template<typename Func>
+		double measureFastestRun(Func func, int numberOfIterations = NumberOfIterations)
+		{
+			double fastest = 0.0;
+			for(int i = 0; i < numberOfIterations; ++i)
+			{
+				const auto start = std::chrono::steady_clock::now();
+				func();
+				const double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+				if(i == 0 || elapsed < fastest)
+				{
+					fastest = elapsed;
+				}
+			}
+			return fastest;
+		}
+
+
+		void fillWithPattern(std::vector<uint8_t>& buffer)
+		{
+			uint32_t state = 0x12345678;
+			for(uint8_t& value : buffer)
+			{
+				// xorshift, so the data isn't trivially compressible / predictable.
+				state ^= state << 13;
+				state ^= state >> 17;
+				state ^= state << 5;
+				value = (uint8_t)state;
+			}
+		}
+
+
+		/// <summary>
+		/// Fills the RGB buffer with something which compresses like a rendered frame: smooth gradients with a bit of noise, and a flat area.
+		/// Random data is the worst case for the lossless encoders and not representative.
+		/// </summary>
+		void fillWithImage(std::vector<uint8_t>& buffer, uint32_t width, uint32_t height)
+		{
+			uint32_t state = 0x12345678;
+			for(uint32_t y = 0; y < height; ++y)
+			{
+				uint8_t* row = buffer.data() + (size_t)y * width * 3;
+				for(uint32_t x = 0; x < width; ++x)
+				{
+					state ^= state << 13;
+					state ^= state >> 17;
+					state ^= state << 5;
+					const uint8_t noise = (uint8_t)(state & 0x7);
+					const bool isFlat = y > (height * 3) / 4;
+					row[x * 3 + 0] = isFlat ? 40 : (uint8_t)((x * 255) / width + noise);
+					row[x * 3 + 1] = isFlat ? 90 : (uint8_t)((y * 255) / height + noise);
+					row[x * 3 + 2] = isFlat ? 140 : (uint8_t)(((x + y) * 127) / (width + height) + noise);
+				}
+			}
+		}
+
+
+		/// <summary>
+		/// Converts the RGB image to RGBA. Every 100th pixel gets a different alpha, so in the flat area long runs are ended by a pixel which
+		/// has to be stored with all its channels, the largest a pixel gets in QOI.
+		/// </summary>
+		void addAlphaChannel(const std::vector<uint8_t>& source, std::vector<uint8_t>& destination)
+		{
+			const size_t numberOfPixels = source.size() / 3;
+			destination.resize(numberOfPixels * 4);
+			for(size_t i = 0; i < numberOfPixels; ++i)
+			{
+				memcpy(destination.data() + i * 4, source.data() + i * 3, 3);
+				destination[i * 4 + 3] = (i % 100 == 0) ? 128 : 255;
+			}
+		}
+
+
+		bool isQoiRoundTripLossless(const std::vector<uint8_t>& source, const BenchmarkResolution& resolution, int numberOfChannels)
+		{
+			std::vector<uint8_t> encodedData;
+			std::vector<uint8_t> decodedData;
+			int decodedWidth = 0;
+			int decodedHeight = 0;
+			return Qoi::encodeToMemory(encodedData, source.data(), resolution.width, resolution.height, numberOfChannels) &&
+				   Qoi::decode(encodedData.data(), encodedData.size(), decodedData, decodedWidth, decodedHeight, numberOfChannels) &&
+				   decodedWidth == (int)resolution.width && decodedHeight == (int)resolution.height && decodedData == source;
+		}
+
+
+		void benchmarkPixelPacker(const char* packerName, void(*packer)(uint8_t*, size_t), const BenchmarkResolution& resolution, const std::vector<uint8_t>& source, 
+								  const std::vector<uint8_t>& expected, std::vector<uint8_t>& workBuffer)
+		{
+			const size_t numberOfPixels = (size_t)resolution.width * resolution.height;
+			// validate first, the packing is in place so we have to restore the source before each run.
+			memcpy(workBuffer.data(), source.data(), source.size());
+			packer(workBuffer.data(), numberOfPixels);
+			const bool isValid = memcmp(workBuffer.data(), expected.data(), expected.size()) == 0;
+
+			const double fastestInMs = measureFastestRun([&]
+			{
+				packer(workBuffer.data(), numberOfPixels);
+			});
+			const double gigabytesPerSecond = ((double)numberOfPixels * 4 / (1024.0 * 1024.0 * 1024.0)) / (fastestInMs / 1000.0);
+			Utils::logLineToReshade(reshade::log::level::info, "Pixel packing %s, %s: %.3fms, %.2f GB/s%s", resolution.name, packerName, fastestInMs, gigabytesPerSecond,
+									isValid ? "" : " OUTPUT DOESN'T MATCH THE SCALAR PACKER!");
+		}
+
+
+		void benchmarkPixelPacking()
+		{
+			Utils::logLineToReshade(reshade::log::level::info, "Pixel packing benchmark. Packer used for screenshots: %s", PixelPacking::getPackerName());
+			for(const BenchmarkResolution& resolution : g_resolutions)
+			{
+				const size_t numberOfPixels = (size_t)resolution.width * resolution.height;
+				std::vector<uint8_t> source(numberOfPixels * 4);
+				fillWithPattern(source);
+				std::vector<uint8_t> expected(numberOfPixels * 3);
+				for(size_t i = 0; i < numberOfPixels; ++i)
+				{
+					memcpy(expected.data() + 3 * i, source.data() + 4 * i, 3);
+				}
+				std::vector<uint8_t> workBuffer(source.size());
+
+				benchmarkPixelPacker("Scalar", &PixelPacking::packRGBAToRGBScalar, resolution, source, expected, workBuffer);
+				if(CpuFeatures::get().ssse3)
+				{
+					benchmarkPixelPacker("SSSE3", &PixelPacking::packRGBAToRGBSSSE3, resolution, source, expected, workBuffer);
+				}
+				if(CpuFeatures::get().avx2)
+				{
+					benchmarkPixelPacker("AVX2", &PixelPacking::packRGBAToRGBAVX2, resolution, source, expected, workBuffer);
+				}
+			}
+		}
+
+
+		void appendToVector(void* context, void* data, int size)
+		{
+			auto destination = static_cast<std::vector<uint8_t>*>(context);
+			destination->insert(destination->end(), static_cast<const uint8_t*>(data), static_cast<const uint8_t*>(data) + size);
+		}
+
+
+		void benchmarkJpegEncoder(int simdLevel, const BenchmarkResolution& resolution, const std::vector<uint8_t>& source)
+		{
+			const int quality = 98;
+			stbi_write_jpg_params params;
+			stbi_write_jpg_init_params(&params, resolution.width, resolution.height, 3, quality, 0);
+			params.simd_level = simdLevel;
+
+			std::vector<uint8_t> encodedData;
+			encodedData.reserve(source.size());
+			// a single band on a single thread, so we measure the kernels, not the threading.
+			const double fastestInMs = measureFastestRun([&]
+			{
+				encodedData.clear();
+				stbi_write_jpg_headers_to_func(&appendToVector, &encodedData, &params);
+				stbi_write_jpg_mcu_rows_to_func(&appendToVector, &encodedData, &params, source.data(), 0, params.num_mcu_rows);
+				stbi_write_jpg_end_to_func(&appendToVector, &encodedData);
+			}, NumberOfEncodeIterations);
+			const double megapixels = ((double)resolution.width * resolution.height) / 1000000.0;
+			Utils::logLineToReshade(reshade::log::level::info, "Jpeg encoding %s, %s, single thread: %.1fms, %.2fms per megapixel, %zu bytes", resolution.name,
+									JpegWriter::getSimdLevelName(simdLevel), fastestInMs, fastestInMs / megapixels, encodedData.size());
+		}
+
+
+		void benchmarkLosslessEncoding()
+		{
+			Utils::logLineToReshade(reshade::log::level::info, "Lossless encoding benchmark, QOI vs. PNG (fpng, all threads)");
+			for(const BenchmarkResolution& resolution : g_resolutions)
+			{
+				const double megabytes = ((double)resolution.width * resolution.height * 3) / (1024.0 * 1024.0);
+				std::vector<uint8_t> source((size_t)resolution.width * resolution.height * 3);
+				fillWithImage(source, resolution.width, resolution.height);
+
+				// round trip first, the qoi encoder has to be lossless. RGBA covers the largest encoded pixels, which the RGB image doesn't have.
+				std::vector<uint8_t> sourceWithAlpha;
+				addAlphaChannel(source, sourceWithAlpha);
+				const bool isValid = isQoiRoundTripLossless(source, resolution, 3) && isQoiRoundTripLossless(sourceWithAlpha, resolution, 4);
+				std::vector<uint8_t> encodedData;
+				std::vector<uint8_t> decodedData;
+				int decodedWidth = 0;
+				int decodedHeight = 0;
+				const double qoiEncodeInMs = measureFastestRun([&]
+				{
+					Qoi::encodeToMemory(encodedData, source.data(), resolution.width, resolution.height, 3);
+				}, NumberOfEncodeIterations);
+				const double qoiDecodeInMs = measureFastestRun([&]
+				{
+					Qoi::decode(encodedData.data(), encodedData.size(), decodedData, decodedWidth, decodedHeight, 3);
+				}, NumberOfEncodeIterations);
+				Utils::logLineToReshade(reshade::log::level::info, "QOI %s: encode %.1fms (%.0f MB/s), decode %.1fms (%.0f MB/s), %zu bytes%s", resolution.name,
+										qoiEncodeInMs, megabytes / (qoiEncodeInMs / 1000.0), qoiDecodeInMs, megabytes / (qoiDecodeInMs / 1000.0), encodedData.size(),
+										isValid ? "" : " ROUND TRIP FAILED!");
+
+				const double pngEncodeInMs = measureFastestRun([&]
+				{
+					fpng::fpng_encode_image_to_memory_parallel(source.data(), resolution.width, resolution.height, 3, encodedData);
+				}, NumberOfEncodeIterations);
+				Utils::logLineToReshade(reshade::log::level::info, "PNG %s: encode %.1fms (%.0f MB/s), %zu bytes", resolution.name, pngEncodeInMs,
+										megabytes / (pngEncodeInMs / 1000.0), encodedData.size());
+			}
+		}
+
+
+		void benchmarkFpng()
+		{
+			// fpng's features are process wide and used by sessions and the png recompressor at the same time, so only the features the addon uses are
+			// measured. That the other levels produce the same files as the scalar code is checked by the tests.
+			Utils::logLineToReshade(reshade::log::level::info, "fpng benchmark. Cpu features: %s", CpuFeatures::getDescription());
+			for(const BenchmarkResolution& resolution : g_resolutions)
+			{
+				std::vector<uint8_t> source((size_t)resolution.width * resolution.height * 3);
+				fillWithImage(source, resolution.width, resolution.height);
+				const double megabytes = (double)source.size() / (1024.0 * 1024.0);
+				const double adler32InMs = measureFastestRun([&]
+				{
+					fpng::fpng_adler32(source.data(), source.size());
+				});
+				const double crc32InMs = measureFastestRun([&]
+				{
+					fpng::fpng_crc32(source.data(), source.size());
+				});
+				// a single thread, so we measure the kernels, not the threading.
+				std::vector<uint8_t> encodedData;
+				const double encodeInMs = measureFastestRun([&]
+				{
+					fpng::fpng_encode_image_to_memory(source.data(), resolution.width, resolution.height, 3, encodedData);
+				}, NumberOfEncodeIterations);
+				Utils::logLineToReshade(reshade::log::level::info, "fpng %s: adler32 %.2fms (%.1f GB/s), crc32 %.2fms (%.1f GB/s), encode single thread %.1fms (%.0f MB/s)", 
+										resolution.name, adler32InMs, megabytes / 1024.0 / (adler32InMs / 1000.0), crc32InMs, megabytes / 1024.0 / (crc32InMs / 1000.0),
+										encodeInMs, megabytes / (encodeInMs / 1000.0));
+			}
+		}
+
+
+		void benchmarkJpegEncoding()
+		{
+			Utils::logLineToReshade(reshade::log::level::info, "Jpeg encoding benchmark. Kernels used for screenshots: %s", JpegWriter::getSimdLevelName(JpegWriter::getSimdLevel()));
+			for(const BenchmarkResolution& resolution : g_resolutions)
+			{
+				std::vector<uint8_t> source((size_t)resolution.width * resolution.height * 3);
+				fillWithPattern(source);
+				for(int simdLevel = 0; simdLevel <= JpegWriter::getSimdLevel(); ++simdLevel)
+				{
+					benchmarkJpegEncoder(simdLevel, resolution, source);
+				}
+
+				std::vector<uint8_t> encodedData;
+				const double fastestInMs = measureFastestRun([&]
+				{
+					JpegWriter::encodeToMemory(encodedData, source.data(), resolution.width, resolution.height, 3, 98, JpegChromaSubsampling::Subsampling444);
+				}, NumberOfEncodeIterations);
+				const double megapixels = ((double)resolution.width * resolution.height) / 1000000.0;
+				Utils::logLineToReshade(reshade::log::level::info, "Jpeg encoding %s, %s, all threads: %.1fms, %.2fms per megapixel", resolution.name,
+										JpegWriter::getSimdLevelName(JpegWriter::getSimdLevel()), fastestInMs, fastestInMs / megapixels);
+			}
+		}
+	}
+
+
+	void runBenchmarks()
+	{
+		OverlayControl::addNotification("Running benchmarks...");
+		benchmarkPixelPacking();
+		benchmarkFpng();
+		benchmarkJpegEncoding();
+		benchmarkLosslessEncoding();
+		OverlayControl::addNotification("Benchmarks done. Results are in the reshade log.");
+	}
+}
+#endif
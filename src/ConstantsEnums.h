@@ -103,7 +103,9 @@ enum class ScreenshotType : int
 {
 	HorizontalPanorama = 0,
 	MultiShot = 1,
-	DebugGrid = 2,
+	TiledGrid = 2,
+	Stereo = 3,
+	DebugGrid = 4,
 };
 
 
@@ -111,7 +113,30 @@ enum class ScreenshotFiletype : int
 {
 	Bmp,
 	Jpeg,
-	Png
+	Png,
+	Qoi,
+	Y4m,		// all shots of a session in a single y4m video file
+};
+
+
+enum class JpegChromaSubsampling : int
+{
+	Subsampling444,		// no chroma subsampling, best quality
+	Subsampling420,		// chroma at half the resolution horizontally and vertically, smaller files
+};
+
+
+enum class LightfieldOutput : int
+{
+	SeparateShots,		// every shot is written as a separate file
+	Quilt,				// the shots are downscaled into the views of a single quilt image, for Looking Glass displays
+};
+
+
+enum class ViewLayout : int
+{
+	SideBySide,			// the views of a stereo or N-view shot next to each other
+	OverUnder,			// the views of a stereo or N-view shot stacked on top of each other
 };
 
 
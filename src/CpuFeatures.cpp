@@ -0,0 +1,109 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+#include "CpuFeatures.h"
+#include "fpng.h"
+#include <intrin.h>
+#include <immintrin.h>
+#include <string>
+
+namespace IGCS::CpuFeatures
+{
+	namespace
+	{
+		FeatureSet detectFeatures()
+		{
+			FeatureSet features;
+			int regs[4] = { 0 };
+			__cpuid(regs, 0);
+			const int highestFunctionId = regs[0];
+			if(highestFunctionId < 1)
+			{
+				return features;
+			}
+			__cpuid(regs, 1);
+			features.ssse3 = (regs[2] & (1 << 9)) != 0;
+			features.sse41 = features.ssse3 && (regs[2] & (1 << 19)) != 0;
+			features.pclmul = features.sse41 && (regs[2] & (1 << 1)) != 0;
+			const bool osSavesYmmRegisters = (regs[2] & (1 << 27)) != 0 && (regs[2] & (1 << 28)) != 0 && (_xgetbv(0) & 6) == 6;		// osxsave, avx and xmm/ymm state enabled
+			if(highestFunctionId >= 7 && osSavesYmmRegisters)
+			{
+				__cpuidex(regs, 7, 0);
+				features.avx2 = features.sse41 && (regs[1] & (1 << 5)) != 0;
+			}
+			return features;
+		}
+
+
+		std::string describeFeatures(const FeatureSet& features)
+		{
+			std::string description = "SSE2";
+			description += features.ssse3 ? " SSSE3" : "";
+			description += features.sse41 ? " SSE4.1" : "";
+			description += features.pclmul ? " PCLMUL" : "";
+			description += features.avx2 ? " AVX2" : "";
+			return description;
+		}
+
+
+		void initializeLibraries(const FeatureSet& features)
+		{
+			fpng::fpng_cpu_features fpngFeatures;
+			fpngFeatures.m_sse41 = features.sse41;
+			fpngFeatures.m_pclmul = features.pclmul;
+			fpngFeatures.m_avx2 = features.avx2;
+			fpng::fpng_init(fpngFeatures);
+		}
+	}
+
+
+	void initialize()
+	{
+		initializeLibraries(get());
+	}
+
+
+	const FeatureSet& get()
+	{
+		static const FeatureSet features = detectFeatures();
+		return features;
+	}
+
+
+	const char* getDescription()
+	{
+		static const std::string description = describeFeatures(get());
+		return description.c_str();
+	}
+}
@@ -0,0 +1,63 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+namespace IGCS::CpuFeatures
+{
+	/// <summary>
+	/// The instruction set extensions of the cpu the addon's kernels can use. Everything which has a SIMD variant dispatches on these, so the
+	/// whole addon uses the same features.
+	/// </summary>
+	struct FeatureSet
+	{
+		bool ssse3 = false;
+		bool sse41 = false;
+		bool pclmul = false;
+		bool avx2 = false;		// only set if the OS saves the ymm registers as well
+	};
+
+	/// <summary>
+	/// Detects the features of the cpu and hands them to the libraries which dispatch themselves, like fpng. Called once from DllMain, before
+	/// anything is encoded.
+	/// </summary>
+	void initialize();
+	/// <summary>
+	/// Returns the features detected. Detects them on first use, so it's safe to call during static initialization.
+	/// </summary>
+	const FeatureSet& get();
+	/// <summary>
+	/// Returns the names of the features detected, e.g. "SSSE3 SSE4.1 PCLMUL AVX2".
+	/// </summary>
+	const char* getDescription();
+}
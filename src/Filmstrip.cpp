@@ -0,0 +1,186 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+#include "Filmstrip.h"
+#include "Thumbnail.h"
+#include <imgui.h>
+#include <reshade.hpp>
+#include <algorithm>
+
+namespace
+{
+	constexpr uint32_t ThumbnailHeight = 96;
+}
+
+
+void Filmstrip::begin(const std::string& sessionDescription, int numberOfShots)
+{
+	std::unique_lock lock(_mutex);
+	_sessionDescription = sessionDescription;
+	_numberOfShots = numberOfShots;
+	_newThumbnails.clear();
+	_clearRequested = true;
+}
+
+
+void Filmstrip::addShot(int frameNumber, const uint8_t* data, uint32_t width, uint32_t height)
+{
+	if(nullptr == data || width == 0 || height < ThumbnailHeight)
+	{
+		return;
+	}
+	Thumbnail thumbnail;
+	thumbnail.frameNumber = frameNumber;
+	thumbnail.height = ThumbnailHeight;
+	thumbnail.width = (std::max)(1u, (uint32_t)((uint64_t)width * ThumbnailHeight / height));
+	if(!IGCS::Thumbnail::downscaleBox(data, width, height, thumbnail.width, thumbnail.height, thumbnail.pixels))
+	{
+		return;
+	}
+	std::unique_lock lock(_mutex);
+	_newThumbnails.push_back(std::move(thumbnail));
+}
+
+
+void Filmstrip::draw(reshade::api::effect_runtime* runtime)
+{
+	reshade::api::device* device = runtime->get_device();
+	std::string sessionDescription;
+	int numberOfShots = 0;
+	{
+		std::unique_lock lock(_mutex);
+		if(_clearRequested)
+		{
+			releaseTextures(device);
+			_clearRequested = false;
+		}
+		for(Thumbnail& thumbnail : _newThumbnails)
+		{
+			_thumbnails.push_back(std::move(thumbnail));
+		}
+		_newThumbnails.clear();
+		sessionDescription = _sessionDescription;
+		numberOfShots = _numberOfShots;
+	}
+	if(_thumbnails.empty())
+	{
+		return;
+	}
+	std::sort(_thumbnails.begin(), _thumbnails.end(), [](const Thumbnail& a, const Thumbnail& b) { return a.frameNumber < b.frameNumber; });
+
+	const int numberOfMissingShots = numberOfShots - (int)_thumbnails.size();
+	if(numberOfMissingShots > 0)
+	{
+		ImGui::Text("%s: %d of %d shots, %d missing.", sessionDescription.c_str(), (int)_thumbnails.size(), numberOfShots, numberOfMissingShots);
+	}
+	else
+	{
+		ImGui::Text("%s: all %d shots.", sessionDescription.c_str(), (int)_thumbnails.size());
+	}
+	const float stripHeight = ThumbnailHeight + ImGui::GetStyle().ScrollbarSize + ImGui::GetTextLineHeightWithSpacing() + 2.0f * ImGui::GetStyle().WindowPadding.y;
+	if(ImGui::BeginChild("Filmstrip", ImVec2(0.0f, stripHeight), ImGuiChildFlags_Borders, ImGuiWindowFlags_HorizontalScrollbar))
+	{
+		int expectedFrameNumber = 0;
+		for(Thumbnail& thumbnail : _thumbnails)
+		{
+			if(thumbnail.textureView.handle == 0 && !createTexture(device, thumbnail))
+			{
+				continue;
+			}
+			ImGui::BeginGroup();
+			// a gap in the frame numbers is a shot which wasn't written, so it's marked.
+			if(thumbnail.frameNumber != expectedFrameNumber)
+			{
+				ImGui::TextColored(ImVec4(1.0f, 0.3f, 0.3f, 1.0f), "%d (gap)", thumbnail.frameNumber);
+			}
+			else
+			{
+				ImGui::Text("%d", thumbnail.frameNumber);
+			}
+			ImGui::Image((ImTextureID)thumbnail.textureView.handle, ImVec2((float)thumbnail.width, (float)thumbnail.height));
+			ImGui::EndGroup();
+			ImGui::SameLine();
+			expectedFrameNumber = thumbnail.frameNumber + 1;
+		}
+	}
+	ImGui::EndChild();
+}
+
+
+void Filmstrip::releaseTextures(reshade::api::device* device)
+{
+	for(Thumbnail& thumbnail : _thumbnails)
+	{
+		if(thumbnail.textureView.handle != 0)
+		{
+			device->destroy_resource_view(thumbnail.textureView);
+		}
+		if(thumbnail.texture.handle != 0)
+		{
+			device->destroy_resource(thumbnail.texture);
+		}
+	}
+	_thumbnails.clear();
+}
+
+
+bool Filmstrip::createTexture(reshade::api::device* device, Thumbnail& thumbnail)
+{
+	if(thumbnail.pixels.empty())
+	{
+		// creating the texture failed before, no use trying again.
+		return false;
+	}
+	reshade::api::subresource_data initialData;
+	initialData.data = thumbnail.pixels.data();
+	initialData.row_pitch = thumbnail.width * 4;
+	initialData.slice_pitch = thumbnail.width * thumbnail.height * 4;
+	const reshade::api::resource_desc description(thumbnail.width, thumbnail.height, 1, 1, reshade::api::format::r8g8b8a8_unorm, 1, reshade::api::memory_heap::gpu_only, 
+												  reshade::api::resource_usage::shader_resource);
+	bool created = device->create_resource(description, &initialData, reshade::api::resource_usage::shader_resource, &thumbnail.texture);
+	if(created)
+	{
+		created = device->create_resource_view(thumbnail.texture, reshade::api::resource_usage::shader_resource, reshade::api::resource_view_desc(reshade::api::format::r8g8b8a8_unorm), 
+											   &thumbnail.textureView);
+	}
+	if(!created)
+	{
+		thumbnail.texture = { 0 };
+		thumbnail.textureView = { 0 };
+	}
+	// the texture has its own copy now.
+	thumbnail.pixels.clear();
+	thumbnail.pixels.shrink_to_fit();
+	return created;
+}
@@ -0,0 +1,89 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <cstdint>
+#include <mutex>
+#include <reshade_api.hpp>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Keeps thumbnails of the shots of the last session and shows them as a filmstrip in the overlay, so it's easy to check whether all shots
+/// were taken and look right. Thumbnails are created on the thread which adds the shot; the textures are created and drawn on the render thread.
+/// </summary>
+class Filmstrip
+{
+public:
+	Filmstrip() = default;
+	Filmstrip(const Filmstrip&) = delete;
+	Filmstrip& operator=(const Filmstrip&) = delete;
+
+	/// <summary>
+	/// Clears the filmstrip for a session of numberOfShots shots. The textures of the previous session are released the next time the
+	/// filmstrip is drawn.
+	/// </summary>
+	void begin(const std::string& sessionDescription, int numberOfShots);
+	/// <summary>
+	/// Creates the thumbnail of the RGB shot in data and adds it to the filmstrip. Can be called from any thread.
+	/// </summary>
+	void addShot(int frameNumber, const uint8_t* data, uint32_t width, uint32_t height);
+	/// <summary>
+	/// Draws the filmstrip with ImGui, if there are thumbnails. Has to be called from the overlay callback.
+	/// </summary>
+	void draw(reshade::api::effect_runtime* runtime);
+	/// <summary>
+	/// Destroys the textures of the thumbnails. Has to be called before the device of the runtime is destroyed.
+	/// </summary>
+	void releaseTextures(reshade::api::device* device);
+
+private:
+	struct Thumbnail
+	{
+		int frameNumber = 0;
+		uint32_t width = 0;
+		uint32_t height = 0;
+		std::vector<uint8_t> pixels;		// RGBA, released once the texture has been created
+		reshade::api::resource texture = { 0 };
+		reshade::api::resource_view textureView = { 0 };
+	};
+
+	bool createTexture(reshade::api::device* device, Thumbnail& thumbnail);
+
+	std::mutex _mutex;
+	std::string _sessionDescription;		// guarded by _mutex
+	int _numberOfShots = 0;					// guarded by _mutex
+	std::vector<Thumbnail> _newThumbnails;	// guarded by _mutex. Added since the last draw.
+	bool _clearRequested = false;			// guarded by _mutex
+	std::vector<Thumbnail> _thumbnails;		// only used on the render thread, sorted on frame number.
+};
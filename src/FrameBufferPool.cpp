@@ -0,0 +1,195 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+#include "FrameBufferPool.h"
+#include <algorithm>
+
+FrameBuffer::FrameBuffer(FrameBufferPool* owner, std::unique_ptr<uint8_t[]> buffer, size_t size) : _owner(owner), _buffer(std::move(buffer)), _size(size)
+{
+}
+
+
+FrameBuffer::~FrameBuffer()
+{
+	release();
+}
+
+
+FrameBuffer::FrameBuffer(FrameBuffer&& other) noexcept : _owner(other._owner), _buffer(std::move(other._buffer)), _size(other._size)
+{
+	other._owner = nullptr;
+	other._size = 0;
+}
+
+
+FrameBuffer& FrameBuffer::operator=(FrameBuffer&& other) noexcept
+{
+	if(this != &other)
+	{
+		release();
+		_owner = other._owner;
+		_buffer = std::move(other._buffer);
+		_size = other._size;
+		other._owner = nullptr;
+		other._size = 0;
+	}
+	return *this;
+}
+
+
+void FrameBuffer::release()
+{
+	if(nullptr != _owner && nullptr != _buffer)
+	{
+		_owner->giveBack(std::move(_buffer), _size);
+	}
+	_buffer.reset();
+	_owner = nullptr;
+	_size = 0;
+}
+
+
+void FrameBufferPool::prepare(int numberOfBuffers, size_t bufferSize)
+{
+	std::unique_lock lock(_poolMutex);
+	if(_bufferSize != bufferSize)
+	{
+		// resolution changed, the buffers we have are of no use anymore.
+		_freeBuffers.clear();
+		_bufferSize = bufferSize;
+	}
+	_maxNumberOfFreeBuffers = numberOfBuffers < 1 ? 1 : numberOfBuffers;
+	while((int)_freeBuffers.size() > _maxNumberOfFreeBuffers)
+	{
+		_freeBuffers.pop_back();
+	}
+	// allocate the buffers now, so the shots don't have to wait for an allocation. The ones in use come back when they're released.
+	while((int)_freeBuffers.size() + _numberOfBuffersInUse < _maxNumberOfFreeBuffers)
+	{
+		std::unique_ptr<uint8_t[]> buffer(new (std::nothrow) uint8_t[_bufferSize]);
+		if(nullptr == buffer)
+		{
+			// acquire will try again.
+			break;
+		}
+		_statistics.numberOfAllocations++;
+		_statistics.bytesAllocated += _bufferSize;
+		_freeBuffers.push_back(std::move(buffer));
+	}
+}
+
+
+FrameBuffer FrameBufferPool::acquire()
+{
+	std::unique_lock lock(_poolMutex);
+	if(_bufferSize <= 0)
+	{
+		return FrameBuffer();
+	}
+	if(!_freeBuffers.empty())
+	{
+		std::unique_ptr<uint8_t[]> buffer = std::move(_freeBuffers.back());
+		_freeBuffers.pop_back();
+		_numberOfBuffersInUse++;
+		return FrameBuffer(this, std::move(buffer), _bufferSize);
+	}
+	// no free buffer, allocate a new one. We don't need it zeroed, it's overwritten by the capture anyway.
+	std::unique_ptr<uint8_t[]> buffer(new (std::nothrow) uint8_t[_bufferSize]);
+	if(nullptr == buffer)
+	{
+		return FrameBuffer();
+	}
+	_statistics.numberOfAllocations++;
+	_statistics.bytesAllocated += _bufferSize;
+	_numberOfBuffersInUse++;
+	return FrameBuffer(this, std::move(buffer), _bufferSize);
+}
+
+
+void FrameBufferPool::recordStoredShot()
+{
+	std::unique_lock lock(_poolMutex);
+	_statistics.numberOfShotsStored++;
+}
+
+
+void FrameBufferPool::trim(int numberOfBuffers)
+{
+	std::unique_lock lock(_poolMutex);
+	_maxNumberOfFreeBuffers = numberOfBuffers < 0 ? 0 : numberOfBuffers;
+	while((int)_freeBuffers.size() > _maxNumberOfFreeBuffers)
+	{
+		_freeBuffers.pop_back();
+	}
+}
+
+
+void FrameBufferPool::clear()
+{
+	std::unique_lock lock(_poolMutex);
+	_freeBuffers.clear();
+	_bufferSize = 0;
+	_maxNumberOfFreeBuffers = 0;
+}
+
+
+FrameBufferPoolStatistics FrameBufferPool::getStatistics()
+{
+	std::unique_lock lock(_poolMutex);
+	FrameBufferPoolStatistics toReturn = _statistics;
+	// every stored shot needed a buffer, the ones which weren't allocated for it were reused.
+	toReturn.numberOfReuses = (std::max)(toReturn.numberOfShotsStored - toReturn.numberOfAllocations, 0);
+	toReturn.bytesReused = (uint64_t)toReturn.numberOfReuses * _bufferSize;
+	return toReturn;
+}
+
+
+void FrameBufferPool::resetStatistics()
+{
+	std::unique_lock lock(_poolMutex);
+	_statistics = FrameBufferPoolStatistics();
+}
+
+
+void FrameBufferPool::giveBack(std::unique_ptr<uint8_t[]> buffer, size_t size)
+{
+	std::unique_lock lock(_poolMutex);
+	_numberOfBuffersInUse--;
+	if(size != _bufferSize || (int)_freeBuffers.size() >= _maxNumberOfFreeBuffers)
+	{
+		// either from before a resize/clear or the pool is full: let it go.
+		return;
+	}
+	_freeBuffers.push_back(std::move(buffer));
+}
@@ -0,0 +1,134 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class FrameBufferPool;
+
+/// <summary>
+/// Move-only handle to a buffer which holds a grabbed frame. The buffer is owned by the handle while it's alive and is handed back to the
+/// pool it came from when the handle is destroyed, so it can be reused for the next shot.
+/// </summary>
+class FrameBuffer
+{
+public:
+	FrameBuffer() = default;
+	~FrameBuffer();
+	FrameBuffer(const FrameBuffer&) = delete;
+	FrameBuffer& operator=(const FrameBuffer&) = delete;
+	FrameBuffer(FrameBuffer&& other) noexcept;
+	FrameBuffer& operator=(FrameBuffer&& other) noexcept;
+
+	uint8_t* data() { return _buffer.get(); }
+	const uint8_t* data() const { return _buffer.get(); }
+	size_t size() const { return _size; }
+	bool isValid() const { return nullptr != _buffer; }
+	/// <summary>
+	/// Hands the buffer back to the pool it came from. The handle is invalid afterwards.
+	/// </summary>
+	void release();
+
+private:
+	friend class FrameBufferPool;
+	FrameBuffer(FrameBufferPool* owner, std::unique_ptr<uint8_t[]> buffer, size_t size);
+
+	FrameBufferPool* _owner = nullptr;
+	std::unique_ptr<uint8_t[]> _buffer;
+	size_t _size = 0;
+};
+
+
+struct FrameBufferPoolStatistics
+{
+	int numberOfAllocations = 0;			// buffers which had to be allocated
+	int numberOfShotsStored = 0;
+	int numberOfReuses = 0;					// stored shots which didn't need a buffer of their own
+	uint64_t bytesAllocated = 0;
+	uint64_t bytesReused = 0;				// bytes which would have been allocated without the pool
+};
+
+
+/// <summary>
+/// Pool of equally sized frame buffers. It's sized at the start of a session to the number of buffers it keeps around and allocates them
+/// right away. When more buffers are acquired than that, the extra ones are allocated on demand and released when they're handed back.
+/// The buffers kept around are reused, also by later sessions, till the resolution changes or the pool is trimmed or cleared. Thread safe.
+/// </summary>
+class FrameBufferPool
+{
+public:
+	FrameBufferPool() = default;
+	~FrameBufferPool() = default;
+	FrameBufferPool(const FrameBufferPool&) = delete;
+	FrameBufferPool& operator=(const FrameBufferPool&) = delete;
+
+	/// <summary>
+	/// Sizes the pool to numberOfBuffers buffers of bufferSize bytes and allocates the ones it doesn't have yet. Buffers of a different size
+	/// are released. Cheap if the pool already has the specified size, so it can be called for every shot.
+	/// </summary>
+	void prepare(int numberOfBuffers, size_t bufferSize);
+	/// <summary>
+	/// Returns a buffer of the size specified in prepare. Reuses a free buffer if there's one, otherwise a new buffer is allocated.
+	/// The contents of the buffer are undefined.
+	/// </summary>
+	FrameBuffer acquire();
+	/// <summary>
+	/// Records that a buffer handed out by acquire holds a shot which is kept, for the statistics. Buffers of frames which are grabbed
+	/// again, e.g. because they haven't settled yet, aren't shots.
+	/// </summary>
+	void recordStoredShot();
+	/// <summary>
+	/// Releases free buffers till at most numberOfBuffers buffers are kept around, and makes that the pool's size.
+	/// </summary>
+	void trim(int numberOfBuffers);
+	/// <summary>
+	/// Releases all free buffers and resets the pool's size. Buffers still in use are released when their handles are destroyed.
+	/// </summary>
+	void clear();
+	FrameBufferPoolStatistics getStatistics();
+	void resetStatistics();
+
+private:
+	friend class FrameBuffer;
+	void giveBack(std::unique_ptr<uint8_t[]> buffer, size_t size);
+
+	std::mutex _poolMutex;
+	std::vector<std::unique_ptr<uint8_t[]>> _freeBuffers;		// guarded by _poolMutex
+	size_t _bufferSize = 0;
+	int _maxNumberOfFreeBuffers = 0;
+	int _numberOfBuffersInUse = 0;			// handed out by acquire and not given back yet
+	FrameBufferPoolStatistics _statistics;
+};
@@ -0,0 +1,156 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+#include "FrameSignature.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <emmintrin.h>
+
+namespace IGCS::FrameSignature
+{
+	// the distance between the pixels sampled, horizontally and vertically.
+	constexpr uint32_t SampleStep = 4;
+	// the distance between the blocks hashed by calculateSampleHash, in bytes. One block per cache line.
+	constexpr size_t HashBlockStep = 64;
+
+	// Multiplies both 64 bit lanes with a 32 bit prime and mixes in the key, so the hash depends on the order of the rows. This is the scramble step of XXH3.
+	static __m128i scrambleLanes(__m128i lanes, __m128i key)
+	{
+		const __m128i prime = _mm_set1_epi32((int)0x9E3779B1);
+		lanes = _mm_xor_si128(_mm_xor_si128(lanes, _mm_srli_epi64(lanes, 47)), key);
+		const __m128i productLow = _mm_mul_epu32(lanes, prime);
+		const __m128i productHigh = _mm_mul_epu32(_mm_srli_epi64(lanes, 32), prime);
+		return _mm_add_epi64(productLow, _mm_slli_epi64(productHigh, 32));
+	}
+
+
+	static uint64_t avalanche(uint64_t value)
+	{
+		value ^= value >> 33;
+		value *= 0xFF51AFD7ED558CCDull;
+		value ^= value >> 33;
+		value *= 0xC4CEB9FE1A85EC53ull;
+		return value ^ (value >> 33);
+	}
+
+
+	void calculateLumaSignature(const uint8_t* data, uint32_t width, uint32_t height, size_t rowPitch, bool isBgra, std::vector<float>& signature)
+	{
+		signature.clear();
+		if(nullptr == data || width == 0 || height == 0)
+		{
+			return;
+		}
+		signature.resize(SignatureWidth * SignatureHeight);
+		const uint32_t redOffset = isBgra ? 2 : 0;
+		const uint32_t blueOffset = isBgra ? 0 : 2;
+		uint32_t lumaSums[SignatureWidth];
+		uint32_t sampleCounts[SignatureWidth];
+		for(uint32_t cellY = 0; cellY < SignatureHeight; cellY++)
+		{
+			// in frames smaller than the grid, neighbouring cells cover the same pixel.
+			const uint32_t firstRow = cellY * height / SignatureHeight;
+			const uint32_t endRow = (std::max)(firstRow + 1, (cellY + 1) * height / SignatureHeight);
+			std::fill(std::begin(lumaSums), std::end(lumaSums), 0);
+			std::fill(std::begin(sampleCounts), std::end(sampleCounts), 0);
+			for(uint32_t y = firstRow; y < endRow; y += SampleStep)
+			{
+				const uint8_t* row = data + y * rowPitch;
+				for(uint32_t cellX = 0; cellX < SignatureWidth; cellX++)
+				{
+					const uint32_t firstColumn = cellX * width / SignatureWidth;
+					const uint32_t endColumn = (std::max)(firstColumn + 1, (cellX + 1) * width / SignatureWidth);
+					for(uint32_t x = firstColumn; x < endColumn; x += SampleStep)
+					{
+						const uint8_t* pixel = row + x * 4;
+						// Rec.709 luma weights, in 8.8 fixed point.
+						lumaSums[cellX] += (54 * pixel[redOffset] + 183 * pixel[1] + 19 * pixel[blueOffset]) >> 8;
+						sampleCounts[cellX]++;
+					}
+				}
+			}
+			for(uint32_t cellX = 0; cellX < SignatureWidth; cellX++)
+			{
+				signature[cellY * SignatureWidth + cellX] = (float)lumaSums[cellX] / (float)sampleCounts[cellX];
+			}
+		}
+	}
+
+
+	float getAverageDifference(const std::vector<float>& signature1, const std::vector<float>& signature2)
+	{
+		if(signature1.empty() || signature1.size() != signature2.size())
+		{
+			return FLT_MAX;
+		}
+		double differenceSum = 0.0;
+		for(size_t i = 0; i < signature1.size(); i++)
+		{
+			differenceSum += std::fabs(signature1[i] - signature2[i]);
+		}
+		return (float)(differenceSum / (double)signature1.size());
+	}
+
+
+	uint64_t calculateSampleHash(const uint8_t* data, size_t rowSize, uint32_t height)
+	{
+		if(nullptr == data || rowSize < 16)
+		{
+			return 0;
+		}
+		const __m128i key = _mm_set_epi64x(0x165667B19E3779F9ll, 0x27D4EB2F165667C5ll);
+		// added to the key after every block, so the same block at another spot in the row adds something else.
+		const __m128i keyStep = _mm_set1_epi64x(0x9E3779B97F4A7C15ll);
+		__m128i accumulator = _mm_set_epi64x(0x61C8864E7A143579ll, 0x85EBCA77C2B2AE63ll);
+		for(uint32_t y = 0; y < height; y += SampleStep)
+		{
+			const uint8_t* row = data + (size_t)y * rowSize;
+			__m128i blockKey = key;
+			for(size_t x = 0; x + 16 <= rowSize; x += HashBlockStep)
+			{
+				// the accumulate step of XXH3: the 32x32 bit product of the halves of each keyed lane, plus the block with its lanes swapped.
+				const __m128i block = _mm_loadu_si128((const __m128i*)(row + x));
+				const __m128i keyedBlock = _mm_xor_si128(block, blockKey);
+				const __m128i product = _mm_mul_epu32(keyedBlock, _mm_srli_epi64(keyedBlock, 32));
+				accumulator = _mm_add_epi64(accumulator, _mm_add_epi64(product, _mm_shuffle_epi32(block, _MM_SHUFFLE(1, 0, 3, 2))));
+				blockKey = _mm_add_epi64(blockKey, keyStep);
+			}
+			accumulator = scrambleLanes(accumulator, key);
+		}
+		alignas(16) uint64_t lanes[2];
+		_mm_store_si128((__m128i*)lanes, accumulator);
+		return avalanche(lanes[0] ^ avalanche(lanes[1] ^ ((uint64_t)rowSize << 32 | height)));
+	}
+}
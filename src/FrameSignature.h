@@ -0,0 +1,61 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <cstdint>
+#include <vector>
+
+namespace IGCS::FrameSignature
+{
+	// the signature is the average luma of every cell of a grid of this size over the frame.
+	constexpr uint32_t SignatureWidth = 64;
+	constexpr uint32_t SignatureHeight = 36;
+
+	/// <summary>
+	/// Calculates a small luma signature of the frame in data, which has height rows of rowPitch bytes with 4 bytes per pixel, RGBA or BGRA,
+	/// into signature. Only every 4th pixel on every 4th row is read, so it's cheap enough to do every frame. Frames which look the same have
+	/// signatures which are close together. Every cell covers at least one pixel, also if the frame is smaller than the grid. If there's no
+	/// frame the signature is left empty, so it can't be compared with anything.
+	/// </summary>
+	void calculateLumaSignature(const uint8_t* data, uint32_t width, uint32_t height, size_t rowPitch, bool isBgra, std::vector<float>& signature);
+	/// <summary>
+	/// Returns the average absolute difference between the cells of the two signatures, in luma units (0-255). Returns FLT_MAX if the signatures
+	/// can't be compared.
+	/// </summary>
+	float getAverageDifference(const std::vector<float>& signature1, const std::vector<float>& signature2);
+	/// <summary>
+	/// Calculates a 64 bit hash over a sparse grid of the frame in data, which has height rows of rowSize bytes. Only the first 16 bytes of every
+	/// 64 bytes of every 4th row are read. Frames which are byte for byte the same, like a frame the game presented twice, have the same hash.
+	/// </summary>
+	uint64_t calculateSampleHash(const uint8_t* data, size_t rowSize, uint32_t height);
+}
@@ -0,0 +1,138 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+#include "FrameSignatureReadback.h"
+#include "FrameSignature.h"
+#include <algorithm>
+
+namespace
+{
+	/// <summary>
+	/// Returns true if the format has 8 bit RGBA or BGRA pixels, which are the only formats the signature can be calculated from directly.
+	/// </summary>
+	bool hasEightBitChannels(reshade::api::format format, bool& isBgra)
+	{
+		switch(reshade::api::format_to_typeless(format))
+		{
+		case reshade::api::format::r8g8b8a8_typeless:
+			isBgra = false;
+			return true;
+		case reshade::api::format::b8g8r8a8_typeless:
+		case reshade::api::format::b8g8r8x8_typeless:
+			isBgra = true;
+			return true;
+		default:
+			return false;
+		}
+	}
+}
+
+
+bool FrameSignatureReadback::calculateSignature(reshade::api::effect_runtime* runtime, std::vector<float>& signature)
+{
+	reshade::api::device* device = runtime->get_device();
+	reshade::api::command_queue* queue = runtime->get_command_queue();
+	const reshade::api::resource backBuffer = runtime->get_current_back_buffer();
+	if(nullptr == device || nullptr == queue || nullptr == queue->get_immediate_command_list() || backBuffer.handle == 0)
+	{
+		return false;
+	}
+	const reshade::api::resource_desc backBufferDescription = device->get_resource_desc(backBuffer);
+	bool isBgra = false;
+	if(backBufferDescription.texture.samples > 1 || !hasEightBitChannels(backBufferDescription.texture.format, isBgra))
+	{
+		return false;
+	}
+	const uint32_t regionWidth = (std::min)(MaxRegionWidth, backBufferDescription.texture.width);
+	const uint32_t regionHeight = (std::min)(MaxRegionHeight, backBufferDescription.texture.height);
+	if(regionWidth == 0 || regionHeight == 0 || !prepareTexture(device, regionWidth, regionHeight, backBufferDescription.texture.format))
+	{
+		return false;
+	}
+
+	// the region in the center of the frame, where the camera step is most visible.
+	const uint32_t left = (backBufferDescription.texture.width - regionWidth) / 2;
+	const uint32_t top = (backBufferDescription.texture.height - regionHeight) / 2;
+	const reshade::api::subresource_box region = { left, top, 0, left + regionWidth, top + regionHeight, 1 };
+	reshade::api::command_list* commandList = queue->get_immediate_command_list();
+	commandList->barrier(backBuffer, reshade::api::resource_usage::present, reshade::api::resource_usage::copy_source);
+	commandList->copy_texture_region(backBuffer, 0, &region, _texture, 0, nullptr);
+	commandList->barrier(backBuffer, reshade::api::resource_usage::copy_source, reshade::api::resource_usage::present);
+	// the copy is tiny compared to a full capture, but we still have to wait for it.
+	queue->flush_immediate_command_list();
+	queue->wait_idle();
+
+	reshade::api::subresource_data mappedRegion;
+	if(!device->map_texture_region(_texture, 0, nullptr, reshade::api::map_access::read_only, &mappedRegion))
+	{
+		return false;
+	}
+	IGCS::FrameSignature::calculateLumaSignature(static_cast<const uint8_t*>(mappedRegion.data), regionWidth, regionHeight, mappedRegion.row_pitch, isBgra, signature);
+	device->unmap_texture_region(_texture, 0);
+	return true;
+}
+
+
+void FrameSignatureReadback::releaseTexture(reshade::api::device* device)
+{
+	if(_texture.handle != 0)
+	{
+		device->destroy_resource(_texture);
+	}
+	_texture = { 0 };
+	_textureWidth = 0;
+	_textureHeight = 0;
+	_textureFormat = reshade::api::format::unknown;
+}
+
+
+bool FrameSignatureReadback::prepareTexture(reshade::api::device* device, uint32_t width, uint32_t height, reshade::api::format format)
+{
+	if(_texture.handle != 0 && _textureWidth == width && _textureHeight == height && _textureFormat == format)
+	{
+		return true;
+	}
+	// the resolution or format changed. The previous copy has been waited for, so the texture isn't in use anymore.
+	releaseTexture(device);
+	const reshade::api::resource_desc description(width, height, 1, 1, format, 1, reshade::api::memory_heap::gpu_to_cpu, reshade::api::resource_usage::copy_dest);
+	if(!device->create_resource(description, nullptr, reshade::api::resource_usage::copy_dest, &_texture))
+	{
+		_texture = { 0 };
+		return false;
+	}
+	_textureWidth = width;
+	_textureHeight = height;
+	_textureFormat = format;
+	return true;
+}
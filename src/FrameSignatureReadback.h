@@ -0,0 +1,73 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <cstdint>
+#include <reshade_api.hpp>
+#include <vector>
+
+/// <summary>
+/// Calculates the luma signature of the current back buffer from a region of it, so checking whether a frame has settled doesn't need the whole
+/// frame read back to the cpu like capture_screenshot does. The region, at most MaxRegionWidth x MaxRegionHeight pixels around the center of the
+/// frame, is copied into a small cpu readable texture. Only used on the render thread.
+/// </summary>
+class FrameSignatureReadback
+{
+public:
+	static constexpr uint32_t MaxRegionWidth = 640;
+	static constexpr uint32_t MaxRegionHeight = 360;
+
+	FrameSignatureReadback() = default;
+	FrameSignatureReadback(const FrameSignatureReadback&) = delete;
+	FrameSignatureReadback& operator=(const FrameSignatureReadback&) = delete;
+
+	/// <summary>
+	/// Calculates the luma signature of the region of the current back buffer of the runtime into signature. Has to be called from the overlay
+	/// callback, like capture_screenshot.
+	/// </summary>
+	/// <returns>true if the signature was calculated, false if the back buffer can't be read this way, e.g. because it has a 10 bit or HDR
+	/// format, in which case the caller has to calculate the signature from the captured frame</returns>
+	bool calculateSignature(reshade::api::effect_runtime* runtime, std::vector<float>& signature);
+	/// <summary>
+	/// Destroys the texture the region is copied into. Has to be called before the device of the runtime is destroyed.
+	/// </summary>
+	void releaseTexture(reshade::api::device* device);
+
+private:
+	bool prepareTexture(reshade::api::device* device, uint32_t width, uint32_t height, reshade::api::format format);
+
+	reshade::api::resource _texture = { 0 };
+	uint32_t _textureWidth = 0;
+	uint32_t _textureHeight = 0;
+	reshade::api::format _textureFormat = reshade::api::format::unknown;
+};
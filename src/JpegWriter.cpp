@@ -0,0 +1,155 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+#include "JpegWriter.h"
+#include <algorithm>
+#include <thread>
+#include "CpuFeatures.h"
+#include "std_image_write.h"
+
+namespace IGCS::JpegWriter
+{
+	namespace
+	{
+		// The minimum number of MCU rows per band, so we don't start threads for bands which are encoded in less time than it takes to start a thread.
+		constexpr int MinimumNumberOfMcuRowsPerBand = 8;
+
+		void appendToVector(void* context, void* data, int size)
+		{
+			auto destination = static_cast<std::vector<uint8_t>*>(context);
+			const auto bytes = static_cast<const uint8_t*>(data);
+			destination->insert(destination->end(), bytes, bytes + size);
+		}
+
+		struct Band
+		{
+			int firstMcuRow = 0;
+			int endMcuRow = 0;
+			std::vector<uint8_t> encodedData;
+			bool succeeded = false;
+		};
+
+		void encodeBand(const stbi_write_jpg_params* params, const uint8_t* data, Band& band)
+		{
+			// rough estimate so we don't reallocate much while encoding. JPEG at high quality is roughly 1/4th of the raw size.
+			const size_t numberOfPixelsInBand = (size_t)params->width * (size_t)(band.endMcuRow - band.firstMcuRow) * params->mcu_size;
+			band.encodedData.reserve(numberOfPixelsInBand * params->comp / 4);
+			band.succeeded = stbi_write_jpg_mcu_rows_to_func(&appendToVector, &band.encodedData, params, data, band.firstMcuRow, band.endMcuRow) != 0;
+		}
+	}
+
+
+	int getSimdLevel()
+	{
+		// stb can't check the cpu itself, so it defaults to SSE2.
+		static const int simdLevel = CpuFeatures::get().avx2 ? 2 : 1;
+		return simdLevel;
+	}
+
+
+	const char* getSimdLevelName(int simdLevel)
+	{
+		switch(simdLevel)
+		{
+		case 0:
+			return "Scalar";
+		case 1:
+			return "SSE2";
+		default:
+			return "AVX2";
+		}
+	}
+
+
+	bool encodeToMemory(std::vector<uint8_t>& destination, const uint8_t* data, int width, int height, int numberOfChannels, int quality,
+						JpegChromaSubsampling subsampling, int maxNumberOfThreads)
+	{
+		destination.clear();
+		if(nullptr == data)
+		{
+			return false;
+		}
+		stbi_write_jpg_params params;
+		if(!stbi_write_jpg_init_params(&params, width, height, numberOfChannels, quality, subsampling == JpegChromaSubsampling::Subsampling420 ? 1 : 0))
+		{
+			return false;
+		}
+		params.simd_level = getSimdLevel();
+
+		int numberOfBands = maxNumberOfThreads > 0 ? maxNumberOfThreads : (int)std::thread::hardware_concurrency();
+		numberOfBands = std::clamp(std::min(numberOfBands, params.num_mcu_rows / MinimumNumberOfMcuRowsPerBand), 1, params.num_mcu_rows);
+
+		std::vector<Band> bands(numberOfBands);
+		const int mcuRowsPerBand = params.num_mcu_rows / numberOfBands;
+		const int extraMcuRows = params.num_mcu_rows % numberOfBands;
+		int firstMcuRow = 0;
+		for(int i = 0; i < numberOfBands; i++)
+		{
+			bands[i].firstMcuRow = firstMcuRow;
+			bands[i].endMcuRow = firstMcuRow + mcuRowsPerBand + (i < extraMcuRows ? 1 : 0);
+			firstMcuRow = bands[i].endMcuRow;
+		}
+
+		// Band 0 is encoded on the calling thread.
+		std::vector<std::thread> threads;
+		threads.reserve(numberOfBands - 1);
+		for(int i = 1; i < numberOfBands; i++)
+		{
+			threads.emplace_back(encodeBand, &params, data, std::ref(bands[i]));
+		}
+		encodeBand(&params, data, bands[0]);
+		for(auto& thread : threads)
+		{
+			thread.join();
+		}
+
+		size_t totalSize = 1024;		// headers and end marker
+		for(const auto& band : bands)
+		{
+			if(!band.succeeded)
+			{
+				return false;
+			}
+			totalSize += band.encodedData.size();
+		}
+		destination.reserve(totalSize);
+		stbi_write_jpg_headers_to_func(&appendToVector, &destination, &params);
+		for(const auto& band : bands)
+		{
+			destination.insert(destination.end(), band.encodedData.begin(), band.encodedData.end());
+		}
+		stbi_write_jpg_end_to_func(&appendToVector, &destination);
+		return true;
+	}
+}
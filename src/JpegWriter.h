@@ -0,0 +1,60 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "ConstantsEnums.h"
+
+namespace IGCS::JpegWriter
+{
+	/// <summary>
+	/// Encodes the image in data as a JPEG file in destination. The image is split into bands of MCU rows which are encoded in parallel
+	/// on up to maxNumberOfThreads threads (0: one per hardware thread). Every MCU row is a restart interval, so the bands are joined
+	/// with RST markers and the result is a regular baseline JPEG file every decoder can read.
+	/// </summary>
+	/// <param name="destination">receives the encoded file. Existing contents are replaced</param>
+	/// <param name="data">the pixels, top to bottom, numberOfChannels bytes per pixel, rows aren't padded</param>
+	/// <param name="quality">1-100</param>
+	/// <returns>true if the image was encoded, false otherwise</returns>
+	bool encodeToMemory(std::vector<uint8_t>& destination, const uint8_t* data, int width, int height, int numberOfChannels, int quality,
+						JpegChromaSubsampling subsampling, int maxNumberOfThreads = 0);
+	/// <summary>
+	/// Returns the SIMD level used for the color conversion, DCT and quantization kernels of the encoder: 0 for scalar, 1 for SSE2, 2 for AVX2.
+	/// </summary>
+	int getSimdLevel();
+	/// <summary>
+	/// Returns the name of the given SIMD level, e.g. "AVX2".
+	/// </summary>
+	const char* getSimdLevelName(int simdLevel);
+}
@@ -0,0 +1,206 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+#include "LightfieldDeltaStore.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include "Qoi.h"
+
+namespace
+{
+	// the shift search compares the green channel of every n-th pixel on every n-th row, which is plenty to find a global shift.
+	constexpr uint32_t ShiftSearchRowStep = 8;
+	constexpr uint32_t ShiftSearchPixelStep = 2;
+
+	inline uint32_t clampColumn(int64_t column, uint32_t width)
+	{
+		return column < 0 ? 0 : (column >= (int64_t)width ? width - 1 : (uint32_t)column);
+	}
+}
+
+
+void LightfieldDeltaStore::begin(uint32_t width, uint32_t height, int maxShift)
+{
+	clear();
+	_width = width;
+	_height = height;
+	// a shift of more than half the width leaves too little overlap to mean anything.
+	_maxShift = std::clamp(maxShift, 0, (int)(width / 2));
+}
+
+
+bool LightfieldDeltaStore::addFrame(const uint8_t* data)
+{
+	if(nullptr == data || _width == 0 || _height == 0)
+	{
+		return false;
+	}
+	const size_t frameSize = getFrameSize();
+	StoredFrame storedFrame;
+	if(_frames.empty())
+	{
+		if(!IGCS::Qoi::encodeToMemory(storedFrame.compressedData, data, _width, _height, 3))
+		{
+			return false;
+		}
+	}
+	else
+	{
+		storedFrame.shift = findBestShift(data);
+		_residual.resize(frameSize);
+		const size_t rowSize = (size_t)_width * 3;
+		for(uint32_t y = 0; y < _height; ++y)
+		{
+			const uint8_t* currentRow = data + y * rowSize;
+			const uint8_t* referenceRow = _reference.data() + y * rowSize;
+			uint8_t* residualRow = _residual.data() + y * rowSize;
+			for(uint32_t x = 0; x < _width; ++x)
+			{
+				// modulo 256, so it's reversible for every value
+				const uint8_t* predicted = referenceRow + clampColumn((int64_t)x + storedFrame.shift, _width) * 3;
+				residualRow[x * 3 + 0] = (uint8_t)(currentRow[x * 3 + 0] - predicted[0]);
+				residualRow[x * 3 + 1] = (uint8_t)(currentRow[x * 3 + 1] - predicted[1]);
+				residualRow[x * 3 + 2] = (uint8_t)(currentRow[x * 3 + 2] - predicted[2]);
+			}
+		}
+		if(!IGCS::Qoi::encodeToMemory(storedFrame.compressedData, _residual.data(), _width, _height, 3))
+		{
+			return false;
+		}
+	}
+	storedFrame.compressedData.shrink_to_fit();
+	_frames.push_back(std::move(storedFrame));
+	_reference.assign(data, data + frameSize);
+	return true;
+}
+
+
+bool LightfieldDeltaStore::reconstructFrame(int index, const std::vector<uint8_t>& previousFrame, std::vector<uint8_t>& frame) const
+{
+	if(index < 0 || index >= (int)_frames.size())
+	{
+		return false;
+	}
+	const size_t frameSize = getFrameSize();
+	const StoredFrame& storedFrame = _frames[index];
+	int width = 0;
+	int height = 0;
+	if(!IGCS::Qoi::decode(storedFrame.compressedData.data(), storedFrame.compressedData.size(), frame, width, height, 3) || frame.size() != frameSize)
+	{
+		return false;
+	}
+	if(index == 0)
+	{
+		// keyframe
+		return true;
+	}
+	if(previousFrame.size() != frameSize)
+	{
+		return false;
+	}
+	// frame contains the residual, add the prediction.
+	const size_t rowSize = (size_t)_width * 3;
+	for(uint32_t y = 0; y < _height; ++y)
+	{
+		const uint8_t* referenceRow = previousFrame.data() + y * rowSize;
+		uint8_t* row = frame.data() + y * rowSize;
+		for(uint32_t x = 0; x < _width; ++x)
+		{
+			const uint8_t* predicted = referenceRow + clampColumn((int64_t)x + storedFrame.shift, _width) * 3;
+			row[x * 3 + 0] = (uint8_t)(row[x * 3 + 0] + predicted[0]);
+			row[x * 3 + 1] = (uint8_t)(row[x * 3 + 1] + predicted[1]);
+			row[x * 3 + 2] = (uint8_t)(row[x * 3 + 2] + predicted[2]);
+		}
+	}
+	return true;
+}
+
+
+void LightfieldDeltaStore::clear()
+{
+	_frames.clear();
+	_frames.shrink_to_fit();
+	_reference.clear();
+	_reference.shrink_to_fit();
+	_residual.clear();
+	_residual.shrink_to_fit();
+}
+
+
+size_t LightfieldDeltaStore::getStoredSize() const
+{
+	size_t storedSize = 0;
+	for(const StoredFrame& storedFrame : _frames)
+	{
+		storedSize += storedFrame.compressedData.size();
+	}
+	return storedSize;
+}
+
+
+int LightfieldDeltaStore::findBestShift(const uint8_t* data) const
+{
+	if(_maxShift <= 0)
+	{
+		return 0;
+	}
+	// only compare the columns which are inside the previous frame for every shift, so every shift is measured over the same pixels.
+	const uint32_t firstColumn = (uint32_t)_maxShift;
+	const uint32_t endColumn = _width - (uint32_t)_maxShift;
+	const size_t rowSize = (size_t)_width * 3;
+	int bestShift = 0;
+	uint64_t bestDifference = UINT64_MAX;
+	// try the shifts from 0 outwards, so with equal matches the smallest shift wins.
+	for(int i = 0; i <= 2 * _maxShift; ++i)
+	{
+		const int shift = (i & 1) ? -((i + 1) / 2) : (i / 2);
+		uint64_t difference = 0;
+		for(uint32_t y = 0; y < _height && difference < bestDifference; y += ShiftSearchRowStep)
+		{
+			const uint8_t* currentRow = data + y * rowSize + 1;
+			const uint8_t* referenceRow = _reference.data() + y * rowSize + 1;
+			for(uint32_t x = firstColumn; x < endColumn; x += ShiftSearchPixelStep)
+			{
+				difference += std::abs((int)currentRow[x * 3] - (int)referenceRow[(x + shift) * 3]);
+			}
+		}
+		if(difference < bestDifference)
+		{
+			bestDifference = difference;
+			bestShift = shift;
+		}
+	}
+	return bestShift;
+}
@@ -0,0 +1,97 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/// <summary>
+/// Stores the frames of a lightfield session as a keyframe plus per-frame residuals. The frames of a lightfield are shot along a rail, so a
+/// frame is mostly the previous frame shifted horizontally. Every frame is predicted from the previous frame, shifted by the horizontal offset
+/// which matches best, and only the difference with that prediction is kept, QOI compressed. The residuals are mostly zeros, so this takes a
+/// fraction of the memory of the raw frames. Lossless: the frames are reconstructed bit for bit. Not thread safe.
+/// </summary>
+class LightfieldDeltaStore
+{
+public:
+	LightfieldDeltaStore() = default;
+	LightfieldDeltaStore(const LightfieldDeltaStore&) = delete;
+	LightfieldDeltaStore& operator=(const LightfieldDeltaStore&) = delete;
+
+	/// <summary>
+	/// Clears the store and prepares it for RGB frames of the size specified.
+	/// </summary>
+	/// <param name="maxShift">the maximum horizontal shift in pixels searched to align a frame with the previous frame. 0 disables the search</param>
+	void begin(uint32_t width, uint32_t height, int maxShift);
+	/// <summary>
+	/// Adds the RGB frame in data as the next frame. The data is copied.
+	/// </summary>
+	/// <returns>true if the frame was stored, false otherwise</returns>
+	bool addFrame(const uint8_t* data);
+	/// <summary>
+	/// Reconstructs the frame with the index specified into frame. For index > 0, previousFrame has to contain the reconstructed frame index-1,
+	/// so the frames have to be reconstructed in order.
+	/// </summary>
+	/// <returns>true if the frame was reconstructed, false otherwise</returns>
+	bool reconstructFrame(int index, const std::vector<uint8_t>& previousFrame, std::vector<uint8_t>& frame) const;
+	/// <summary>
+	/// Releases all stored frames.
+	/// </summary>
+	void clear();
+	int getNumberOfFrames() const { return (int)_frames.size(); }
+	/// <summary>
+	/// Returns the number of bytes used by the stored frames, without the reference frame kept for the next frame.
+	/// </summary>
+	size_t getStoredSize() const;
+	size_t getFrameSize() const { return (size_t)_width * _height * 3; }
+
+private:
+	struct StoredFrame
+	{
+		int shift = 0;						// the prediction of pixel x is pixel x + shift of the previous frame. Unused for the keyframe.
+		std::vector<uint8_t> compressedData;	// QOI compressed keyframe or residual
+	};
+
+	/// <summary>
+	/// Returns the horizontal shift for which the previous frame matches the frame in data best, measured on a subset of the pixels.
+	/// </summary>
+	int findBestShift(const uint8_t* data) const;
+
+	uint32_t _width = 0;
+	uint32_t _height = 0;
+	int _maxShift = 0;
+	std::vector<StoredFrame> _frames;
+	std::vector<uint8_t> _reference;		// copy of the last frame added, the prediction source for the next frame.
+	std::vector<uint8_t> _residual;			// scratch buffer
+};
@@ -0,0 +1,76 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+#include "LightfieldIndex.h"
+#include "Utils.h"
+#include <algorithm>
+#include <cstdio>
+
+namespace IGCS::LightfieldIndex
+{
+	bool writeIndexFile(const std::string& filename, const LightfieldLayout& layout, std::vector<LightfieldView> views)
+	{
+		FILE* indexFile;
+		if(fopen_s(&indexFile, filename.c_str(), "w") != 0)
+		{
+			return false;
+		}
+		// renderers look views up by grid position, not by the order in which they were taken.
+		std::sort(views.begin(), views.end(), [](const LightfieldView& a, const LightfieldView& b)
+				  {
+					  return a.row != b.row ? a.row < b.row : a.column < b.column;
+				  });
+		bool succeeded = fprintf(indexFile, "{\n\t\"columns\": %d,\n\t\"rows\": %d,\n\t\"horizontalDistance\": %g,\n\t\"verticalDistance\": %g,\n\t\"viewWidth\": %u,\n\t\"viewHeight\": %u,\n",
+								 layout.numberOfColumns, layout.numberOfRows, layout.horizontalDistanceBetweenViews, layout.verticalDistanceBetweenViews,
+								 layout.viewWidth, layout.viewHeight) > 0;
+		if(!layout.container.empty())
+		{
+			succeeded &= fprintf(indexFile, "\t\"container\": %s,\n", IGCS::Utils::toJsonString(layout.container).c_str()) > 0;
+		}
+		succeeded &= fprintf(indexFile, "\t\"views\": [\n") > 0;
+		for(size_t i = 0; i < views.size(); i++)
+		{
+			const LightfieldView& view = views[i];
+			succeeded &= fprintf(indexFile, "\t\t{ \"row\": %d, \"column\": %d, \"frame\": %d, \"x\": %g, \"y\": %g", view.row, view.column, view.frameNumber, view.x, view.y) > 0;
+			if(!view.file.empty())
+			{
+				succeeded &= fprintf(indexFile, ", \"file\": %s", IGCS::Utils::toJsonString(view.file).c_str()) > 0;
+			}
+			succeeded &= fprintf(indexFile, " }%s\n", i + 1 < views.size() ? "," : "") > 0;
+		}
+		succeeded &= fprintf(indexFile, "\t]\n}\n") > 0;
+		succeeded &= fclose(indexFile) == 0;
+		return succeeded;
+	}
+}
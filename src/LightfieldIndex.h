@@ -0,0 +1,73 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace IGCS::LightfieldIndex
+{
+	/// <summary>
+	/// A single view of a lightfield: where it is in the grid, where the camera was when it was taken and where its pixels are stored.
+	/// </summary>
+	struct LightfieldView
+	{
+		int row = 0;					// 0 is the top row
+		int column = 0;					// 0 is the left column
+		int frameNumber = 0;			// the order in which the view was taken
+		float x = 0.0f;					// camera offset from the start position, in the distance units of the lightfield settings. Positive is right.
+		float y = 0.0f;					// positive is up.
+		std::string file;				// relative to the index file
+	};
+
+	/// <summary>
+	/// The grid the views of a lightfield session are part of.
+	/// </summary>
+	struct LightfieldLayout
+	{
+		int numberOfColumns = 1;
+		int numberOfRows = 1;
+		float horizontalDistanceBetweenViews = 0.0f;
+		float verticalDistanceBetweenViews = 0.0f;
+		uint32_t viewWidth = 0;
+		uint32_t viewHeight = 0;
+		std::string container;			// if not empty, the file all views are stored in, as frames with their frameNumber. 
+	};
+
+	/// <summary>
+	/// Writes the layout and the views, sorted by row, then column, as a JSON document to the file specified.
+	/// </summary>
+	/// <returns>true if the file was written, false otherwise</returns>
+	bool writeIndexFile(const std::string& filename, const LightfieldLayout& layout, std::vector<LightfieldView> views);
+}
@@ -41,9 +41,12 @@
 #include <Psapi.h>
 #include <sstream>
 #include <string>
+#include <thread>
 
+#include "Benchmarks.h"
 #include "CameraToolsData.h"
 #include "CDataFile.h"
+#include "CpuFeatures.h"
 #include "DepthOfFieldController.h"
 #include "ScreenshotController.h"
 #include "ScreenshotSettings.h"
@@ -285,6 +288,15 @@ static void onReshadePresent(effect_runtime* runtime)
 }
 
 
+static void onDestroyEffectRuntime(effect_runtime* runtime)
+{
+	// the filmstrip's textures and the frame signature readback texture are created on the runtime's device, so they have to go before the device does.
+	g_screenshotController.releaseDeviceResources(runtime);
+	// the last point before the dll can be unloaded at which threads can be joined, which can't be done in DllMain.
+	g_screenshotController.shutdown();
+}
+
+
 static void onReshadeOverlay(effect_runtime* runtime)
 {
 	// first let the screenshot controller grab screenshots
@@ -312,7 +324,7 @@ static void showHelpMarker(const char* desc)
 
 static void startScreenshotSession(bool isTestRun)
 {
-	g_screenshotController.configure(g_screenshotSettings.screenshotFolder, g_screenshotSettings.numberOfFramesToWaitBetweenSteps, (ScreenshotFiletype)g_screenshotSettings.screenshotFileType);
+	g_screenshotController.configure(g_screenshotSettings);
 	const auto cameraData = (CameraToolsData*)g_dataFromCameraToolsBuffer;
 	switch(g_screenshotSettings.typeOfScreenshot)
 	{
@@ -320,7 +332,16 @@ static void startScreenshotSession(bool isTestRun)
 		g_screenshotController.startHorizontalPanoramaShot(g_screenshotSettings.pano_totalAngleDegrees, g_screenshotSettings.pano_overlapPercentagePerShot, cameraData->fov, isTestRun);
 		break;
 	case (int)ScreenshotType::MultiShot:
-		g_screenshotController.startLightfieldShot(g_screenshotSettings.lightField_distanceBetweenShots, g_screenshotSettings.lightField_numberOfShotsToTake, isTestRun);
+		g_screenshotController.startLightfieldShot(g_screenshotSettings.lightField_distanceBetweenShots, g_screenshotSettings.lightField_numberOfShotsToTake, g_screenshotSettings.lightField_numberOfRows,
+												   g_screenshotSettings.lightField_verticalDistanceBetweenShots, isTestRun);
+		break;
+	case (int)ScreenshotType::TiledGrid:
+		g_screenshotController.startTiledGridShot(g_screenshotSettings.tiled_numberOfColumns, g_screenshotSettings.tiled_numberOfRows, g_screenshotSettings.tiled_horizontalDistanceBetweenTiles,
+												  g_screenshotSettings.tiled_verticalDistanceBetweenTiles, g_screenshotSettings.tiled_overlapPercentage, cameraData->fov, isTestRun);
+		break;
+	case (int)ScreenshotType::Stereo:
+		g_screenshotController.startStereoShot(g_screenshotSettings.stereo_numberOfViews, g_screenshotSettings.stereo_distanceBetweenViews, (ViewLayout)g_screenshotSettings.stereo_layout,
+											   g_screenshotSettings.stereo_reverseViews, isTestRun);
 		break;
 #ifdef _DEBUG
 	case (int)ScreenshotType::DebugGrid:
@@ -443,21 +464,169 @@ static void displaySettings(reshade::api::effect_runtime* runtime)
 						ImGui::AlignTextToFramePadding();
 						ImGui::InputText("Screenshot output directory", g_screenshotSettings.screenshotFolder, 256);
 						ImGui::SliderInt("Number of frames to wait between steps", &g_screenshotSettings.numberOfFramesToWaitBetweenSteps, 1, 100);
+						ImGui::Checkbox("Wait till the frame has settled", &g_screenshotSettings.adaptiveFrameWait);
+						if(ImGui::IsItemHovered(ImGuiHoveredFlags_DelayShort))
+						{
+							ImGui::SetTooltip("If checked, after the camera has been moved and the number of frames to wait between steps have passed, the shot is\ntaken as soon as two consecutive frames are nearly the same, e.g. when TAA or raytracing have converged.\nThe number of frames to wait between steps is then the minimum number of frames to wait.");
+						}
+						if(g_screenshotSettings.adaptiveFrameWait)
+						{
+							ImGui::SliderInt("Max. number of frames to wait between steps", &g_screenshotSettings.adaptiveFrameWaitMaxFrames, 1, 200);
+							ImGui::SliderFloat("Max. difference between settled frames", &g_screenshotSettings.adaptiveFrameWaitThreshold, 0.01f, 5.0f, "%.2f");
+							if(ImGui::IsItemHovered(ImGuiHoveredFlags_DelayShort))
+							{
+								ImGui::SetTooltip("The average difference in brightness (0-255) between two consecutive frames below which the frame is considered settled.");
+							}
+						}
+						ImGui::Checkbox("Retake shots which are the same as the previous shot", &g_screenshotSettings.detectDuplicateFrames);
+						if(ImGui::IsItemHovered(ImGuiHoveredFlags_DelayShort))
+						{
+							ImGui::SetTooltip("If checked, a shot which is exactly the same as the previous shot, e.g. because the game hitched or the camera\nhasn't moved yet, is taken again after waiting the number of frames between steps again.");
+						}
+						if(g_screenshotSettings.detectDuplicateFrames)
+						{
+							ImGui::SliderInt("Max. number of retakes per shot", &g_screenshotSettings.maxDuplicateFrameRetries, 1, 20);
+						}
 #ifdef _DEBUG
-						ImGui::Combo("Multi-screenshot type", &g_screenshotSettings.typeOfScreenshot, "Horizontal panorama\0Lightfield\0DEBUG: Grid\0");
+						ImGui::Combo("Multi-screenshot type", &g_screenshotSettings.typeOfScreenshot, "Horizontal panorama\0Lightfield\0Tiled grid\0Stereo\0DEBUG: Grid\0");
 #else
-						ImGui::Combo("Multi-screenshot type", &g_screenshotSettings.typeOfScreenshot, "Horizontal panorama\0Lightfield\0\0");
+						ImGui::Combo("Multi-screenshot type", &g_screenshotSettings.typeOfScreenshot, "Horizontal panorama\0Lightfield\0Tiled grid\0Stereo\0\0");
 #endif
-						ImGui::Combo("File type", &g_screenshotSettings.screenshotFileType, "Bmp\0Jpeg\0Png\0\0");
+						ImGui::Combo("File type", &g_screenshotSettings.screenshotFileType, "Bmp\0Jpeg\0Png\0Qoi\0Y4m (single file)\0\0");
+						if(ImGui::IsItemHovered(ImGuiHoveredFlags_DelayShort))
+						{
+							ImGui::SetTooltip("Y4m writes all shots of a session into a single uncompressed video file, which keeps the disk busy with large sequential writes.\nUseful for sessions with many shots. Panoramas and quilts are written as Png.\nTiled grids can only be written as Bmp or Png.");
+						}
+						if(g_screenshotSettings.screenshotFileType == (int)ScreenshotFiletype::Jpeg)
+						{
+							ImGui::SliderInt("Jpeg quality", &g_screenshotSettings.jpegQuality, 1, 100);
+							ImGui::Combo("Jpeg chroma subsampling", &g_screenshotSettings.jpegChromaSubsampling, "None (4:4:4)\0Half resolution (4:2:0)\0\0");
+							if(ImGui::IsItemHovered(ImGuiHoveredFlags_DelayShort))
+							{
+								ImGui::SetTooltip("4:2:0 stores the color information at half the resolution, which gives smaller files but can blur fine colored details.");
+							}
+						}
+						if(g_screenshotSettings.screenshotFileType == (int)ScreenshotFiletype::Y4m)
+						{
+							ImGui::SliderInt("Frames per second", &g_screenshotSettings.y4mFramesPerSecond, 1, 120);
+						}
+						if(g_screenshotSettings.screenshotFileType == (int)ScreenshotFiletype::Png || g_screenshotSettings.screenshotFileType == (int)ScreenshotFiletype::Y4m)
+						{
+							ImGui::Checkbox("Recompress png files after the session", &g_screenshotSettings.recompressPngsAfterSession);
+							if(ImGui::IsItemHovered(ImGuiHoveredFlags_DelayShort))
+							{
+								ImGui::SetTooltip("If checked, the png files of a session are recompressed in the background at low priority after the session is done.\nPng files are written with a fast encoder while capturing. Recompressing them makes them smaller, but takes a while.");
+							}
+						}
+						ImGui::Checkbox("Show thumbnails of the shots after the session", &g_screenshotSettings.generateThumbnails);
+						if(ImGui::IsItemHovered(ImGuiHoveredFlags_DelayShort))
+						{
+							ImGui::SetTooltip("If checked, a small thumbnail is made of every shot that's written and the thumbnails of the last session\nare shown below the start buttons, so you can check the shots without leaving the game.");
+						}
+						ImGui::Checkbox("Write shots to disk while capturing", &g_screenshotSettings.writeShotsWhileCapturing);
+						if(ImGui::IsItemHovered(ImGuiHoveredFlags_DelayShort))
+						{
+							ImGui::SetTooltip("If checked, every shot is written to disk right after it's been taken, while the next shot is being prepared.\nIf unchecked, all shots are kept in memory and written to disk after the last shot has been taken.");
+						}
+						if(g_screenshotSettings.writeShotsWhileCapturing)
+						{
+							ImGui::SliderInt("Max. number of shots in flight", &g_screenshotSettings.maxNumberOfShotsInFlight, 1, 16);
+							if(ImGui::IsItemHovered(ImGuiHoveredFlags_DelayShort))
+							{
+								ImGui::SetTooltip("The maximum number of taken shots which are kept in memory while waiting to be written to disk.\nIf this number is reached, the next shot is postponed till a shot has been written.");
+							}
+						}
+						else
+						{
+							ImGui::SliderInt("Max. memory for shots (MB)", &g_screenshotSettings.shotMemoryBudgetInMB, 256, 65536, "%d", ImGuiSliderFlags_Logarithmic);
+							if(ImGui::IsItemHovered(ImGuiHoveredFlags_DelayShort))
+							{
+								ImGui::SetTooltip("If the shots of a session need more memory than this (or more than half of the free memory), they're kept in a\nscratch file in the screenshot folder instead, so the game isn't paged out or runs out of memory.");
+							}
+						}
 						switch(g_screenshotSettings.typeOfScreenshot)
 						{
 							case (int)ScreenshotType::HorizontalPanorama:
 								ImGui::SliderFloat("Total field of view in panorama (in degrees)", &g_screenshotSettings.pano_totalAngleDegrees, 30.0f, 360.0f, "%.1f");
 								ImGui::SliderFloat("Percentage of overlap between shots", &g_screenshotSettings.pano_overlapPercentagePerShot, 0.1f, 99.0f, "%.1f");
+								ImGui::Checkbox("Stitch shots into a panorama", &g_screenshotSettings.pano_stitchShots);
+								if(ImGui::IsItemHovered(ImGuiHoveredFlags_DelayShort))
+								{
+									ImGui::SetTooltip("If checked, the shots are also projected onto a cylinder and blended into a single panorama image, which is\nsaved next to the shots. As the camera angle of every shot is known, this doesn't need any feature matching.");
+								}
 								break;
 							case (int)ScreenshotType::MultiShot:
 								ImGui::SliderFloat("Distance between Lightfield shots", &g_screenshotSettings.lightField_distanceBetweenShots, 0.0f, 5.0f, "%.3f");
 								ImGui::SliderInt("Number of shots to take", &g_screenshotSettings.lightField_numberOfShotsToTake, 0, 60);
+								if(g_screenshotSettings.lightField_output != (int)LightfieldOutput::Quilt)
+								{
+									ImGui::SliderInt("Number of rows", &g_screenshotSettings.lightField_numberOfRows, 1, 32);
+									if(ImGui::IsItemHovered(ImGuiHoveredFlags_DelayShort))
+									{
+										ImGui::SetTooltip("If more than 1, the number of shots above are taken on every row of a grid around the camera position. The rows are\ntaken in serpentine order and the shots are named row_column. A Lightfield.json index describing the grid is written next to the shots.");
+									}
+									if(g_screenshotSettings.lightField_numberOfRows > 1)
+									{
+										ImGui::SliderFloat("Distance between rows", &g_screenshotSettings.lightField_verticalDistanceBetweenShots, 0.0f, 5.0f, "%.3f");
+									}
+								}
+								ImGui::Combo("Lightfield output", &g_screenshotSettings.lightField_output, "Separate shots\0Quilt (Looking Glass)\0\0");
+								if(ImGui::IsItemHovered(ImGuiHoveredFlags_DelayShort))
+								{
+									ImGui::SetTooltip("Quilt: the shots are downscaled into the views of a single quilt image while capturing, instead of being written as separate files.\nA quilt is always a single row of shots.");
+								}
+								if(g_screenshotSettings.lightField_output == (int)LightfieldOutput::Quilt)
+								{
+									ImGui::SliderInt("Quilt columns", &g_screenshotSettings.lightField_quiltColumns, 1, 16);
+									ImGui::SliderInt("Quilt rows", &g_screenshotSettings.lightField_quiltRows, 1, 16);
+									ImGui::SliderInt("Quilt view width", &g_screenshotSettings.lightField_quiltViewWidth, 64, 2048);
+									ImGui::SliderInt("Quilt view height", &g_screenshotSettings.lightField_quiltViewHeight, 64, 2048);
+								}
+								else
+								{
+									ImGui::Checkbox("Keep shots delta compressed while capturing", &g_screenshotSettings.lightField_storeShotsAsDeltas);
+									if(ImGui::IsItemHovered(ImGuiHoveredFlags_DelayShort))
+									{
+										ImGui::SetTooltip("If checked, the first shot is kept compressed and every next shot only as the difference with the shot before it,\nwhich takes a fraction of the memory. The shots are written to disk as normal after the last shot has been taken,\nalso if 'Write shots to disk while capturing' is checked.");
+									}
+									if(g_screenshotSettings.lightField_storeShotsAsDeltas)
+									{
+										ImGui::SliderInt("Max. horizontal shift between shots (pixels)", &g_screenshotSettings.lightField_maxShiftSearch, 0, 256);
+										if(ImGui::IsItemHovered(ImGuiHoveredFlags_DelayShort))
+										{
+											ImGui::SetTooltip("Every shot is aligned with the shot before it by searching for the best horizontal shift up to this number of pixels\nbefore the difference is taken. 0 disables the search.");
+										}
+									}
+								}
+								break;
+							case (int)ScreenshotType::TiledGrid:
+								ImGui::SliderInt("Number of tile columns", &g_screenshotSettings.tiled_numberOfColumns, 1, 32);
+								if(ImGui::IsItemHovered(ImGuiHoveredFlags_DelayShort))
+								{
+									ImGui::SetTooltip("The field of view of the tiles is the current field of view divided by the number of columns. The tiles are assembled\ninto a single bmp or png file while capturing, so the image can be far larger than what fits in memory.");
+								}
+								if(!ScreenshotController::canAssembleTiles((ScreenshotFiletype)g_screenshotSettings.screenshotFileType))
+								{
+									ImGui::TextWrapped("A tiled grid can only be written as Bmp or Png. Select one of these file types to start a session.");
+								}
+								ImGui::SliderInt("Number of tile rows", &g_screenshotSettings.tiled_numberOfRows, 1, 32);
+								ImGui::SliderFloat("Horizontal distance between tiles", &g_screenshotSettings.tiled_horizontalDistanceBetweenTiles, 0.0f, 5.0f, "%.3f");
+								ImGui::SliderFloat("Vertical distance between tiles", &g_screenshotSettings.tiled_verticalDistanceBetweenTiles, 0.0f, 5.0f, "%.3f");
+								ImGui::SliderFloat("Percentage of overlap between tiles", &g_screenshotSettings.tiled_overlapPercentage, 0.0f, 50.0f, "%.1f");
+								if(ImGui::IsItemHovered(ImGuiHoveredFlags_DelayShort))
+								{
+									ImGui::SetTooltip("The part of a tile which overlaps with its neighbors. It's cut off, half on either side, when the tiles are assembled.");
+								}
+								break;
+							case (int)ScreenshotType::Stereo:
+								ImGui::SliderInt("Number of views", &g_screenshotSettings.stereo_numberOfViews, 2, 16);
+								ImGui::SliderFloat("Distance between views (IPD)", &g_screenshotSettings.stereo_distanceBetweenViews, 0.0f, 5.0f, "%.3f");
+								if(ImGui::IsItemHovered(ImGuiHoveredFlags_DelayShort))
+								{
+									ImGui::SetTooltip("The views are taken on a horizontal line centered on the camera position, with this distance between them.\nThey're composed into a single image while capturing, no separate files are written per view.");
+								}
+								ImGui::Combo("Layout", &g_screenshotSettings.stereo_layout, "Side by side\0Over under\0\0");
+								ImGui::Checkbox("Reverse views (cross-eyed)", &g_screenshotSettings.stereo_reverseViews);
 								break;
 								// others: ignore.
 						}
@@ -478,6 +647,14 @@ static void displaySettings(reshade::api::effect_runtime* runtime)
 						{
 							ImGui::Text("Camera disabled so no screenshot session can be started");
 						}
+						g_screenshotController.displayFilmstrip(runtime);
+#ifdef _DEBUG
+						if(ImGui::Button("DEBUG: Run benchmarks"))
+						{
+							std::thread benchmarkThread(&IGCS::Benchmarks::runBenchmarks);
+							benchmarkThread.detach();
+						}
+#endif
 					}
 					break;
 				case ScreenshotControllerState::InSession:
@@ -1144,11 +1321,14 @@ BOOL APIENTRY DllMain(HMODULE hModule, DWORD fdwReason, LPVOID)
 		{
 			return FALSE;
 		}
+		// before anything is encoded, so every SIMD kernel, including fpng's, dispatches on the same features.
+		IGCS::CpuFeatures::initialize();
 		reshade::register_event<reshade::addon_event::reshade_present>(onReshadePresent);
 		reshade::register_event<reshade::addon_event::reshade_overlay>(onReshadeOverlay);
 		reshade::register_event<reshade::addon_event::reshade_begin_effects>(onReshadeBeginEffects);
 		reshade::register_event<reshade::addon_event::reshade_finish_effects>(onReshadeFinishEffects);
 		reshade::register_event<reshade::addon_event::reshade_reloaded_effects>(onReshadeReloadEffects);
+		reshade::register_event<reshade::addon_event::destroy_effect_runtime>(onDestroyEffectRuntime);
 		reshade::register_overlay(nullptr, &displaySettings);
 		loadIniFile();
 		break;
@@ -1158,6 +1338,7 @@ BOOL APIENTRY DllMain(HMODULE hModule, DWORD fdwReason, LPVOID)
 		reshade::unregister_event<reshade::addon_event::reshade_begin_effects>(onReshadeBeginEffects);
 		reshade::unregister_event<reshade::addon_event::reshade_finish_effects>(onReshadeFinishEffects);
 		reshade::unregister_event<reshade::addon_event::reshade_reloaded_effects>(onReshadeReloadEffects);
+		reshade::unregister_event<reshade::addon_event::destroy_effect_runtime>(onDestroyEffectRuntime);
 		reshade::unregister_overlay(nullptr, &displaySettings);
 		reshade::unregister_addon(hModule);
 		if(nullptr!=g_dataFromCameraToolsBuffer)
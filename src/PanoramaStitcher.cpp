@@ -0,0 +1,234 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+#include "PanoramaStitcher.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <thread>
+
+namespace
+{
+	// the minimum number of rows per thread, so we don't start threads for a couple of rows.
+	constexpr uint32_t MinimumNumberOfRowsPerBand = 32;
+
+	/// <summary>
+	/// Calls processRows(firstRow, endRow) for bands of the rows [0, numberOfRows), spread over the cores. Band 0 is processed on the calling thread.
+	/// </summary>
+	template<typename Func>
+	void processRowBands(uint32_t numberOfRows, Func processRows)
+	{
+		uint32_t numberOfBands = (std::max)(1u, std::thread::hardware_concurrency());
+		numberOfBands = (std::min)(numberOfBands, (std::max)(1u, numberOfRows / MinimumNumberOfRowsPerBand));
+		const uint32_t rowsPerBand = (numberOfRows + numberOfBands - 1) / numberOfBands;
+		std::vector<std::thread> threads;
+		threads.reserve(numberOfBands - 1);
+		for(uint32_t i = 1; i < numberOfBands; i++)
+		{
+			const uint32_t firstRow = i * rowsPerBand;
+			if(firstRow >= numberOfRows)
+			{
+				break;
+			}
+			threads.emplace_back(processRows, firstRow, (std::min)(numberOfRows, firstRow + rowsPerBand));
+		}
+		processRows(0u, (std::min)(numberOfRows, rowsPerBand));
+		for(auto& thread : threads)
+		{
+			thread.join();
+		}
+	}
+}
+
+
+bool PanoramaStitcher::begin(uint32_t shotWidth, uint32_t shotHeight, float horizontalFoVRadians, float anglePerStep, int numberOfShots)
+{
+	clear();
+	if(shotWidth < 2 || shotHeight < 2 || numberOfShots < 1 || anglePerStep <= 0.0f || horizontalFoVRadians <= 0.0f || horizontalFoVRadians >= 3.1f)
+	{
+		return false;
+	}
+	_shotWidth = shotWidth;
+	_shotHeight = shotHeight;
+	_horizontalFoVRadians = horizontalFoVRadians;
+	_anglePerStep = anglePerStep;
+	_numberOfShots = numberOfShots;
+	_focalLength = (0.5f * shotWidth) / std::tan(0.5f * horizontalFoVRadians);
+	// the panorama runs from the left edge of the first shot to the right edge of the last shot. Column 0 starts at the left edge of shot 0.
+	_panoramaWidth = (uint32_t)std::ceil(((numberOfShots - 1) * anglePerStep + horizontalFoVRadians) * _focalLength);
+	_panorama.assign((size_t)_panoramaWidth * _shotHeight * 3, 0);
+	// a shot never covers more columns than this, so the window always holds the shot being added.
+	_windowWidth = (std::min)(_panoramaWidth, (uint32_t)std::ceil(horizontalFoVRadians * _focalLength) + 2);
+	_window.assign((size_t)_windowWidth * _shotHeight * 4, 0.0f);
+	_windowStart = 0;
+	_columnMappings.resize(_windowWidth);
+	return true;
+}
+
+
+void PanoramaStitcher::addShot(int shotNumber, const uint8_t* data)
+{
+	if(!isActive() || nullptr == data || shotNumber <= _lastShotAdded || shotNumber >= _numberOfShots)
+	{
+		return;
+	}
+	_lastShotAdded = shotNumber;
+	const float yaw = shotNumber * _anglePerStep;
+	const float halfFoV = 0.5f * _horizontalFoVRadians;
+	// no later shot reaches left of this shot's left edge, so those columns are done.
+	const uint32_t firstColumn = (std::min)(_panoramaWidth, (uint32_t)std::floor(yaw * _focalLength));
+	finishColumnsBefore(firstColumn);
+	const uint32_t endColumn = (std::min)(_panoramaWidth, _windowStart + _windowWidth);
+	const uint32_t numberOfColumns = endColumn - _windowStart;
+
+	for(uint32_t i = 0; i < numberOfColumns; i++)
+	{
+		// the angle of the column's center, relative to the shot's center
+		const float angle = (_windowStart + i + 0.5f) / _focalLength - halfFoV - yaw;
+		ColumnMapping& mapping = _columnMappings[i];
+		if(std::fabs(angle) >= halfFoV)
+		{
+			mapping.weight = 0.0f;
+			continue;
+		}
+		mapping.sourceX = _focalLength * std::tan(angle) + 0.5f * _shotWidth - 0.5f;
+		mapping.verticalScale = 1.0f / std::cos(angle);
+		// feathering: the weight drops linearly to 0 towards the shot's left and right edges.
+		mapping.weight = halfFoV - std::fabs(angle);
+	}
+
+	const float centerY = 0.5f * _shotHeight;
+	const size_t sourceRowSize = (size_t)_shotWidth * 3;
+	processRowBands(_shotHeight, [&](uint32_t firstRow, uint32_t endRow)
+		{
+			for(uint32_t y = firstRow; y < endRow; y++)
+			{
+				float* windowRow = _window.data() + (size_t)y * _windowWidth * 4;
+				for(uint32_t i = 0; i < numberOfColumns; i++)
+				{
+					const ColumnMapping& mapping = _columnMappings[i];
+					if(mapping.weight <= 0.0f)
+					{
+						continue;
+					}
+					const float sourceY = (y + 0.5f - centerY) * mapping.verticalScale + centerY - 0.5f;
+					if(mapping.sourceX < 0.0f || sourceY < 0.0f || mapping.sourceX > (float)(_shotWidth - 1) || sourceY > (float)(_shotHeight - 1))
+					{
+						continue;
+					}
+					// bilinear sample
+					const uint32_t x0 = (std::min)((uint32_t)mapping.sourceX, _shotWidth - 2);
+					const uint32_t y0 = (std::min)((uint32_t)sourceY, _shotHeight - 2);
+					const float fractionX = mapping.sourceX - x0;
+					const float fractionY = sourceY - y0;
+					const uint8_t* topLeft = data + y0 * sourceRowSize + x0 * 3;
+					const uint8_t* bottomLeft = topLeft + sourceRowSize;
+					float* accumulator = windowRow + i * 4;
+					for(int c = 0; c < 3; c++)
+					{
+						const float top = topLeft[c] + (topLeft[c + 3] - topLeft[c]) * fractionX;
+						const float bottom = bottomLeft[c] + (bottomLeft[c + 3] - bottomLeft[c]) * fractionX;
+						accumulator[c] += (top + (bottom - top) * fractionY) * mapping.weight;
+					}
+					accumulator[3] += mapping.weight;
+				}
+			}
+		});
+}
+
+
+bool PanoramaStitcher::finish(std::vector<uint8_t>& panorama, uint32_t& width, uint32_t& height)
+{
+	if(!isActive() || _lastShotAdded < 0)
+	{
+		return false;
+	}
+	finishColumnsBefore(_panoramaWidth);
+	width = _panoramaWidth;
+	height = _shotHeight;
+	panorama = std::move(_panorama);
+	clear();
+	return true;
+}
+
+
+void PanoramaStitcher::clear()
+{
+	_panoramaWidth = 0;
+	_lastShotAdded = -1;
+	_windowStart = 0;
+	_windowWidth = 0;
+	_panorama.clear();
+	_panorama.shrink_to_fit();
+	_window.clear();
+	_window.shrink_to_fit();
+	_columnMappings.clear();
+}
+
+
+void PanoramaStitcher::finishColumnsBefore(uint32_t column)
+{
+	if(column <= _windowStart)
+	{
+		return;
+	}
+	// columns past the window were never touched (skipped shots), they stay black.
+	const uint32_t numberOfColumnsToFinish = (std::min)(column - _windowStart, _windowWidth);
+	const uint32_t numberOfColumnsToKeep = _windowWidth - numberOfColumnsToFinish;
+	processRowBands(_shotHeight, [&](uint32_t firstRow, uint32_t endRow)
+		{
+			for(uint32_t y = firstRow; y < endRow; y++)
+			{
+				float* windowRow = _window.data() + (size_t)y * _windowWidth * 4;
+				uint8_t* panoramaRow = _panorama.data() + ((size_t)y * _panoramaWidth + _windowStart) * 3;
+				for(uint32_t i = 0; i < numberOfColumnsToFinish && _windowStart + i < _panoramaWidth; i++)
+				{
+					const float* accumulator = windowRow + i * 4;
+					if(accumulator[3] <= 0.0f)
+					{
+						continue;
+					}
+					const float weightFactor = 1.0f / accumulator[3];
+					for(int c = 0; c < 3; c++)
+					{
+						panoramaRow[i * 3 + c] = (uint8_t)(std::min)(255.0f, accumulator[c] * weightFactor + 0.5f);
+					}
+				}
+				// slide the window
+				memmove(windowRow, windowRow + numberOfColumnsToFinish * 4, (size_t)numberOfColumnsToKeep * 4 * sizeof(float));
+				memset(windowRow + numberOfColumnsToKeep * 4, 0, (size_t)numberOfColumnsToFinish * 4 * sizeof(float));
+			}
+		});
+	_windowStart = column;
+}
@@ -0,0 +1,100 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <cstdint>
+#include <vector>
+
+/// <summary>
+/// Stitches the shots of a horizontal panorama session into a single cylindrical panorama. The camera's yaw per shot is known, so no feature
+/// matching is needed: every shot is projected onto a cylinder around the camera and the overlapping parts are blended by feathering, weighted
+/// by the distance to the shot's left/right edge. Shots have to be added in the order they were taken, left to right. Output columns are
+/// finished as soon as no later shot can touch them, so only a window of about one shot wide is kept in floating point. Not thread safe, but
+/// the work per shot is spread over all cores.
+/// </summary>
+class PanoramaStitcher
+{
+public:
+	PanoramaStitcher() = default;
+	PanoramaStitcher(const PanoramaStitcher&) = delete;
+	PanoramaStitcher& operator=(const PanoramaStitcher&) = delete;
+
+	/// <summary>
+	/// Clears the stitcher and prepares it for a panorama of numberOfShots RGB shots of the size specified.
+	/// </summary>
+	/// <param name="horizontalFoVRadians">the horizontal field of view of a shot</param>
+	/// <param name="anglePerStep">the angle the camera was rotated to the right between two shots</param>
+	/// <returns>true if the stitcher was set up, false if the arguments can't form a panorama</returns>
+	bool begin(uint32_t shotWidth, uint32_t shotHeight, float horizontalFoVRadians, float anglePerStep, int numberOfShots);
+	/// <summary>
+	/// Projects the RGB shot in data, which is shot shotNumber of the panorama, onto the panorama. shotNumber has to be higher than the
+	/// shot number of the previous shot added. Skipped shot numbers leave a gap.
+	/// </summary>
+	void addShot(int shotNumber, const uint8_t* data);
+	/// <summary>
+	/// Finishes the panorama and moves it into panorama as RGB pixels.
+	/// </summary>
+	/// <returns>true if the panorama contains at least one shot, false otherwise</returns>
+	bool finish(std::vector<uint8_t>& panorama, uint32_t& width, uint32_t& height);
+	void clear();
+	bool isActive() const { return _panoramaWidth > 0; }
+
+private:
+	// how a panorama column samples the shot being added
+	struct ColumnMapping
+	{
+		float sourceX = 0.0f;				// the x coordinate in the shot
+		float verticalScale = 1.0f;			// the cylinder is taller than the shot's plane towards the shot's edges
+		float weight = 0.0f;				// 0 if the column is outside the shot
+	};
+
+	/// <summary>
+	/// Writes the blended columns left of column to the panorama and moves the window so it starts at column.
+	/// </summary>
+	void finishColumnsBefore(uint32_t column);
+
+	uint32_t _shotWidth = 0;
+	uint32_t _shotHeight = 0;
+	float _horizontalFoVRadians = 0.0f;
+	float _anglePerStep = 0.0f;
+	float _focalLength = 0.0f;				// in pixels, for both the shots and the cylinder
+	int _numberOfShots = 0;
+	int _lastShotAdded = -1;
+	uint32_t _panoramaWidth = 0;
+	std::vector<uint8_t> _panorama;			// RGB, _panoramaWidth * _shotHeight
+	// per pixel the weighted R, G, B sums and the sum of the weights, for the columns [_windowStart, _windowStart + _windowWidth).
+	std::vector<float> _window;
+	uint32_t _windowStart = 0;
+	uint32_t _windowWidth = 0;
+	std::vector<ColumnMapping> _columnMappings;
+};
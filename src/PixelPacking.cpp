@@ -0,0 +1,145 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+#include "PixelPacking.h"
+#include "CpuFeatures.h"
+#include <cstring>
+#include <immintrin.h>
+
+namespace IGCS::PixelPacking
+{
+	namespace
+	{
+		/// <summary>
+		/// Packs the pixels from firstPixel till numberOfPixels. Pixel i is read from 4*i and written to 3*i, so we never overwrite a pixel we haven't
+		/// read yet. We write 4 bytes per pixel, the 4th byte is overwritten by the next pixel. The last pixel is written byte by byte so we don't
+		/// write past the last pixel's alpha.
+		/// </summary>
+		void packRGBAToRGBScalarTail(uint8_t* data, size_t firstPixel, size_t numberOfPixels)
+		{
+			if(firstPixel >= numberOfPixels)
+			{
+				return;
+			}
+			for(size_t i = firstPixel; i < numberOfPixels - 1; ++i)
+			{
+				uint32_t pixel;
+				memcpy(&pixel, data + 4 * i, 4);
+				memcpy(data + 3 * i, &pixel, 4);
+			}
+			const size_t last = numberOfPixels - 1;
+			data[3 * last] = data[4 * last];
+			data[3 * last + 1] = data[4 * last + 1];
+			data[3 * last + 2] = data[4 * last + 2];
+		}
+
+
+		typedef void(*PackFunc)(uint8_t*, size_t);
+
+		PackFunc selectPacker(const char** name)
+		{
+			// selected during static initialization, CpuFeatures detects the features on first use.
+			const CpuFeatures::FeatureSet& features = CpuFeatures::get();
+			if(features.avx2)
+			{
+				*name = "AVX2";
+				return &packRGBAToRGBAVX2;
+			}
+			if(features.ssse3)
+			{
+				*name = "SSSE3";
+				return &packRGBAToRGBSSSE3;
+			}
+			*name = "Scalar";
+			return &packRGBAToRGBScalar;
+		}
+
+		const char* g_packerName = "";
+		const PackFunc g_packer = selectPacker(&g_packerName);
+	}
+
+
+	void packRGBAToRGB(uint8_t* data, size_t numberOfPixels)
+	{
+		g_packer(data, numberOfPixels);
+	}
+
+
+	const char* getPackerName()
+	{
+		return g_packerName;
+	}
+
+
+	void packRGBAToRGBScalar(uint8_t* data, size_t numberOfPixels)
+	{
+		packRGBAToRGBScalarTail(data, 0, numberOfPixels);
+	}
+
+
+	void packRGBAToRGBSSSE3(uint8_t* data, size_t numberOfPixels)
+	{
+		// 4 pixels per step: 16 bytes are read from 4*i, packed to 12 bytes and stored as 16 bytes at 3*i. As 3*i+16 <= 4*i+16, the store only
+		// overwrites bytes which have already been read. The last 4 bytes stored are garbage, they're overwritten by the next store.
+		const __m128i shuffleMask = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+		size_t i = 0;
+		for(; i + 8 <= numberOfPixels; i += 8)
+		{
+			const __m128i pixels0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 4 * i));
+			const __m128i pixels1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 4 * i + 16));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(data + 3 * i), _mm_shuffle_epi8(pixels0, shuffleMask));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(data + 3 * i + 12), _mm_shuffle_epi8(pixels1, shuffleMask));
+		}
+		packRGBAToRGBScalarTail(data, i, numberOfPixels);
+	}
+
+
+	void packRGBAToRGBAVX2(uint8_t* data, size_t numberOfPixels)
+	{
+		// 8 pixels per step: the in-lane shuffle packs each 128-bit lane to 12 bytes at the start of the lane, the permute then moves the 24 bytes
+		// together. The 32 byte store at 3*i ends at 3*i+32 <= 4*i+32, so it only overwrites bytes which have already been read.
+		const __m256i shuffleMask = _mm256_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+													 0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+		const __m256i permuteMask = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7);
+		size_t i = 0;
+		for(; i + 16 <= numberOfPixels; i += 16)
+		{
+			const __m256i pixels0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + 4 * i));
+			const __m256i pixels1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + 4 * i + 32));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(data + 3 * i), _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(pixels0, shuffleMask), permuteMask));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(data + 3 * i + 24), _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(pixels1, shuffleMask), permuteMask));
+		}
+		packRGBAToRGBScalarTail(data, i, numberOfPixels);
+	}
+}
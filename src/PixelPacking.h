@@ -0,0 +1,54 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace IGCS::PixelPacking
+{
+	/// <summary>
+	/// Packs the RGBA pixels in data as RGB pixels, in place. The alpha channel is dropped. After this call the first numberOfPixels*3 bytes in
+	/// data contain the RGB pixels, the remaining bytes are undefined. Uses the fastest implementation the cpu supports.
+	/// </summary>
+	void packRGBAToRGB(uint8_t* data, size_t numberOfPixels);
+	/// <summary>
+	/// Returns the name of the implementation used by packRGBAToRGB, e.g. "AVX2".
+	/// </summary>
+	const char* getPackerName();
+
+	// The separate implementations. Only call the SIMD variants if CpuFeatures says the cpu supports them. Exposed for benchmarking / validation.
+	void packRGBAToRGBScalar(uint8_t* data, size_t numberOfPixels);
+	void packRGBAToRGBSSSE3(uint8_t* data, size_t numberOfPixels);
+	void packRGBAToRGBAVX2(uint8_t* data, size_t numberOfPixels);
+}
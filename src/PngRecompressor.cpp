@@ -0,0 +1,250 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+#include "PngRecompressor.h"
+#include "Utils.h"
+#include "fpng.h"
+#include "std_image_write.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <iterator>
+#include <new>
+#include <thread>
+
+namespace
+{
+	// the length of the match chains stb's deflate searches. Its default is 8, a longer search finds more and longer matches.
+	constexpr int PngCompressionLevel = 16;
+	// every job holds the decoded image and both encoder outputs in memory. Shots up to 8K stay well within that, the far larger images of a tiled
+	// grid or a stitched panorama are left as they are.
+	constexpr uint64_t MaxNumberOfPixels = 7680ull * 4320ull;
+	// the signature, and the IHDR chunk which always comes first: length, type, width, height, 5 bytes of format, crc.
+	constexpr size_t PngSignatureLength = 8;
+	constexpr size_t IhdrChunkLength = 4 + 4 + 13 + 4;
+	// an empty private, ancillary chunk placed right after the IHDR chunk of every file this class wrote, so those files are skipped next time,
+	// also when the smallest result came from fpng.
+	const char RecompressedChunkType[] = "igRc";
+	constexpr size_t EmptyChunkLength = 4 + 4 + 4;
+	// jobs waiting in the pool. Every folder takes a job per worker, so this allows a couple of sessions to be queued.
+	constexpr int MaxNumberOfQueuedJobsPerWorker = 8;
+
+	bool writeFile(const std::string& filename, const std::vector<uint8_t>& data)
+	{
+		FILE* file;
+		if(fopen_s(&file, filename.c_str(), "wb") != 0)
+		{
+			return false;
+		}
+		const bool written = fwrite(data.data(), 1, data.size(), file) == data.size();
+		return (fclose(file) == 0) && written;
+	}
+
+	uint32_t readBigEndian32(const uint8_t* data)
+	{
+		return ((uint32_t)data[0] << 24) | ((uint32_t)data[1] << 16) | ((uint32_t)data[2] << 8) | (uint32_t)data[3];
+	}
+
+	void writeBigEndian32(uint8_t* destination, uint32_t value)
+	{
+		destination[0] = (uint8_t)(value >> 24);
+		destination[1] = (uint8_t)(value >> 16);
+		destination[2] = (uint8_t)(value >> 8);
+		destination[3] = (uint8_t)value;
+	}
+
+	/// <summary>
+	/// Reads the start of the png file specified and returns true if it should be recompressed: it's not larger than the pixel budget and it wasn't
+	/// written by the recompressor already.
+	/// </summary>
+	bool shouldRecompress(const std::string& filename)
+	{
+		FILE* file;
+		if(fopen_s(&file, filename.c_str(), "rb") != 0)
+		{
+			return false;
+		}
+		uint8_t header[PngSignatureLength + IhdrChunkLength + EmptyChunkLength] = {};
+		const size_t bytesRead = fread(header, 1, sizeof(header), file);
+		fclose(file);
+		if(bytesRead != sizeof(header) || memcmp(header + PngSignatureLength + 4, "IHDR", 4) != 0)
+		{
+			return false;
+		}
+		const uint64_t width = readBigEndian32(header + PngSignatureLength + 8);
+		const uint64_t height = readBigEndian32(header + PngSignatureLength + 12);
+		if(width * height > MaxNumberOfPixels)
+		{
+			return false;
+		}
+		return memcmp(header + PngSignatureLength + IhdrChunkLength + 4, RecompressedChunkType, 4) != 0;
+	}
+
+	/// <summary>
+	/// Inserts the chunk which marks the file as recompressed after the IHDR chunk of the png in data.
+	/// </summary>
+	void markAsRecompressed(std::vector<uint8_t>& data)
+	{
+		uint8_t chunk[EmptyChunkLength] = {};
+		memcpy(chunk + 4, RecompressedChunkType, 4);
+		writeBigEndian32(chunk + 8, fpng::fpng_crc32(chunk + 4, 4, fpng::FPNG_CRC32_INIT));
+		data.insert(data.begin() + PngSignatureLength + IhdrChunkLength, std::begin(chunk), std::end(chunk));
+	}
+}
+
+
+PngRecompressor::PngRecompressor() : _numberOfWorkers((std::max)(1u, std::thread::hardware_concurrency())), 
+									 _workers(_numberOfWorkers, _numberOfWorkers * MaxNumberOfQueuedJobsPerWorker)
+{
+}
+
+
+void PngRecompressor::recompressFolder(const std::string& folder)
+{
+	auto folderState = std::make_shared<FolderState>();
+	folderState->folder = folder;
+	std::error_code errorCode;
+	for(const auto& entry : std::filesystem::directory_iterator(folder, errorCode))
+	{
+		if(entry.is_regular_file() && entry.path().extension() == ".png")
+		{
+			folderState->filenames.push_back(entry.path().string());
+		}
+	}
+	if(folderState->filenames.empty())
+	{
+		return;
+	}
+	const int numberOfJobs = (std::min)(_numberOfWorkers, (int)folderState->filenames.size());
+	for(int i = 0; i < numberOfJobs; i++)
+	{
+		folderState->numberOfJobsRunning++;
+		if(!_workers.submit([folderState](const CancellationToken& cancellationToken) { recompressFiles(folderState, cancellationToken); }, CancellationToken()))
+		{
+			// the jobs which did get queued pick up all files.
+			folderState->numberOfJobsRunning--;
+			break;
+		}
+	}
+	if(folderState->numberOfJobsRunning == 0)
+	{
+		IGCS::Utils::logLineToReshade(reshade::log::level::warning, "Too many folders waiting to be recompressed, the png files in '%s' are left as they are.", folder.c_str());
+	}
+}
+
+
+void PngRecompressor::recompressFiles(const std::shared_ptr<FolderState>& folderState, const CancellationToken& cancellationToken)
+{
+	// lowers both the cpu and the I/O priority of the thread, so the game and a new session aren't slowed down.
+	SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_BEGIN);
+	for(size_t i = folderState->nextFile++; i < folderState->filenames.size() && !cancellationToken.isCancellationRequested(); i = folderState->nextFile++)
+	{
+		const uint64_t bytesSaved = recompressFile(folderState->filenames[i]);
+		if(bytesSaved > 0)
+		{
+			folderState->numberOfFilesReplaced++;
+			folderState->bytesSaved += bytesSaved;
+		}
+	}
+	SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_END);
+	if(--folderState->numberOfJobsRunning == 0)
+	{
+		IGCS::Utils::logLineToReshade(reshade::log::level::info, "Recompressed %d of %d png files in '%s', which saved %llu KB.", folderState->numberOfFilesReplaced.load(),
+									  (int)folderState->filenames.size(), folderState->folder.c_str(), folderState->bytesSaved.load() / 1024);
+	}
+}
+
+
+uint64_t PngRecompressor::recompressFile(const std::string& filename)
+{
+	std::error_code errorCode;
+	const uintmax_t originalSize = std::filesystem::file_size(filename, errorCode);
+	if(errorCode)
+	{
+		return 0;
+	}
+	if(!shouldRecompress(filename))
+	{
+		return 0;
+	}
+	std::vector<uint8_t> recompressed;
+	try
+	{
+		std::vector<uint8_t> pixels;
+		uint32_t width = 0;
+		uint32_t height = 0;
+		uint32_t numberOfChannels = 0;
+		// png files which weren't written by fpng are left alone. Every core already runs a job of its own in background mode, so the file is decoded
+		// on this thread only.
+		if(fpng::fpng_decode_file(filename.c_str(), pixels, width, height, numberOfChannels, 3, 1) != fpng::FPNG_DECODE_SUCCESS)
+		{
+			return 0;
+		}
+		// Neither encoder wins on all shots: stb's deflate finds long matches, which pays off in flat and repetitive areas, but is weak on noisy
+		// content, where fpng's two pass mode with Huffman tables built for the image does better. So we try both and keep the smallest.
+		std::vector<uint8_t> candidate;
+		if(stbi_write_png_to_func_with_level([](void* context, void* data, int size)
+											 {
+												 auto destination = static_cast<std::vector<uint8_t>*>(context);
+												 destination->insert(destination->end(), static_cast<uint8_t*>(data), static_cast<uint8_t*>(data) + size);
+											 }, &candidate, (int)width, (int)height, 3, pixels.data(), (int)width * 3, PngCompressionLevel))
+		{
+			recompressed.swap(candidate);
+		}
+		candidate.clear();
+		if(fpng::fpng_encode_image_to_memory(pixels.data(), width, height, 3, candidate, fpng::FPNG_ENCODE_SLOWER) && (recompressed.empty() || candidate.size() < recompressed.size()))
+		{
+			recompressed.swap(candidate);
+		}
+		if(recompressed.empty() || recompressed.size() + EmptyChunkLength >= originalSize)
+		{
+			return 0;
+		}
+		markAsRecompressed(recompressed);
+	}
+	catch(const std::bad_alloc&)
+	{
+		// the game needs the memory more than we do, the file is left as it is.
+		IGCS::Utils::logLineToReshade(reshade::log::level::warning, "Not enough memory to recompress '%s', the file is left as it is.", filename.c_str());
+		return 0;
+	}
+	// written next to the original and moved over it, so the original is either intact or replaced by the complete file.
+	const std::string temporaryFilename = filename + ".tmp";
+	if(!writeFile(temporaryFilename, recompressed) || !MoveFileExA(temporaryFilename.c_str(), filename.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH))
+	{
+		DeleteFileA(temporaryFilename.c_str());
+		return 0;
+	}
+	return (uint64_t)(originalSize - recompressed.size());
+}
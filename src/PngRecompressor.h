@@ -0,0 +1,84 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "WorkerPool.h"
+
+/// <summary>
+/// Recompresses the png files written by fpng in a folder with stronger deflate settings, in the background after a session. The work is spread
+/// over all cores, on threads running in background mode so they get CPU time and disk access only when nothing else wants it. A file is
+/// only replaced if the result is smaller, and it's replaced in a single move, so the folder never contains a partially written png.
+/// </summary>
+class PngRecompressor
+{
+public:
+	PngRecompressor();
+	PngRecompressor(const PngRecompressor&) = delete;
+	PngRecompressor& operator=(const PngRecompressor&) = delete;
+
+	/// <summary>
+	/// Queues the recompression of the png files in the folder specified and returns right away. The result is logged when all files are done.
+	/// </summary>
+	void recompressFolder(const std::string& folder);
+	/// <summary>
+	/// Stops the recompression after the files being recompressed and waits for the threads to end. Files which weren't recompressed yet are left as they are.
+	/// </summary>
+	void shutdown() { _workers.shutdown(); }
+
+private:
+	// the state of the recompression of a folder, shared by the jobs working on it.
+	struct FolderState
+	{
+		std::string folder;
+		std::vector<std::string> filenames;
+		std::atomic<size_t> nextFile = 0;
+		std::atomic<int> numberOfJobsRunning = 0;
+		std::atomic<int> numberOfFilesReplaced = 0;
+		std::atomic<uint64_t> bytesSaved = 0;
+	};
+
+	static void recompressFiles(const std::shared_ptr<FolderState>& folderState, const CancellationToken& cancellationToken);
+	/// <summary>
+	/// Recompresses the file specified if it was written by fpng, wasn't recompressed before and isn't larger than the pixel budget. Returns the number
+	/// of bytes saved, 0 if the file wasn't replaced.
+	/// </summary>
+	static uint64_t recompressFile(const std::string& filename);
+
+	int _numberOfWorkers;
+	WorkerPool _workers;
+};
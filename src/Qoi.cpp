@@ -0,0 +1,364 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+#include "Qoi.h"
+#include <cstdio>
+#include <cstring>
+
+namespace IGCS::Qoi
+{
+	namespace
+	{
+		constexpr uint8_t OpIndex = 0x00;
+		constexpr uint8_t OpDiff = 0x40;
+		constexpr uint8_t OpLuma = 0x80;
+		constexpr uint8_t OpRun = 0xc0;
+		constexpr uint8_t OpRGB = 0xfe;
+		constexpr uint8_t OpRGBA = 0xff;
+		constexpr uint8_t OpMask = 0xc0;
+		constexpr int HeaderSize = 14;
+		constexpr uint8_t EndMarker[8] = { 0, 0, 0, 0, 0, 0, 0, 1 };
+		// The maximum number of bytes written for a pixel: the pending run's OpRun followed by an OpRGBA.
+		constexpr size_t MaxEncodedPixelSize = 1 + 5;
+		// QOI limits the number of pixels to 400 million so a decoder can't be tricked into allocating an absurd amount of memory.
+		constexpr uint64_t MaxNumberOfPixels = 400000000;
+
+		union Pixel
+		{
+			struct
+			{
+				uint8_t r, g, b, a;
+			} channels;
+			uint32_t value;
+		};
+
+		inline int hashPixel(const Pixel& pixel)
+		{
+			return (pixel.channels.r * 3 + pixel.channels.g * 5 + pixel.channels.b * 7 + pixel.channels.a * 11) % 64;
+		}
+
+		inline void writeBigEndian32(uint8_t* destination, uint32_t value)
+		{
+			destination[0] = (uint8_t)(value >> 24);
+			destination[1] = (uint8_t)(value >> 16);
+			destination[2] = (uint8_t)(value >> 8);
+			destination[3] = (uint8_t)value;
+		}
+
+		inline uint32_t readBigEndian32(const uint8_t* source)
+		{
+			return ((uint32_t)source[0] << 24) | ((uint32_t)source[1] << 16) | ((uint32_t)source[2] << 8) | source[3];
+		}
+
+
+		/// <summary>
+		/// Sink which appends the encoded data to a vector.
+		/// </summary>
+		class VectorSink
+		{
+		public:
+			VectorSink(std::vector<uint8_t>& destination) : _destination(destination) {}
+
+			void write(const uint8_t* data, size_t size) { _destination.insert(_destination.end(), data, data + size); }
+			bool succeeded() const { return true; }
+
+		private:
+			std::vector<uint8_t>& _destination;
+		};
+
+
+		/// <summary>
+		/// Sink which writes the encoded data to a file.
+		/// </summary>
+		class FileSink
+		{
+		public:
+			FileSink(FILE* file) : _file(file) {}
+
+			void write(const uint8_t* data, size_t size) { _succeeded &= (fwrite(data, 1, size, _file) == size); }
+			bool succeeded() const { return _succeeded; }
+
+		private:
+			FILE* _file;
+			bool _succeeded = true;
+		};
+
+
+		/// <summary>
+		/// Encodes the image in a single pass and writes the result to the sink in blocks of at most BufferSize bytes.
+		/// </summary>
+		template<typename Sink>
+		bool encode(Sink& sink, const uint8_t* data, int width, int height, int numberOfChannels)
+		{
+			constexpr size_t BufferSize = 64 * 1024;
+			if(nullptr == data || width <= 0 || height <= 0 || (numberOfChannels != 3 && numberOfChannels != 4) || (uint64_t)width * height > MaxNumberOfPixels)
+			{
+				return false;
+			}
+
+			uint8_t buffer[BufferSize];
+			size_t bufferUsed = 0;
+
+			buffer[0] = 'q';
+			buffer[1] = 'o';
+			buffer[2] = 'i';
+			buffer[3] = 'f';
+			writeBigEndian32(buffer + 4, (uint32_t)width);
+			writeBigEndian32(buffer + 8, (uint32_t)height);
+			buffer[12] = (uint8_t)numberOfChannels;
+			buffer[13] = 0;		// sRGB with linear alpha
+			bufferUsed = HeaderSize;
+
+			Pixel index[64];
+			memset(index, 0, sizeof(index));
+			Pixel previous;
+			previous.value = 0;
+			previous.channels.a = 255;
+			Pixel current = previous;
+			int run = 0;
+			const size_t numberOfPixels = (size_t)width * height;
+			const uint8_t* source = data;
+			for(size_t i = 0; i < numberOfPixels; ++i, source += numberOfChannels)
+			{
+				if(bufferUsed > BufferSize - MaxEncodedPixelSize)
+				{
+					sink.write(buffer, bufferUsed);
+					bufferUsed = 0;
+				}
+				current.channels.r = source[0];
+				current.channels.g = source[1];
+				current.channels.b = source[2];
+				if(numberOfChannels == 4)
+				{
+					current.channels.a = source[3];
+				}
+
+				if(current.value == previous.value)
+				{
+					run++;
+					if(run == 62 || i == numberOfPixels - 1)
+					{
+						buffer[bufferUsed++] = OpRun | (uint8_t)(run - 1);
+						run = 0;
+					}
+					continue;
+				}
+				if(run > 0)
+				{
+					buffer[bufferUsed++] = OpRun | (uint8_t)(run - 1);
+					run = 0;
+				}
+
+				const int indexPosition = hashPixel(current);
+				if(index[indexPosition].value == current.value)
+				{
+					buffer[bufferUsed++] = OpIndex | (uint8_t)indexPosition;
+				}
+				else
+				{
+					index[indexPosition] = current;
+					if(current.channels.a == previous.channels.a)
+					{
+						const int8_t vr = (int8_t)(current.channels.r - previous.channels.r);
+						const int8_t vg = (int8_t)(current.channels.g - previous.channels.g);
+						const int8_t vb = (int8_t)(current.channels.b - previous.channels.b);
+						const int8_t vgR = vr - vg;
+						const int8_t vgB = vb - vg;
+						if(vr > -3 && vr < 2 && vg > -3 && vg < 2 && vb > -3 && vb < 2)
+						{
+							buffer[bufferUsed++] = OpDiff | (uint8_t)((vr + 2) << 4 | (vg + 2) << 2 | (vb + 2));
+						}
+						else if(vgR > -9 && vgR < 8 && vg > -33 && vg < 32 && vgB > -9 && vgB < 8)
+						{
+							buffer[bufferUsed++] = OpLuma | (uint8_t)(vg + 32);
+							buffer[bufferUsed++] = (uint8_t)((vgR + 8) << 4 | (vgB + 8));
+						}
+						else
+						{
+							buffer[bufferUsed++] = OpRGB;
+							buffer[bufferUsed++] = current.channels.r;
+							buffer[bufferUsed++] = current.channels.g;
+							buffer[bufferUsed++] = current.channels.b;
+						}
+					}
+					else
+					{
+						buffer[bufferUsed++] = OpRGBA;
+						buffer[bufferUsed++] = current.channels.r;
+						buffer[bufferUsed++] = current.channels.g;
+						buffer[bufferUsed++] = current.channels.b;
+						buffer[bufferUsed++] = current.channels.a;
+					}
+				}
+				previous = current;
+			}
+			if(bufferUsed > BufferSize - sizeof(EndMarker))
+			{
+				sink.write(buffer, bufferUsed);
+				bufferUsed = 0;
+			}
+			memcpy(buffer + bufferUsed, EndMarker, sizeof(EndMarker));
+			bufferUsed += sizeof(EndMarker);
+			sink.write(buffer, bufferUsed);
+			return sink.succeeded();
+		}
+	}
+
+
+	bool encodeToMemory(std::vector<uint8_t>& destination, const uint8_t* data, int width, int height, int numberOfChannels)
+	{
+		destination.clear();
+		// worst case is every pixel as OpRGB(A), but a typical shot is less than half the raw size.
+		destination.reserve((size_t)width * height * numberOfChannels / 2);
+		VectorSink sink(destination);
+		return encode(sink, data, width, height, numberOfChannels);
+	}
+
+
+	bool encodeToFile(const std::string& filename, const uint8_t* data, int width, int height, int numberOfChannels)
+	{
+		FILE* file;
+		if(fopen_s(&file, filename.c_str(), "wb") != 0 || nullptr == file)
+		{
+			return false;
+		}
+		FileSink sink(file);
+		const bool succeeded = encode(sink, data, width, height, numberOfChannels);
+		return (fclose(file) == 0) && succeeded;
+	}
+
+
+	bool decode(const uint8_t* data, size_t size, std::vector<uint8_t>& pixels, int& width, int& height, int numberOfChannels)
+	{
+		pixels.clear();
+		if(nullptr == data || size < HeaderSize + sizeof(EndMarker) || (numberOfChannels != 3 && numberOfChannels != 4) || memcmp(data, "qoif", 4) != 0)
+		{
+			return false;
+		}
+		const uint32_t imageWidth = readBigEndian32(data + 4);
+		const uint32_t imageHeight = readBigEndian32(data + 8);
+		if(imageWidth == 0 || imageHeight == 0 || (data[12] != 3 && data[12] != 4) || (uint64_t)imageWidth * imageHeight > MaxNumberOfPixels)
+		{
+			return false;
+		}
+		width = (int)imageWidth;
+		height = (int)imageHeight;
+		const size_t numberOfPixels = (size_t)imageWidth * imageHeight;
+		pixels.resize(numberOfPixels * numberOfChannels);
+
+		Pixel index[64];
+		memset(index, 0, sizeof(index));
+		Pixel current;
+		current.value = 0;
+		current.channels.a = 255;
+		int run = 0;
+		size_t position = HeaderSize;
+		const size_t endOfChunks = size - sizeof(EndMarker);
+		uint8_t* destination = pixels.data();
+		for(size_t i = 0; i < numberOfPixels; ++i, destination += numberOfChannels)
+		{
+			if(run > 0)
+			{
+				run--;
+			}
+			else if(position < endOfChunks)
+			{
+				const uint8_t b1 = data[position++];
+				if(b1 == OpRGB)
+				{
+					if(position + 3 > endOfChunks)
+					{
+						return false;
+					}
+					current.channels.r = data[position++];
+					current.channels.g = data[position++];
+					current.channels.b = data[position++];
+				}
+				else if(b1 == OpRGBA)
+				{
+					if(position + 4 > endOfChunks)
+					{
+						return false;
+					}
+					current.channels.r = data[position++];
+					current.channels.g = data[position++];
+					current.channels.b = data[position++];
+					current.channels.a = data[position++];
+				}
+				else if((b1 & OpMask) == OpIndex)
+				{
+					current = index[b1];
+				}
+				else if((b1 & OpMask) == OpDiff)
+				{
+					current.channels.r += ((b1 >> 4) & 0x03) - 2;
+					current.channels.g += ((b1 >> 2) & 0x03) - 2;
+					current.channels.b += (b1 & 0x03) - 2;
+				}
+				else if((b1 & OpMask) == OpLuma)
+				{
+					if(position >= endOfChunks)
+					{
+						return false;
+					}
+					const uint8_t b2 = data[position++];
+					const int vg = (b1 & 0x3f) - 32;
+					current.channels.r += vg - 8 + ((b2 >> 4) & 0x0f);
+					current.channels.g += vg;
+					current.channels.b += vg - 8 + (b2 & 0x0f);
+				}
+				else
+				{
+					// OpRun
+					run = (b1 & 0x3f);
+				}
+				index[hashPixel(current)] = current;
+			}
+			else
+			{
+				// ran out of data
+				return false;
+			}
+
+			destination[0] = current.channels.r;
+			destination[1] = current.channels.g;
+			destination[2] = current.channels.b;
+			if(numberOfChannels == 4)
+			{
+				destination[3] = current.channels.a;
+			}
+		}
+		return true;
+	}
+}
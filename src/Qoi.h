@@ -0,0 +1,62 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Encoder / decoder for the QOI ('Quite OK Image') format, see https://qoiformat.org. Lossless, and much cheaper to encode than PNG: a single
+// pass over the pixels with a handful of compares per pixel, no entropy coding.
+namespace IGCS::Qoi
+{
+	/// <summary>
+	/// Encodes the image in data as a QOI file in destination. Existing contents of destination are replaced.
+	/// </summary>
+	/// <param name="data">the pixels, top to bottom, numberOfChannels bytes per pixel, rows aren't padded</param>
+	/// <param name="numberOfChannels">3 (RGB) or 4 (RGBA)</param>
+	/// <returns>true if the image was encoded, false otherwise</returns>
+	bool encodeToMemory(std::vector<uint8_t>& destination, const uint8_t* data, int width, int height, int numberOfChannels);
+	/// <summary>
+	/// Encodes the image in data as a QOI file and streams it to the file with the name specified, through a small buffer, so the encoded image
+	/// is never fully in memory.
+	/// </summary>
+	/// <returns>true if the file was written, false otherwise</returns>
+	bool encodeToFile(const std::string& filename, const uint8_t* data, int width, int height, int numberOfChannels);
+	/// <summary>
+	/// Decodes the QOI file in data to pixels with numberOfChannels (3 or 4) bytes per pixel. Existing contents of pixels are replaced.
+	/// </summary>
+	/// <returns>true if the file was decoded, false if it's not a valid QOI file</returns>
+	bool decode(const uint8_t* data, size_t size, std::vector<uint8_t>& pixels, int& width, int& height, int numberOfChannels);
+}
@@ -0,0 +1,223 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+#include "QuiltAssembler.h"
+#include <algorithm>
+#include <cmath>
+#include <emmintrin.h>
+#include <thread>
+#include "Utils.h"
+
+namespace
+{
+	// the minimum number of view rows per thread, so we don't start threads for a couple of rows.
+	constexpr uint32_t MinimumNumberOfRowsPerBand = 16;
+
+	/// <summary>
+	/// destination[i] += source[i] * weight for count values, with source being 8 bit values. SSE2, which every x64 cpu has.
+	/// </summary>
+	void accumulateWeightedRow(float* destination, const uint8_t* source, size_t count, float weight)
+	{
+		const __m128 weights = _mm_set1_ps(weight);
+		const __m128i zero = _mm_setzero_si128();
+		size_t i = 0;
+		for(; i + 16 <= count; i += 16)
+		{
+			const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+			const __m128i low = _mm_unpacklo_epi8(bytes, zero);
+			const __m128i high = _mm_unpackhi_epi8(bytes, zero);
+			const __m128 values0 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(low, zero));
+			const __m128 values1 = _mm_cvtepi32_ps(_mm_unpackhi_epi16(low, zero));
+			const __m128 values2 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(high, zero));
+			const __m128 values3 = _mm_cvtepi32_ps(_mm_unpackhi_epi16(high, zero));
+			_mm_storeu_ps(destination + i, _mm_add_ps(_mm_loadu_ps(destination + i), _mm_mul_ps(values0, weights)));
+			_mm_storeu_ps(destination + i + 4, _mm_add_ps(_mm_loadu_ps(destination + i + 4), _mm_mul_ps(values1, weights)));
+			_mm_storeu_ps(destination + i + 8, _mm_add_ps(_mm_loadu_ps(destination + i + 8), _mm_mul_ps(values2, weights)));
+			_mm_storeu_ps(destination + i + 12, _mm_add_ps(_mm_loadu_ps(destination + i + 12), _mm_mul_ps(values3, weights)));
+		}
+		for(; i < count; i++)
+		{
+			destination[i] += source[i] * weight;
+		}
+	}
+
+
+	inline float getSpanPixelWeight(uint32_t index, uint32_t count, float firstWeight, float lastWeight)
+	{
+		return index == 0 ? firstWeight : (index == count - 1 ? lastWeight : 1.0f);
+	}
+}
+
+
+bool QuiltAssembler::begin(uint32_t shotWidth, uint32_t shotHeight, int numberOfColumns, int numberOfRows, uint32_t viewWidth, uint32_t viewHeight)
+{
+	clear();
+	if(shotWidth == 0 || shotHeight == 0 || numberOfColumns < 1 || numberOfRows < 1 || viewWidth == 0 || viewHeight == 0 || viewWidth > shotWidth || viewHeight > shotHeight)
+	{
+		return false;
+	}
+	_shotWidth = shotWidth;
+	_shotHeight = shotHeight;
+	_numberOfColumns = numberOfColumns;
+	_numberOfRows = numberOfRows;
+	_viewWidth = viewWidth;
+	_viewHeight = viewHeight;
+	// use the largest centered part of the shot with the aspect ratio of a view.
+	const float viewAspectRatio = (float)viewWidth / (float)viewHeight;
+	float sourceWidth = (float)shotWidth;
+	float sourceHeight = (float)shotHeight;
+	if(sourceWidth / sourceHeight > viewAspectRatio)
+	{
+		sourceWidth = sourceHeight * viewAspectRatio;
+	}
+	else
+	{
+		sourceHeight = sourceWidth / viewAspectRatio;
+	}
+	calculateSpans(_horizontalSpans, viewWidth, 0.5f * (shotWidth - sourceWidth), sourceWidth, shotWidth);
+	calculateSpans(_verticalSpans, viewHeight, 0.5f * (shotHeight - sourceHeight), sourceHeight, shotHeight);
+	_quilt.assign((size_t)getQuiltWidth() * getQuiltHeight() * 3, 0);
+	return true;
+}
+
+
+void QuiltAssembler::addView(int viewIndex, const uint8_t* data, int maxNumberOfThreads)
+{
+	if(!isActive() || nullptr == data || viewIndex < 0 || viewIndex >= getNumberOfViews())
+	{
+		return;
+	}
+	// view 0 is at the bottom left, and the quilt's rows are stored top to bottom.
+	const uint32_t column = (uint32_t)(viewIndex % _numberOfColumns);
+	const uint32_t row = (uint32_t)(_numberOfRows - 1 - viewIndex / _numberOfColumns);
+	uint8_t* viewTopLeft = _quilt.data() + ((size_t)row * _viewHeight * getQuiltWidth() + (size_t)column * _viewWidth) * 3;
+
+	uint32_t numberOfBands = maxNumberOfThreads > 0 ? (uint32_t)maxNumberOfThreads : (std::max)(1u, std::thread::hardware_concurrency());
+	numberOfBands = (std::min)(numberOfBands, (std::max)(1u, _viewHeight / MinimumNumberOfRowsPerBand));
+	const uint32_t rowsPerBand = (_viewHeight + numberOfBands - 1) / numberOfBands;
+	// Band 0 is downscaled on the calling thread.
+	std::vector<std::thread> threads;
+	threads.reserve(numberOfBands - 1);
+	for(uint32_t i = 1; i < numberOfBands && i * rowsPerBand < _viewHeight; i++)
+	{
+		threads.emplace_back(&QuiltAssembler::downscaleRows, this, data, viewTopLeft, i * rowsPerBand, (std::min)(_viewHeight, (i + 1) * rowsPerBand));
+	}
+	downscaleRows(data, viewTopLeft, 0, (std::min)(_viewHeight, rowsPerBand));
+	for(auto& thread : threads)
+	{
+		thread.join();
+	}
+}
+
+
+void QuiltAssembler::clear()
+{
+	_quilt.clear();
+	_quilt.shrink_to_fit();
+	_horizontalSpans.clear();
+	_verticalSpans.clear();
+}
+
+
+std::string QuiltAssembler::getFilenameWithoutExtension() const
+{
+	return IGCS::Utils::formatString("Quilt_qs%dx%da%.4g", _numberOfColumns, _numberOfRows, (double)_viewWidth / (double)_viewHeight);
+}
+
+
+void QuiltAssembler::calculateSpans(std::vector<Span>& spans, uint32_t destinationSize, float sourceStart, float sourceSize, uint32_t numberOfSourcePixels)
+{
+	spans.resize(destinationSize);
+	const float scale = sourceSize / (float)destinationSize;
+	for(uint32_t i = 0; i < destinationSize; i++)
+	{
+		// the destination pixel covers the source interval [start, end)
+		const float start = sourceStart + i * scale;
+		const float end = sourceStart + (i + 1) * scale;
+		Span& span = spans[i];
+		// clamped, as rounding can put the end of the last pixel just past the source.
+		span.first = (std::min)((uint32_t)std::floor(start), numberOfSourcePixels - 1);
+		const uint32_t last = (std::min)((std::max)(span.first, (uint32_t)std::ceil(end) - 1), numberOfSourcePixels - 1);
+		span.count = last - span.first + 1;
+		if(span.count == 1)
+		{
+			span.firstWeight = end - start;
+			span.lastWeight = span.firstWeight;
+		}
+		else
+		{
+			span.firstWeight = (float)(span.first + 1) - start;
+			span.lastWeight = end - (float)last;
+		}
+		span.normalization = 1.0f / (end - start);
+	}
+}
+
+
+void QuiltAssembler::downscaleRows(const uint8_t* data, uint8_t* viewTopLeft, uint32_t firstRow, uint32_t endRow) const
+{
+	const size_t sourceRowSize = (size_t)_shotWidth * 3;
+	const size_t quiltRowSize = (size_t)getQuiltWidth() * 3;
+	std::vector<float> rowSums(sourceRowSize);
+	for(uint32_t y = firstRow; y < endRow; y++)
+	{
+		// first reduce the source rows of this view row to a single row, which is the bulk of the work, then the columns.
+		const Span& verticalSpan = _verticalSpans[y];
+		std::fill(rowSums.begin(), rowSums.end(), 0.0f);
+		for(uint32_t i = 0; i < verticalSpan.count; i++)
+		{
+			accumulateWeightedRow(rowSums.data(), data + (verticalSpan.first + i) * sourceRowSize, sourceRowSize,
+								  getSpanPixelWeight(i, verticalSpan.count, verticalSpan.firstWeight, verticalSpan.lastWeight));
+		}
+		uint8_t* destination = viewTopLeft + y * quiltRowSize;
+		for(uint32_t x = 0; x < _viewWidth; x++)
+		{
+			const Span& horizontalSpan = _horizontalSpans[x];
+			float sum[3] = { 0.0f, 0.0f, 0.0f };
+			for(uint32_t i = 0; i < horizontalSpan.count; i++)
+			{
+				const float weight = getSpanPixelWeight(i, horizontalSpan.count, horizontalSpan.firstWeight, horizontalSpan.lastWeight);
+				const float* pixel = rowSums.data() + (horizontalSpan.first + i) * 3;
+				sum[0] += pixel[0] * weight;
+				sum[1] += pixel[1] * weight;
+				sum[2] += pixel[2] * weight;
+			}
+			const float normalization = horizontalSpan.normalization * verticalSpan.normalization;
+			for(int c = 0; c < 3; c++)
+			{
+				destination[x * 3 + c] = (uint8_t)(std::min)(255.0f, sum[c] * normalization + 0.5f);
+			}
+		}
+	}
+}
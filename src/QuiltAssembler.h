@@ -0,0 +1,101 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Assembles the shots of a lightfield session into a quilt: a single image with the views in a grid, as used by Looking Glass displays.
+/// View 0 is the leftmost camera position and is placed at the bottom left of the quilt, the views after it go left to right, bottom to top.
+/// Every shot is area-downscaled to the view size. If the shot's aspect ratio differs from the view's, the center of the shot is used.
+/// </summary>
+class QuiltAssembler
+{
+public:
+	QuiltAssembler() = default;
+	QuiltAssembler(const QuiltAssembler&) = delete;
+	QuiltAssembler& operator=(const QuiltAssembler&) = delete;
+
+	/// <summary>
+	/// Clears the assembler and prepares a black quilt of numberOfColumns x numberOfRows views of viewWidth x viewHeight pixels, for RGB
+	/// shots of shotWidth x shotHeight pixels.
+	/// </summary>
+	/// <returns>true if the quilt was set up, false if one of the sizes is invalid</returns>
+	bool begin(uint32_t shotWidth, uint32_t shotHeight, int numberOfColumns, int numberOfRows, uint32_t viewWidth, uint32_t viewHeight);
+	/// <summary>
+	/// Downscales the RGB shot in data into view viewIndex of the quilt. Views can be added in any order and from multiple threads at once,
+	/// as long as no two threads add the same view. The rows of the view are spread over maxNumberOfThreads threads (0: one per hardware thread).
+	/// </summary>
+	void addView(int viewIndex, const uint8_t* data, int maxNumberOfThreads = 0);
+	/// <summary>
+	/// Releases the quilt.
+	/// </summary>
+	void clear();
+	bool isActive() const { return !_quilt.empty(); }
+	int getNumberOfViews() const { return _numberOfColumns * _numberOfRows; }
+	const uint8_t* getQuilt() const { return _quilt.data(); }
+	uint32_t getQuiltWidth() const { return _numberOfColumns * _viewWidth; }
+	uint32_t getQuiltHeight() const { return _numberOfRows * _viewHeight; }
+	/// <summary>
+	/// Returns the file name of the quilt without extension, with the quilt settings appended the way Looking Glass software reads them,
+	/// e.g. "Quilt_qs8x6a0.75".
+	/// </summary>
+	std::string getFilenameWithoutExtension() const;
+
+private:
+	// the part of a source row/column which contributes to a destination pixel: the source pixels [first, first + count), where the first
+	// and last pixel can be partially covered.
+	struct Span
+	{
+		uint32_t first = 0;
+		uint32_t count = 0;
+		float firstWeight = 0.0f;
+		float lastWeight = 0.0f;
+		float normalization = 0.0f;		// 1 / total weight
+	};
+
+	static void calculateSpans(std::vector<Span>& spans, uint32_t destinationSize, float sourceStart, float sourceSize, uint32_t numberOfSourcePixels);
+	void downscaleRows(const uint8_t* data, uint8_t* viewTopLeft, uint32_t firstRow, uint32_t endRow) const;
+
+	uint32_t _shotWidth = 0;
+	uint32_t _shotHeight = 0;
+	int _numberOfColumns = 0;
+	int _numberOfRows = 0;
+	uint32_t _viewWidth = 0;
+	uint32_t _viewHeight = 0;
+	std::vector<Span> _horizontalSpans;
+	std::vector<Span> _verticalSpans;
+	std::vector<uint8_t> _quilt;		// RGB
+};
@@ -35,10 +35,18 @@
 #include "CameraToolsConnector.h"
 #include <direct.h>
 #include "OverlayControl.h"
+#include "PixelPacking.h"
+#include "JpegWriter.h"
+#include "Qoi.h"
+#include "FrameSignature.h"
+#include "LightfieldIndex.h"
+#include <algorithm>
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include "std_image_write.h"
 #include "Utils.h"
-#include <thread>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
 
 #include "fpng.h"
 
@@ -47,7 +55,7 @@ ScreenshotController::ScreenshotController(CameraToolsConnector& connector) : _c
 }
 
 
-void ScreenshotController::configure(std::string rootFolder, int numberOfFramesToWaitBetweenSteps, ScreenshotFiletype filetype)
+void ScreenshotController::configure(const ScreenshotSettings& settings)
 {
 	if (_state != ScreenshotControllerState::Off)
 	{
@@ -56,9 +64,30 @@ void ScreenshotController::configure(std::string rootFolder, int numberOfFramesT
 	}
 	reset();
 
-	_rootFolder = rootFolder;
-	_numberOfFramesToWaitBetweenSteps = numberOfFramesToWaitBetweenSteps;
-	_filetype = filetype;
+	_rootFolder = settings.screenshotFolder;
+	_numberOfFramesToWaitBetweenSteps = settings.numberOfFramesToWaitBetweenSteps;
+	_adaptiveFrameWait = settings.adaptiveFrameWait;
+	_adaptiveFrameWaitMaxFrames = (std::max)(settings.adaptiveFrameWaitMaxFrames, settings.numberOfFramesToWaitBetweenSteps);
+	_adaptiveFrameWaitThreshold = (std::max)(settings.adaptiveFrameWaitThreshold, 0.0f);
+	_detectDuplicateFrames = settings.detectDuplicateFrames;
+	_maxDuplicateFrameRetries = (std::max)(settings.maxDuplicateFrameRetries, 0);
+	_filetype = (ScreenshotFiletype)settings.screenshotFileType;
+	_jpegQuality = std::clamp(settings.jpegQuality, 1, 100);
+	_jpegChromaSubsampling = (JpegChromaSubsampling)settings.jpegChromaSubsampling;
+	_y4mFramesPerSecond = std::clamp(settings.y4mFramesPerSecond, 1, 120);
+	_recompressPngsAfterSession = settings.recompressPngsAfterSession;
+	_generateThumbnails = settings.generateThumbnails;
+	_writeShotsWhileCapturing = settings.writeShotsWhileCapturing;
+	_maxNumberOfShotsInFlight = settings.maxNumberOfShotsInFlight < 1 ? 1 : settings.maxNumberOfShotsInFlight;
+	_shotMemoryBudgetInMB = settings.shotMemoryBudgetInMB < 1 ? 1 : settings.shotMemoryBudgetInMB;
+	_lightField_storeShotsAsDeltas = settings.lightField_storeShotsAsDeltas;
+	_lightField_maxShiftSearch = settings.lightField_maxShiftSearch < 0 ? 0 : settings.lightField_maxShiftSearch;
+	_pano_stitchShots = settings.pano_stitchShots;
+	_lightField_output = (LightfieldOutput)settings.lightField_output;
+	_lightField_quiltColumns = (std::max)(settings.lightField_quiltColumns, 1);
+	_lightField_quiltRows = (std::max)(settings.lightField_quiltRows, 1);
+	_lightField_quiltViewWidth = (std::max)(settings.lightField_quiltViewWidth, 1);
+	_lightField_quiltViewHeight = (std::max)(settings.lightField_quiltViewHeight, 1);
 }
 
 
@@ -69,12 +98,25 @@ bool ScreenshotController::shouldTakeShot()
 		// always false as we're still waiting
 		return false;
 	}
-	return _state == ScreenshotControllerState::InSession;
+	if(_state != ScreenshotControllerState::InSession)
+	{
+		return false;
+	}
+	if(shouldProcessShotsWhileCapturing())
+	{
+		// if the writer can't keep up, we'll postpone the shot till a grabbed shot has been processed, so memory usage stays capped.
+		return (int)_grabbedFrames.size() < _maxNumberOfShotsInFlight;
+	}
+	return true;
 }
 
 
 void ScreenshotController::presentCalled()
 {
+	if(_state == ScreenshotControllerState::InSession)
+	{
+		_framesWaitedForShot++;
+	}
 	if (_convolutionFrameCounter > 0)
 	{
 		_convolutionFrameCounter--;
@@ -92,16 +134,55 @@ void ScreenshotController::reshadeEffectsRendered(reshade::api::effect_runtime*
 	{
 		// take a screenshot
 		runtime->get_screenshot_width_and_height(&_framebufferWidth, &_framebufferHeight);
-		std::vector<uint8_t> shotData(_framebufferWidth * _framebufferHeight * 4);
+		prepareShotStaging();
+		// the settle check reads back only a region of the frame, so the whole frame is captured once, when it has settled.
+		bool frameSignatureCalculated = false;
+		if(_adaptiveFrameWait)
+		{
+			frameSignatureCalculated = _frameSignatureReadback.calculateSignature(runtime, _currentFrameSignature);
+			if(frameSignatureCalculated && !hasFrameSettled())
+			{
+				// not settled yet, check again next frame.
+				return;
+			}
+		}
+		// allocates the first buffers of the session on its first shot, after that it's a no-op as long as the resolution doesn't change.
+		_frameBufferPool.prepare(numberOfFrameBuffersToPrepare(), (size_t)_framebufferWidth * _framebufferHeight * 4);
+		FrameBuffer shotData = _frameBufferPool.acquire();
+		if(!shotData.isValid())
+		{
+			return;
+		}
+		const auto captureStart = std::chrono::steady_clock::now();
 		runtime->capture_screenshot(shotData.data());
+		const double captureMs = SessionTelemetry::getMillisecondsSince(captureStart);
+		if(_adaptiveFrameWait && !frameSignatureCalculated)
+		{
+			// the back buffer can't be read back directly, so the settle check needs the captured frame.
+			IGCS::FrameSignature::calculateLumaSignature(shotData.data(), _framebufferWidth, _framebufferHeight, (size_t)_framebufferWidth * 4, false, _currentFrameSignature);
+			if(!hasFrameSettled())
+			{
+				// not settled yet, check again next frame. The buffer goes back to the pool.
+				return;
+			}
+		}
 
 		// as alpha is 0 anyway, we pack the RGBA data as RGB data. This is faster than setting all alpha channels to FF.
-		// From Reshade
-		for(int i = 0; i < _framebufferWidth * _framebufferHeight; ++i)
+		// This is done on the render thread so it's vectorized where possible.
+		const auto packStart = std::chrono::steady_clock::now();
+		IGCS::PixelPacking::packRGBAToRGB(shotData.data(), (size_t)_framebufferWidth * _framebufferHeight);
+		if(_detectDuplicateFrames && isDuplicateOfPreviousShot(shotData.data()))
 		{
-			*reinterpret_cast<uint32_t*>(shotData.data() + 3 * i) = *reinterpret_cast<const uint32_t*>(shotData.data() + 4 * i);
+			// the camera step hasn't made it to the screen yet, so wait for the step again and grab the shot again. The buffer goes back to the pool.
+			// the retake is settle checked from scratch, like a shot after a camera move.
+			_convolutionFrameCounter = (std::max)(_numberOfFramesToWaitBetweenSteps, 1);
+			_adaptiveFrameWaitCounter = 0;
+			_previousFrameSignature.clear();
+			return;
 		}
-		storeGrabbedShot(shotData);
+		_telemetry.recordGrab(_shotCounter, _framesWaitedForShot, captureMs, SessionTelemetry::getMillisecondsSince(packStart));
+		_framesWaitedForShot = 0;
+		storeGrabbedShot(std::move(shotData));
 	}
 }
 
@@ -115,36 +196,90 @@ void ScreenshotController::cancelSession()
 	case ScreenshotControllerState::InSession:
 		_cameraToolsConnector.endScreenshotSession();
 		_state = ScreenshotControllerState::Canceling;
+		_sessionCancellationToken.cancel();
 		// kill the wait thread
-		_waitCompletionHandle.notify_all();
+		wakeCompletionThread();
 		break;
 	case ScreenshotControllerState::SavingShots:
 		_state = ScreenshotControllerState::Canceling;
+		_sessionCancellationToken.cancel();
+		// wake up the writer if it's waiting for shots
+		wakeCompletionThread();
 		break;
 	}
 }
 
 
-void ScreenshotController::completeShotSession()
+void ScreenshotController::completeShotSession(const CancellationToken& cancellationToken)
+{
+	// every type of session processes its shots in its own way, after that they all end the same way.
+	const ShotProcessor processShots = getShotProcessor();
+	(this->*processShots)(cancellationToken);
+	if(!cancellationToken.isCancellationRequested())
+	{
+		OverlayControl::addNotification(_isTestRun ? "Test run completed." : typeOfShotAsString() + " done.");
+		reportSessionTelemetry();
+		startPngRecompression();
+	}
+	// done
+	logFrameBufferPoolStatistics();
+	endSession();
+}
+
+
+ScreenshotController::ShotProcessor ScreenshotController::getShotProcessor()
+{
+	if(shouldStreamShotsToDisk())
+	{
+		// shots are written as soon as they're grabbed, so when this returns all shots are on disk.
+		return &ScreenshotController::saveGrabbedShotsWhileCapturing;
+	}
+	if(shouldAssembleTiles())
+	{
+		// tiles are written as soon as their row is complete, so when this returns the image is on disk.
+		return &ScreenshotController::assembleTilesWhileCapturing;
+	}
+	if(shouldCompositeViews())
+	{
+		// views are copied into the composed image as soon as they're grabbed.
+		return &ScreenshotController::compositeViewsWhileCapturing;
+	}
+	if(shouldAssembleQuilt())
+	{
+		// shots are downscaled into the quilt as soon as they're grabbed.
+		return &ScreenshotController::assembleQuiltWhileCapturing;
+	}
+	if(shouldStoreShotsAsDeltas())
+	{
+		return &ScreenshotController::saveGrabbedShotsAsDeltas;
+	}
+	return &ScreenshotController::saveGrabbedShotsAfterCapturing;
+}
+
+
+void ScreenshotController::saveGrabbedShotsAsDeltas(const CancellationToken& cancellationToken)
+{
+	// shots are delta compressed as soon as they're grabbed, so when this returns all shots are in the delta store.
+	storeGrabbedShotsAsDeltas(cancellationToken);
+	if(cancellationToken.isCancellationRequested())
+	{
+		return;
+	}
+	OverlayControl::addNotification("All " + typeOfShotAsString() + " shots have been taken. Writing shots to disk...");
+	saveLightfieldDeltas(cancellationToken);
+}
+
+
+void ScreenshotController::saveGrabbedShotsAfterCapturing(const CancellationToken& cancellationToken)
 {
-	const std::string shotTypeDescription = typeOfShotAsString();
 	// we'll wait now till all the shots are taken. 
 	waitForShots();
-	if(_state != ScreenshotControllerState::Canceling)
+	if(cancellationToken.isCancellationRequested() || _isTestRun)
 	{
-		if(_isTestRun)
-		{
-			OverlayControl::addNotification("Test run completed.");
-		}
-		else
-		{
-			OverlayControl::addNotification("All " + shotTypeDescription + " shots have been taken. Writing shots to disk...");
-			saveGrabbedShots();
-			OverlayControl::addNotification(shotTypeDescription + " done.");
-		}
+		return;
 	}
-	// done
-	reset();
+	OverlayControl::addNotification("All " + typeOfShotAsString() + " shots have been taken. Writing shots to disk...");
+	saveGrabbedShots(cancellationToken);
 }
 
 
@@ -173,6 +308,11 @@ void ScreenshotController::displayScreenshotSessionStartError(const ScreenshotSe
 bool ScreenshotController::startSession()
 {
 	uint8_t typeOfShotToUse = (uint8_t)_typeOfShot;
+	if(_typeOfShot == ScreenshotType::TiledGrid || _typeOfShot == ScreenshotType::Stereo)
+	{
+		// tiles and views are taken by moving the camera over a grid or a line, like a multishot.
+		typeOfShotToUse = (uint8_t)ScreenshotType::MultiShot;
+	}
 #ifdef _DEBUG
 	if(_typeOfShot==ScreenshotType::DebugGrid)
 	{
@@ -186,14 +326,18 @@ bool ScreenshotController::startSession()
 		displayScreenshotSessionStartError(sessionStartResult);
 		return false;
 	}
+	_telemetry.begin(_numberOfShotsToTake);
+	// every shot of the session can be waiting in the ring if they're all written after the last shot.
+	_grabbedFrames.reset(_numberOfShotsToTake);
 	return true;
 }
 
 
 void ScreenshotController::startHorizontalPanoramaShot(float totalFoVInDegrees, float overlapPercentagePerPanoShot, float currentFoVInDegrees, bool isTestRun)
 {
-	if(!_cameraToolsConnector.cameraToolsConnected())
+	if(!_cameraToolsConnector.cameraToolsConnected() || _state != ScreenshotControllerState::Off)
 	{
+		// no camera tools, or the previous session is still being completed.
 		return;
 	}
 
@@ -228,24 +372,29 @@ void ScreenshotController::startHorizontalPanoramaShot(float totalFoVInDegrees,
 	_convolutionFrameCounter = _numberOfFramesToWaitBetweenSteps;
 	_state = ScreenshotControllerState::InSession;
 
-	// Create a thread which will handle the end of the shot session as the shot taking is done by event handlers
-	std::thread t(&ScreenshotController::completeShotSession, this);
-	t.detach();
+	// the end of the shot session is handled on a worker, as the shot taking is done by event handlers
+	startCompletionJob();
 }
 
 
-void ScreenshotController::startLightfieldShot(float distancePerStep, int numberOfShots, bool isTestRun)
+void ScreenshotController::startLightfieldShot(float distancePerStep, int numberOfShotsPerRow, int numberOfRows, float verticalDistancePerStep, bool isTestRun)
 {
-	if(!_cameraToolsConnector.cameraToolsConnected())
+	if(!_cameraToolsConnector.cameraToolsConnected() || _state != ScreenshotControllerState::Off)
 	{
+		// no camera tools, or the previous session is still being completed.
 		return;
 	}
 
 	reset();
 	_isTestRun = isTestRun;
-	_lightField_distancePerStep = distancePerStep;
-	_numberOfShotsToTake = numberOfShots;
 	_typeOfShot = ScreenshotType::MultiShot;
+	_lightField_distancePerStep = distancePerStep;
+	_lightField_verticalDistancePerStep = verticalDistancePerStep;
+	_lightField_numberOfColumns = numberOfShotsPerRow;
+	// a quilt is a single row of views. This is also the case for a test run, so it moves the camera like the real session does, even though
+	// no quilt is assembled then.
+	_lightField_numberOfRows = _lightField_output == LightfieldOutput::Quilt ? 1 : (std::max)(numberOfRows, 1);
+	_numberOfShotsToTake = _lightField_numberOfColumns * _lightField_numberOfRows;
 
 	// tell the camera tools we're starting a session.
 	if(!startSession())
@@ -254,21 +403,108 @@ void ScreenshotController::startLightfieldShot(float distancePerStep, int number
 	}
 
 	// move to start
-	moveCameraForLightfield(-1, true);
+	if(isLightfieldGrid())
+	{
+		moveCameraForLightfieldGrid(0);
+	}
+	else
+	{
+		moveCameraForLightfield(-1, true);
+	}
 	// set convolution counter to its initial value
 	_convolutionFrameCounter = _numberOfFramesToWaitBetweenSteps;
 	_state = ScreenshotControllerState::InSession;
 
-	// Create a thread which will handle the end of the shot session as the shot taking is done by event handlers
-	std::thread t(&ScreenshotController::completeShotSession, this);
-	t.detach();
+	// the end of the shot session is handled on a worker, as the shot taking is done by event handlers
+	startCompletionJob();
+}
+
+
+void ScreenshotController::startTiledGridShot(int numberOfColumns, int numberOfRows, float horizontalDistancePerStep, float verticalDistancePerStep, float overlapPercentage, 
+											  float currentFoVInDegrees, bool isTestRun)
+{
+	if(!_cameraToolsConnector.cameraToolsConnected() || _state != ScreenshotControllerState::Off)
+	{
+		// no camera tools, or the previous session is still being completed.
+		return;
+	}
+
+	if(!isTestRun && !canAssembleTiles(_filetype))
+	{
+		// the tiled image is written a band at a time, which only bmp and png support. Writing another file type than the one selected isn't an option.
+		IGCS::Utils::logLineToReshade(reshade::log::level::warning, "A tiled grid can only be written as Bmp or Png. Select one of these file types to take a tiled grid.");
+		OverlayControl::addNotification("A tiled grid can only be written as Bmp or Png.");
+		return;
+	}
+
+	reset();
+	_isTestRun = isTestRun;
+	_tiled_numberOfColumns = (std::max)(numberOfColumns, 1);
+	_tiled_numberOfRows = (std::max)(numberOfRows, 1);
+	_tiled_horizontalDistancePerStep = horizontalDistancePerStep;
+	_tiled_verticalDistancePerStep = verticalDistancePerStep;
+	_tiled_overlapPercentage = overlapPercentage;
+	// the tiles together cover the current view, so every tile sees 1/columns of its width.
+	const float halfFoVInRadians = 0.5f * IGCS::Utils::degreesToRadians(currentFoVInDegrees);
+	_tiled_tileFoVInDegrees = 2.0f * IGCS::Utils::radiansToDegrees(std::atan(std::tan(halfFoVInRadians) / _tiled_numberOfColumns));
+	_numberOfShotsToTake = _tiled_numberOfColumns * _tiled_numberOfRows;
+	_typeOfShot = ScreenshotType::TiledGrid;
+
+	// tell the camera tools we're starting a session.
+	if(!startSession())
+	{
+		return;
+	}
+
+	// move to the first tile
+	moveCameraForTiledGrid(0);
+	// set convolution counter to its initial value
+	_convolutionFrameCounter = _numberOfFramesToWaitBetweenSteps;
+	_state = ScreenshotControllerState::InSession;
+
+	// the end of the shot session is handled on a worker, as the shot taking is done by event handlers
+	startCompletionJob();
+}
+
+
+void ScreenshotController::startStereoShot(int numberOfViews, float distanceBetweenViews, ViewLayout layout, bool reverseViews, bool isTestRun)
+{
+	if(!_cameraToolsConnector.cameraToolsConnected() || _state != ScreenshotControllerState::Off)
+	{
+		// no camera tools, or the previous session is still being completed.
+		return;
+	}
+
+	reset();
+	_isTestRun = isTestRun;
+	_stereo_distanceBetweenViews = distanceBetweenViews;
+	_stereo_layout = layout;
+	_stereo_reverseViews = reverseViews;
+	_numberOfShotsToTake = (std::max)(numberOfViews, 2);
+	_typeOfShot = ScreenshotType::Stereo;
+
+	// tell the camera tools we're starting a session.
+	if(!startSession())
+	{
+		return;
+	}
+
+	// move to the first view
+	moveCameraForStereo(0);
+	// set convolution counter to its initial value
+	_convolutionFrameCounter = _numberOfFramesToWaitBetweenSteps;
+	_state = ScreenshotControllerState::InSession;
+
+	// the end of the shot session is handled on a worker, as the shot taking is done by event handlers
+	startCompletionJob();
 }
 
 
 void ScreenshotController::startDebugGridShot()
 {
-	if(!_cameraToolsConnector.cameraToolsConnected())
+	if(!_cameraToolsConnector.cameraToolsConnected() || _state != ScreenshotControllerState::Off)
 	{
+		// no camera tools, or the previous session is still being completed.
 		return;
 	}
 
@@ -292,9 +528,8 @@ void ScreenshotController::startDebugGridShot()
 	_convolutionFrameCounter = _numberOfFramesToWaitBetweenSteps;
 	_state = ScreenshotControllerState::InSession;
 
-	// Create a thread which will handle the end of the shot session as the shot taking is done by event handlers
-	std::thread t(&ScreenshotController::completeShotSession, this);
-	t.detach();
+	// the end of the shot session is handled on a worker, as the shot taking is done by event handlers
+	startCompletionJob();
 }
 
 
@@ -307,6 +542,7 @@ std::string ScreenshotController::createScreenshotFolder()
 	std::string folderName = IGCS::Utils::formatString("%s%s%s-%.4d-%.2d-%.2d-%.2d-%.2d-%.2d", _rootFolder.c_str(), optionalBackslash.c_str(), typeOfShotAsString().c_str(), 
 													   (tm.tm_year + 1900), (tm.tm_mon + 1), tm.tm_mday, tm.tm_hour, tm.tm_min, tm.tm_sec);
 	_mkdir(folderName.c_str());
+	_sessionFolder = folderName;
 	return folderName;
 }
 
@@ -320,7 +556,22 @@ void ScreenshotController::modifyCamera()
 		moveCameraForPanorama(1, false);
 		break;
 	case ScreenshotType::MultiShot:
-		moveCameraForLightfield(1, false);
+		if(isLightfieldGrid())
+		{
+			// the shot counter is the index of the next view.
+			moveCameraForLightfieldGrid(_shotCounter);
+		}
+		else
+		{
+			moveCameraForLightfield(1, false);
+		}
+		break;
+	case ScreenshotType::TiledGrid:
+		// the shot counter is the index of the next tile.
+		moveCameraForTiledGrid(_shotCounter);
+		break;
+	case ScreenshotType::Stereo:
+		moveCameraForStereo(_shotCounter);
 		break;
 #ifdef _DEBUG
 	case ScreenshotType::DebugGrid:
@@ -341,6 +592,10 @@ std::string ScreenshotController::typeOfShotAsString()
 		return "HorizontalPanorama";
 	case ScreenshotType::MultiShot:
 		return "Lightfield";
+	case ScreenshotType::TiledGrid:
+		return "TiledGrid";
+	case ScreenshotType::Stereo:
+		return "Stereo";
 #ifdef _DEBUG
 	case ScreenshotType::DebugGrid:
 		return "DebugGrid";
@@ -364,6 +619,86 @@ void ScreenshotController::moveCameraForLightfield(int direction, bool end)
 }
 
 
+void ScreenshotController::moveCameraForLightfieldGrid(int shotIndex)
+{
+	int row = 0;
+	int column = 0;
+	getLightfieldGridPosition(shotIndex, row, column);
+	float horizontalStep = 0.0f;
+	float verticalStep = 0.0f;
+	getLightfieldCameraOffset(row, column, horizontalStep, verticalStep);
+	// we don't know the movement speed, so we pass the distance to the camera, and the camera has to divide by movement speed so it's independent of movement speed.
+	// the steps are relative to the start position, so rounding errors don't add up over the rows. We don't change the fov.
+	_cameraToolsConnector.moveCameraMultishot(horizontalStep, verticalStep, 0.0f, true);
+}
+
+
+void ScreenshotController::getLightfieldGridPosition(int shotIndex, int& row, int& column)
+{
+	// the rows are visited top to bottom in serpentine order: left to right, then right to left on the next row, etc., so the camera never has
+	// to travel back over the full width of the grid.
+	row = shotIndex / _lightField_numberOfColumns;
+	column = shotIndex % _lightField_numberOfColumns;
+	if((row % 2) == 1)
+	{
+		column = _lightField_numberOfColumns - 1 - column;
+	}
+}
+
+
+void ScreenshotController::getLightfieldCameraOffset(int row, int column, float& horizontalOffset, float& verticalOffset)
+{
+	if(isLightfieldGrid())
+	{
+		// the grid is centered around the start position.
+		horizontalOffset = (column - 0.5f * (_lightField_numberOfColumns - 1)) * _lightField_distancePerStep;
+		verticalOffset = (0.5f * (_lightField_numberOfRows - 1) - row) * _lightField_verticalDistancePerStep;
+		return;
+	}
+	// moveCameraForLightfield starts half the number of shots to the left and steps right.
+	horizontalOffset = (column - 0.5f * _numberOfShotsToTake) * _lightField_distancePerStep;
+	verticalOffset = 0.0f;
+}
+
+
+void ScreenshotController::writeLightfieldIndex(const std::string& destinationFolder)
+{
+	if(_typeOfShot != ScreenshotType::MultiShot || _isTestRun)
+	{
+		return;
+	}
+	IGCS::LightfieldIndex::LightfieldLayout layout;
+	layout.numberOfColumns = _lightField_numberOfColumns;
+	layout.numberOfRows = _lightField_numberOfRows;
+	layout.horizontalDistanceBetweenViews = _lightField_distancePerStep;
+	layout.verticalDistanceBetweenViews = _lightField_numberOfRows > 1 ? _lightField_verticalDistancePerStep : 0.0f;
+	layout.viewWidth = _framebufferWidth;
+	layout.viewHeight = _framebufferHeight;
+	if(_filetype == ScreenshotFiletype::Y4m)
+	{
+		layout.container = "Shots.y4m";
+	}
+	std::vector<IGCS::LightfieldIndex::LightfieldView> views;
+	for(int i = 0; i < _numberOfShotsToTake; i++)
+	{
+		IGCS::LightfieldIndex::LightfieldView view;
+		view.frameNumber = i;
+		getLightfieldGridPosition(i, view.row, view.column);
+		getLightfieldCameraOffset(view.row, view.column, view.x, view.y);
+		if(layout.container.empty())
+		{
+			view.file = getShotFilenameWithoutExtension(i) + getImageFileExtension();
+		}
+		views.push_back(view);
+	}
+	const std::string indexFilename = destinationFolder + "\\Lightfield.json";
+	if(!IGCS::LightfieldIndex::writeIndexFile(indexFilename, layout, views))
+	{
+		IGCS::Utils::logLineToReshade(reshade::log::level::warning, "Couldn't write the lightfield index to '%s'.", indexFilename.c_str());
+	}
+}
+
+
 void ScreenshotController::moveCameraForPanorama(int direction, bool end)
 {
 	float distance = direction * _pano_anglePerStep;
@@ -376,6 +711,29 @@ void ScreenshotController::moveCameraForPanorama(int direction, bool end)
 }
 
 
+void ScreenshotController::moveCameraForTiledGrid(int tileIndex)
+{
+	// tiles are taken left to right, top to bottom, around the start position of the camera.
+	const int column = tileIndex % _tiled_numberOfColumns;
+	const int row = tileIndex / _tiled_numberOfColumns;
+	const float horizontalStep = (column - 0.5f * (_tiled_numberOfColumns - 1)) * _tiled_horizontalDistancePerStep;
+	const float verticalStep = (0.5f * (_tiled_numberOfRows - 1) - row) * _tiled_verticalDistancePerStep;
+	// we don't know the movement speed, so we pass the distance to the camera, and the camera has to divide by movement speed so it's independent of movement speed.
+	// the steps are relative to the start position, so rounding errors don't add up over the tiles.
+	_cameraToolsConnector.moveCameraMultishot(horizontalStep, verticalStep, _tiled_tileFoVInDegrees, true);
+}
+
+
+void ScreenshotController::moveCameraForStereo(int viewIndex)
+{
+	// the views are taken left to right on a line centered on the start position, so for 2 views the eyes are half the distance left and right of it.
+	const float horizontalStep = (viewIndex - 0.5f * (_numberOfShotsToTake - 1)) * _stereo_distanceBetweenViews;
+	// we don't know the movement speed, so we pass the distance to the camera, and the camera has to divide by movement speed so it's independent of movement speed.
+	// the step is relative to the start position, and we don't move up/down or change the fov.
+	_cameraToolsConnector.moveCameraMultishot(horizontalStep, 0.0f, 0.0f, true);
+}
+
+
 void ScreenshotController::moveCameraForDebugGrid(int shotCounter, bool end)
 {
 	float horizontalStep = 0.0f;
@@ -398,34 +756,61 @@ void ScreenshotController::moveCameraForDebugGrid(int shotCounter, bool end)
 }
 
 
-void ScreenshotController::storeGrabbedShot(std::vector<uint8_t> grabbedShot)
+void ScreenshotController::storeGrabbedShot(FrameBuffer grabbedShot)
 {
-	if(grabbedShot.size() <= 0)
+	if(!grabbedShot.isValid())
 	{
 		// failed
 		return;
 	}
+	_frameBufferPool.recordStoredShot();
+
+	const bool useScratchFile = !_isTestRun && _scratchFile.isOpen();
+	if(useScratchFile)
+	{
+		// the shots don't fit in memory, so copy the shot to the scratch file. The buffer is reused for the next shot. Every shot has its own
+		// slot, so the shots after a shot which couldn't be stored keep their frame number.
+		if(_scratchFile.storeFrame(_shotCounter, grabbedShot.data()))
+		{
+			_shotIsInScratchFile[_shotCounter] = true;
+			_numberOfShotsInScratchFile++;
+		}
+		else
+		{
+			IGCS::Utils::logLineToReshade(reshade::log::level::error, "Couldn't store shot %d in the scratch file. The shot is skipped.", _shotCounter);
+		}
+	}
 
-	_grabbedFrames.push_back(grabbedShot);
+	if(!_isTestRun && !useScratchFile)
+	{
+		// test runs don't write anything so there's no need to keep the shot around. The ring is sized for all shots of the session, 
+		// so this only fails if something's seriously wrong.
+		if(!_grabbedFrames.tryPush(std::move(grabbedShot)))
+		{
+			IGCS::Utils::logLineToReshade(reshade::log::level::error, "Couldn't hand shot %d to the writer. The shot is skipped.", _shotCounter);
+		}
+	}
 	_shotCounter++;
 	if(_shotCounter >= _numberOfShotsToTake)
 	{
 		// we're done. Move to the next state, which is saving shots. 
 		_state = ScreenshotControllerState::SavingShots;
-		// tell the waiting thread to wake up so the system can proceed as normal.
-		_waitCompletionHandle.notify_all();
 	}
-	else
+	// tell the waiting thread to wake up so it can write the shot or, if we're done, so the system can proceed as normal.
+	wakeCompletionThread();
+	if(_state == ScreenshotControllerState::InSession)
 	{
 		modifyCamera();
 		_convolutionFrameCounter = _numberOfFramesToWaitBetweenSteps;
+		_adaptiveFrameWaitCounter = 0;
+		_previousFrameSignature.clear();
 	}
 }
 
 
-void ScreenshotController::saveGrabbedShots()
+void ScreenshotController::saveGrabbedShots(const CancellationToken& cancellationToken)
 {
-	if(_grabbedFrames.size() <= 0)
+	if(_grabbedFrames.empty() && _numberOfShotsInScratchFile <= 0)
 	{
 		return;
 	}
@@ -433,48 +818,762 @@ void ScreenshotController::saveGrabbedShots()
 	{
 		_state = ScreenshotControllerState::SavingShots;
 		const std::string destinationFolder = createScreenshotFolder();
+		beginPanorama();
+		for(int shotIndex = 0; shotIndex < (int)_shotIsInScratchFile.size() && !cancellationToken.isCancellationRequested(); shotIndex++)
+		{
+			if(!_shotIsInScratchFile[shotIndex])
+			{
+				// couldn't be stored, which has been logged when the shot was taken.
+				continue;
+			}
+			// only one shot is mapped at a time, so the OS can evict the pages of the shots we've written.
+			const MappedFrame frame = _scratchFile.mapFrame(shotIndex);
+			if(!frame.isValid())
+			{
+				IGCS::Utils::logLineToReshade(reshade::log::level::error, "Couldn't read shot %d from the scratch file. The shot is skipped.", shotIndex);
+				continue;
+			}
+			saveShotToFile(destinationFolder, frame.data(), shotIndex);
+			addShotToPanorama(frame.data(), shotIndex);
+			addShotToFilmstrip(frame.data(), shotIndex);
+		}
+		// the ring is sized for all shots of the session, so it holds every shot taken, in order.
 		int frameNumber = 0;
-		for(const std::vector<uint8_t>& frame : _grabbedFrames)
+		FrameBuffer frame;
+		while(!cancellationToken.isCancellationRequested() && _grabbedFrames.tryPop(frame))
 		{
-			saveShotToFile(destinationFolder, frame, frameNumber);
+			saveShotToFile(destinationFolder, frame.data(), frameNumber);
+			addShotToPanorama(frame.data(), frameNumber);
+			addShotToFilmstrip(frame.data(), frameNumber);
 			frameNumber++;
+			// the shot has been written, so its memory can go.
+			frame.release();
+		}
+		closeFrameContainer();
+		_sessionManifest.close(cancellationToken.isCancellationRequested());
+		if(!cancellationToken.isCancellationRequested())
+		{
+			savePanorama(destinationFolder);
+			writeLightfieldIndex(destinationFolder);
 		}
 	}
 }
 
 
-void ScreenshotController::saveShotToFile(std::string destinationFolder, const std::vector<uint8_t>& data, int frameNumber)
+void ScreenshotController::saveGrabbedShotsWhileCapturing(const CancellationToken& cancellationToken)
 {
-	std::string filename = "";
+	std::string destinationFolder = "";
+	processGrabbedShotsWhileCapturing(cancellationToken, [&](const uint8_t* data, int frameNumber)
+		{
+			if(destinationFolder.empty())
+			{
+				destinationFolder = createScreenshotFolder();
+				beginPanorama();
+			}
+			saveShotToFile(destinationFolder, data, frameNumber);
+			addShotToPanorama(data, frameNumber);
+		});
+	closeFrameContainer();
+	_sessionManifest.close(cancellationToken.isCancellationRequested());
+	if(!cancellationToken.isCancellationRequested() && !destinationFolder.empty())
+	{
+		savePanorama(destinationFolder);
+		writeLightfieldIndex(destinationFolder);
+	}
+}
+
+
+void ScreenshotController::storeGrabbedShotsAsDeltas(const CancellationToken& cancellationToken)
+{
+	processGrabbedShotsWhileCapturing(cancellationToken, [&](const uint8_t* data, int frameNumber)
+		{
+			if(frameNumber == 0)
+			{
+				// the framebuffer size is only known once the first shot has been grabbed.
+				_lightfieldDeltaStore.begin(_framebufferWidth, _framebufferHeight, _lightField_maxShiftSearch);
+			}
+			if(!_lightfieldDeltaStore.addFrame(data))
+			{
+				IGCS::Utils::logLineToReshade(reshade::log::level::error, "Couldn't delta compress shot %d. The shot is skipped.", frameNumber);
+			}
+		});
+}
+
+
+void ScreenshotController::saveLightfieldDeltas(const CancellationToken& cancellationToken)
+{
+	const int numberOfFrames = _lightfieldDeltaStore.getNumberOfFrames();
+	if(numberOfFrames <= 0)
+	{
+		return;
+	}
+	IGCS::Utils::logLineToReshade(reshade::log::level::info, "Lightfield shots were kept delta compressed in %llu MB instead of %llu MB.",
+								  (uint64_t)_lightfieldDeltaStore.getStoredSize() / (1024 * 1024), 
+								  (uint64_t)_lightfieldDeltaStore.getFrameSize() * numberOfFrames / (1024 * 1024));
+	const std::string destinationFolder = createScreenshotFolder();
+	// every shot is reconstructed from the shot before it, so we keep two buffers and swap them.
+	std::vector<uint8_t> previousFrame;
+	std::vector<uint8_t> frame;
+	for(int i = 0; i < numberOfFrames; i++)
+	{
+		if(cancellationToken.isCancellationRequested())
+		{
+			break;
+		}
+		if(!_lightfieldDeltaStore.reconstructFrame(i, previousFrame, frame))
+		{
+			// the shots after this one depend on it, so we can't continue.
+			IGCS::Utils::logLineToReshade(reshade::log::level::error, "Couldn't reconstruct lightfield shot %d. The remaining shots are skipped.", i);
+			break;
+		}
+		saveShotToFile(destinationFolder, frame.data(), i);
+		std::swap(previousFrame, frame);
+	}
+	closeFrameContainer();
+	_sessionManifest.close(cancellationToken.isCancellationRequested());
+	if(!cancellationToken.isCancellationRequested())
+	{
+		writeLightfieldIndex(destinationFolder);
+	}
+}
+
+
+void ScreenshotController::assembleQuiltWhileCapturing(const CancellationToken& cancellationToken)
+{
+	processGrabbedShotsWhileCapturing(cancellationToken, [&](const uint8_t* data, int frameNumber)
+		{
+			if(frameNumber == 0)
+			{
+				// the framebuffer size is only known once the first shot has been grabbed.
+				if(!_quiltAssembler.begin(_framebufferWidth, _framebufferHeight, _lightField_quiltColumns, _lightField_quiltRows, _lightField_quiltViewWidth, _lightField_quiltViewHeight))
+				{
+					IGCS::Utils::logLineToReshade(reshade::log::level::error, "Can't create a quilt with views of %dx%d pixels from shots of %ux%u pixels.",
+												  _lightField_quiltViewWidth, _lightField_quiltViewHeight, _framebufferWidth, _framebufferHeight);
+					return;
+				}
+				if(_quiltAssembler.getNumberOfViews() != _numberOfShotsToTake)
+				{
+					IGCS::Utils::logLineToReshade(reshade::log::level::warning, "The quilt has %d views but %d shots are taken. Views without a shot stay black, shots without a view are ignored.",
+												  _quiltAssembler.getNumberOfViews(), _numberOfShotsToTake);
+				}
+			}
+			// the view is the position of the shot in the grid, as the grid is visited in serpentine order. A quilt is a single row of shots,
+			// so this is the column.
+			int row = 0;
+			int column = 0;
+			getLightfieldGridPosition(frameNumber, row, column);
+			// the downscale of this view runs on all cores while the render thread is busy with the next view.
+			const auto downscaleStart = std::chrono::steady_clock::now();
+			_quiltAssembler.addView(row * _lightField_numberOfColumns + column, data);
+			_telemetry.recordSave(frameNumber, SessionTelemetry::getMillisecondsSince(downscaleStart), 0.0, 0);
+		});
+	if(!cancellationToken.isCancellationRequested())
+	{
+		saveQuilt();
+	}
+}
+
+
+void ScreenshotController::assembleTilesWhileCapturing(const CancellationToken& cancellationToken)
+{
+	processGrabbedShotsWhileCapturing(cancellationToken, [&](const uint8_t* data, int frameNumber)
+		{
+			if(frameNumber == 0)
+			{
+				// the framebuffer size is only known once the first shot has been grabbed.
+				const std::string destinationFolder = createScreenshotFolder();
+				const uint32_t imageWidth = _tiled_numberOfColumns * TileAssembler::getCroppedSize(_framebufferWidth, _tiled_overlapPercentage);
+				const uint32_t imageHeight = _tiled_numberOfRows * TileAssembler::getCroppedSize(_framebufferHeight, _tiled_overlapPercentage);
+				// png is written with fpng's stream encoder. The session isn't started for file types other than bmp and png.
+				const char* extension = _filetype == ScreenshotFiletype::Png ? "png" : "bmp";
+				const std::string filename = IGCS::Utils::formatString("%s\\Tiled_%ux%u.%s", destinationFolder.c_str(), imageWidth, imageHeight, extension);
+				if(!_tileAssembler.begin(filename, _framebufferWidth, _framebufferHeight, _tiled_numberOfColumns, _tiled_numberOfRows, _tiled_overlapPercentage))
+				{
+					IGCS::Utils::logLineToReshade(reshade::log::level::error, "Couldn't create '%s' for the tiles.", filename.c_str());
+					OverlayControl::addNotification("The tiled image couldn't be created.");
+					return;
+				}
+			}
+			const auto addStart = std::chrono::steady_clock::now();
+			_tileAssembler.addTile(frameNumber, data);
+			_telemetry.recordSave(frameNumber, 0.0, SessionTelemetry::getMillisecondsSince(addStart), 0);
+		});
+	if(!_tileAssembler.isActive())
+	{
+		return;
+	}
+	const uint32_t imageWidth = _tileAssembler.getImageWidth();
+	const uint32_t imageHeight = _tileAssembler.getImageHeight();
+	if(_tileAssembler.finish())
+	{
+		OverlayControl::addNotification(IGCS::Utils::formatString("Tiled image of %ux%u pixels saved.", imageWidth, imageHeight));
+	}
+	else if(!cancellationToken.isCancellationRequested())
+	{
+		IGCS::Utils::logLineToReshade(reshade::log::level::error, "Not all tiles of the %ux%u image could be written.", imageWidth, imageHeight);
+	}
+}
+
+
+void ScreenshotController::compositeViewsWhileCapturing(const CancellationToken& cancellationToken)
+{
+	processGrabbedShotsWhileCapturing(cancellationToken, [&](const uint8_t* data, int frameNumber)
+		{
+			if(frameNumber == 0)
+			{
+				// the framebuffer size is only known once the first shot has been grabbed.
+				if(!_viewCompositor.begin(_framebufferWidth, _framebufferHeight, _numberOfShotsToTake, _stereo_layout, _stereo_reverseViews))
+				{
+					IGCS::Utils::logLineToReshade(reshade::log::level::error, "Can't compose %d views of %ux%u pixels.", _numberOfShotsToTake, _framebufferWidth, _framebufferHeight);
+					return;
+				}
+			}
+			// the copy of this view runs on all cores while the render thread is busy with the next view.
+			const auto copyStart = std::chrono::steady_clock::now();
+			_viewCompositor.addView(frameNumber, data);
+			_telemetry.recordSave(frameNumber, SessionTelemetry::getMillisecondsSince(copyStart), 0.0, 0);
+		});
+	if(!cancellationToken.isCancellationRequested())
+	{
+		saveComposedViews();
+	}
+}
+
+
+void ScreenshotController::saveComposedViews()
+{
+	if(!_viewCompositor.isActive())
+	{
+		return;
+	}
+	const std::string destinationFolder = createScreenshotFolder();
+	const char* layoutName = _stereo_layout == ViewLayout::SideBySide ? "SideBySide" : "OverUnder";
+	const std::string filenameWithoutExtension = _numberOfShotsToTake == 2 ? IGCS::Utils::formatString("%s\\%s", destinationFolder.c_str(), layoutName)
+																		  : IGCS::Utils::formatString("%s\\%s_%dviews", destinationFolder.c_str(), layoutName, _numberOfShotsToTake);
+	// the composed image isn't a shot, so it's not part of the telemetry.
+	saveImageToFile(filenameWithoutExtension, _viewCompositor.getImage(), _viewCompositor.getImageWidth(), _viewCompositor.getImageHeight(), -1);
+	OverlayControl::addNotification(IGCS::Utils::formatString("%d views composed into an image of %ux%u pixels.", _numberOfShotsToTake, _viewCompositor.getImageWidth(), 
+															  _viewCompositor.getImageHeight()));
+}
+
+
+void ScreenshotController::saveQuilt()
+{
+	if(!_quiltAssembler.isActive())
+	{
+		return;
+	}
+	const std::string destinationFolder = createScreenshotFolder();
+	saveImageToFile(destinationFolder + "\\" + _quiltAssembler.getFilenameWithoutExtension(), _quiltAssembler.getQuilt(), _quiltAssembler.getQuiltWidth(), 
+					_quiltAssembler.getQuiltHeight(), -1);
+	OverlayControl::addNotification(IGCS::Utils::formatString("Quilt of %ux%u pixels saved.", _quiltAssembler.getQuiltWidth(), _quiltAssembler.getQuiltHeight()));
+}
+
+
+void ScreenshotController::processGrabbedShotsWhileCapturing(const CancellationToken& cancellationToken, const std::function<void(const uint8_t*, int)>& processShot)
+{
+	int frameNumber = 0;
+	bool sessionEnded = false;
+	for(;;)
+	{
+		FrameBuffer frame;
+		{
+			std::unique_lock lock(_waitCompletionMutex);
+			_waitCompletionHandle.wait(lock, [&] {return !_grabbedFrames.empty() || _state != ScreenshotControllerState::InSession || cancellationToken.isCancellationRequested(); });
+			if(_state != ScreenshotControllerState::InSession && !sessionEnded)
+			{
+				// all shots have been taken or the session was cancelled, so signal the tools the session ended. We'll write what's left after that.
+				_cameraToolsConnector.endScreenshotSession();
+				sessionEnded = true;
+			}
+			if(cancellationToken.isCancellationRequested() || !_grabbedFrames.tryPop(frame))
+			{
+				// cancelled or all shots have been written
+				break;
+			}
+		}
+		// a slot is free again, so the render thread can grab the next shot while we process this one.
+		processShot(frame.data(), frameNumber);
+		addShotToFilmstrip(frame.data(), frameNumber);
+		frameNumber++;
+		// hand the buffer back to the pool so the render thread can reuse it for the next shot.
+		frame.release();
+	}
+}
+
+
+void ScreenshotController::saveShotToFile(std::string destinationFolder, const uint8_t* data, int frameNumber)
+{
+	// not on frame 0, as that shot might be missing.
+	if(!_sessionManifest.isOpen())
+	{
+		openSessionManifest(destinationFolder);
+	}
+	SessionManifestShot shot;
+	shot.index = frameNumber;
+	getCameraStepForShot(frameNumber, shot.horizontalStep, shot.verticalStep);
+	if(_filetype == ScreenshotFiletype::Y4m)
+	{
+		shot.file = "Shots.y4m";
+		// frames are appended in order, but a missing shot leaves no gap in the container.
+		shot.frameInFile = _frameContainer.getNumberOfFrames();
+		shot.bytesWritten = appendShotToFrameContainer(destinationFolder, data, frameNumber);
+	}
+	else
+	{
+		shot.file = getShotFilenameWithoutExtension(frameNumber) + getImageFileExtension();
+		shot.bytesWritten = saveImageToFile(destinationFolder + "\\" + getShotFilenameWithoutExtension(frameNumber), data, _framebufferWidth, _framebufferHeight, frameNumber);
+	}
+	// only shots which are completely written are listed, so a tool reading the manifest never picks up a partial file.
+	if(shot.bytesWritten > 0)
+	{
+		_sessionManifest.recordShot(shot);
+	}
+}
+
+
+void ScreenshotController::openSessionManifest(const std::string& destinationFolder)
+{
+	SessionManifestHeader header;
+	header.typeOfShot = typeOfShotAsString();
+	header.fileType = _filetype == ScreenshotFiletype::Y4m ? "y4m" : getImageFileExtension().substr(1);
+	header.width = _framebufferWidth;
+	header.height = _framebufferHeight;
+	header.numberOfShots = _numberOfShotsToTake;
+	switch(_typeOfShot)
+	{
+	case ScreenshotType::HorizontalPanorama:
+		header.stepUnit = "radians";
+		header.parameters = { { "totalFoV", _pano_totalFoVRadians }, { "currentFoV", _pano_currentFoVRadians }, { "anglePerStep", _pano_anglePerStep }, 
+							  { "overlapPercentage", _overlapPercentagePerPanoShot } };
+		break;
+	case ScreenshotType::MultiShot:
+		header.stepUnit = "distance";
+		header.parameters = { { "distancePerStep", _lightField_distancePerStep }, { "verticalDistancePerStep", _lightField_verticalDistancePerStep }, 
+							  { "columns", (float)_lightField_numberOfColumns }, { "rows", (float)_lightField_numberOfRows } };
+		break;
+	default:
+		header.stepUnit = "distance";
+		break;
+	}
+	const std::string filename = destinationFolder + "\\Manifest.jsonl";
+	if(!_sessionManifest.open(filename, header))
+	{
+		IGCS::Utils::logLineToReshade(reshade::log::level::warning, "Couldn't create the session manifest '%s'.", filename.c_str());
+	}
+}
+
+
+void ScreenshotController::getCameraStepForShot(int frameNumber, float& horizontalStep, float& verticalStep)
+{
+	horizontalStep = 0.0f;
+	verticalStep = 0.0f;
+	switch(_typeOfShot)
+	{
+	case ScreenshotType::HorizontalPanorama:
+		// moveCameraForPanorama starts half the number of shots to the left and rotates right.
+		horizontalStep = (frameNumber - 0.5f * _numberOfShotsToTake) * _pano_anglePerStep;
+		break;
+	case ScreenshotType::MultiShot:
+		{
+			int row = 0;
+			int column = 0;
+			getLightfieldGridPosition(frameNumber, row, column);
+			getLightfieldCameraOffset(row, column, horizontalStep, verticalStep);
+		}
+		break;
+	}
+}
+
+
+std::string ScreenshotController::getShotFilenameWithoutExtension(int frameNumber)
+{
+	if(isLightfieldGrid())
+	{
+		// named after the position in the grid, row first, so the files sort in the order renderers expect them.
+		int row = 0;
+		int column = 0;
+		getLightfieldGridPosition(frameNumber, row, column);
+		return IGCS::Utils::formatString("%.2d_%.2d", row, column);
+	}
+	return std::to_string(frameNumber);
+}
+
+
+uint64_t ScreenshotController::appendShotToFrameContainer(const std::string& destinationFolder, const uint8_t* data, int frameNumber)
+{
+	if(!_frameContainer.isOpen())
+	{
+		const std::string filename = destinationFolder + "\\Shots.y4m";
+		if(!_frameContainer.open(filename, _framebufferWidth, _framebufferHeight, _y4mFramesPerSecond))
+		{
+			IGCS::Utils::logLineToReshade(reshade::log::level::error, "Couldn't open '%s' for writing.", filename.c_str());
+			return 0;
+		}
+	}
+	const auto writeStart = std::chrono::steady_clock::now();
+	// the conversion to YCbCr is done while copying the shot into the container's buffer, so it's all recorded as write time.
+	const uint64_t bytesWritten = _frameContainer.appendFrame(frameNumber, data);
+	if(bytesWritten == 0)
+	{
+		IGCS::Utils::logLineToReshade(reshade::log::level::error, "Couldn't write shot %d to the shots file.", frameNumber);
+	}
+	_telemetry.recordSave(frameNumber, 0.0, SessionTelemetry::getMillisecondsSince(writeStart), bytesWritten);
+	return bytesWritten;
+}
+
+
+void ScreenshotController::closeFrameContainer()
+{
+	if(_frameContainer.isOpen() && !_frameContainer.close())
+	{
+		IGCS::Utils::logLineToReshade(reshade::log::level::error, "Not all shots could be written to the shots file.");
+		OverlayControl::addNotification("Not all shots could be written to the shots file.");
+	}
+}
+
+
+uint64_t ScreenshotController::saveImageToFile(const std::string& filenameWithoutExtension, const uint8_t* data, uint32_t width, uint32_t height, int frameNumber)
+{
+	uint64_t bytesWritten = 0;
+	const std::string filename = filenameWithoutExtension + getImageFileExtension();
+	std::vector<uint8_t> encodedData;
+	const auto encodeStart = std::chrono::steady_clock::now();
 
 	// The shot data is RGB as we packed the RGBA data as RGB as Alpha is 0 in the source. So we pass 3 as the comp
 	switch(_filetype)
 	{
 	case ScreenshotFiletype::Bmp:
-		filename = IGCS::Utils::formatString("%s\\%d.bmp", destinationFolder.c_str(), frameNumber);
-		stbi_write_bmp(filename.c_str(), _framebufferWidth, _framebufferHeight, 3, data.data()) != 0;
+		stbi_write_bmp_to_func([](void* context, void* chunk, int size)
+							   {
+								   auto destination = static_cast<std::vector<uint8_t>*>(context);
+								   destination->insert(destination->end(), static_cast<uint8_t*>(chunk), static_cast<uint8_t*>(chunk) + size);
+							   }, &encodedData, width, height, 3, data);
+		bytesWritten = writeEncodedShot(filename, encodedData, frameNumber, SessionTelemetry::getMillisecondsSince(encodeStart));
 		break;
 	case ScreenshotFiletype::Jpeg:
-		filename = IGCS::Utils::formatString("%s\\%d.jpg", destinationFolder.c_str(), frameNumber);
-		stbi_write_jpg(filename.c_str(), _framebufferWidth, _framebufferHeight, 3, data.data(), 98) != 0;
+		// encodes bands of the shot on all cores, joined with restart markers, so the jpeg encoder isn't the bottleneck of a session.
+		if(IGCS::JpegWriter::encodeToMemory(encodedData, data, width, height, 3, _jpegQuality, _jpegChromaSubsampling))
+		{
+			bytesWritten = writeEncodedShot(filename, encodedData, frameNumber, SessionTelemetry::getMillisecondsSince(encodeStart));
+		}
 		break;
+	case ScreenshotFiletype::Y4m:
+		// only shots go into the y4m file, images of another size, like a stitched panorama, are written as png.
 	case ScreenshotFiletype::Png:
-		filename = IGCS::Utils::formatString("%s\\%d.png", destinationFolder.c_str(), frameNumber);
 		// 3 bytes per pixel!
-		//stbi_write_png(filename.c_str(), _framebufferWidth, _framebufferHeight, 3, data.data(), 3 * _framebufferWidth) != 0;
-		std::vector<uint8_t> encoded_data;
-		fpng::fpng_encode_image_to_memory(data.data(), _framebufferWidth, _framebufferHeight, 3, encoded_data);
-		FILE* pngFile;
-		if(fopen_s(&pngFile, filename.c_str(), "wb")==0)
+		//stbi_write_png(filename.c_str(), width, height, 3, data, 3 * width) != 0;
+		// compresses horizontal strips of the shot on all cores, so large shots don't keep a single core busy for seconds.
+		if(fpng::fpng_encode_image_to_memory_parallel(data, width, height, 3, encodedData))
 		{
-			fwrite(encoded_data.data(), encoded_data.size(), 1, pngFile);
+			bytesWritten = writeEncodedShot(filename, encodedData, frameNumber, SessionTelemetry::getMillisecondsSince(encodeStart));
 		}
-		if(nullptr != pngFile)
+		break;
+	case ScreenshotFiletype::Qoi:
+		// lossless like png but a single cheap pass over the pixels, streamed to the file. Encoding and writing overlap, so it's all
+		// recorded as encode time.
+		if(IGCS::Qoi::encodeToFile(filename, data, width, height, 3))
 		{
-			fclose(pngFile);
+			std::error_code errorCode;
+			const uintmax_t fileSize = std::filesystem::file_size(filename, errorCode);
+			bytesWritten = errorCode ? 0 : (uint64_t)fileSize;
+			_telemetry.recordSave(frameNumber, SessionTelemetry::getMillisecondsSince(encodeStart), 0.0, bytesWritten);
 		}
 		break;
 	}
+	return bytesWritten;
+}
+
+
+std::string ScreenshotController::getImageFileExtension()
+{
+	switch(_filetype)
+	{
+	case ScreenshotFiletype::Bmp:
+		return ".bmp";
+	case ScreenshotFiletype::Jpeg:
+		return ".jpg";
+	case ScreenshotFiletype::Qoi:
+		return ".qoi";
+	default:
+		// images which aren't shots are written as png if the shots go into a y4m file.
+		return ".png";
+	}
+}
+
+
+void ScreenshotController::beginPanorama()
+{
+	if(!shouldStitchPanorama())
+	{
+		return;
+	}
+	// the framebuffer size is only known once the first shot has been grabbed.
+	if(!_panoramaStitcher.begin(_framebufferWidth, _framebufferHeight, _pano_currentFoVRadians, _pano_anglePerStep, _numberOfShotsToTake))
+	{
+		IGCS::Utils::logLineToReshade(reshade::log::level::warning, "The panorama can't be stitched with the current field of view and overlap.");
+	}
+}
+
+
+void ScreenshotController::addShotToPanorama(const uint8_t* data, int frameNumber)
+{
+	if(!_panoramaStitcher.isActive())
+	{
+		return;
+	}
+	_panoramaStitcher.addShot(frameNumber, data);
+}
+
+
+void ScreenshotController::savePanorama(const std::string& destinationFolder)
+{
+	if(!_panoramaStitcher.isActive())
+	{
+		return;
+	}
+	const auto stitchStart = std::chrono::steady_clock::now();
+	std::vector<uint8_t> panorama;
+	uint32_t panoramaWidth = 0;
+	uint32_t panoramaHeight = 0;
+	if(!_panoramaStitcher.finish(panorama, panoramaWidth, panoramaHeight))
+	{
+		return;
+	}
+	// the panorama isn't a shot, so it's not part of the telemetry.
+	saveImageToFile(destinationFolder + "\\Panorama", panorama.data(), panoramaWidth, panoramaHeight, -1);
+	IGCS::Utils::logLineToReshade(reshade::log::level::info, "Stitched a panorama of %ux%u pixels, which took %.0fms to finish and save.", panoramaWidth, panoramaHeight,
+								  SessionTelemetry::getMillisecondsSince(stitchStart));
+	OverlayControl::addNotification(IGCS::Utils::formatString("Panorama of %ux%u pixels stitched.", panoramaWidth, panoramaHeight));
+}
+
+
+uint64_t ScreenshotController::writeEncodedShot(const std::string& filename, const std::vector<uint8_t>& encodedData, int frameNumber, double encodeMs)
+{
+	const auto writeStart = std::chrono::steady_clock::now();
+	FILE* shotFile;
+	if(fopen_s(&shotFile, filename.c_str(), "wb") != 0)
+	{
+		IGCS::Utils::logLineToReshade(reshade::log::level::error, "Couldn't open '%s' for writing.", filename.c_str());
+		return 0;
+	}
+	const size_t bytesWritten = fwrite(encodedData.data(), 1, encodedData.size(), shotFile);
+	const bool closed = fclose(shotFile) == 0;
+	_telemetry.recordSave(frameNumber, encodeMs, SessionTelemetry::getMillisecondsSince(writeStart), bytesWritten);
+	return (closed && bytesWritten == encodedData.size()) ? bytesWritten : 0;
+}
+
+
+int ScreenshotController::numberOfFrameBuffersToPrepare()
+{
+	if(_isTestRun)
+	{
+		// test runs don't keep the shots around
+		return 1;
+	}
+	if(shouldProcessShotsWhileCapturing())
+	{
+		// the shots in flight plus the one the completion thread is working on.
+		return (std::min)(_maxNumberOfShotsInFlight + 1, _numberOfShotsToTake);
+	}
+	if(_scratchFile.isOpen())
+	{
+		// shots are copied to the scratch file right away, so we just need the buffer to grab into.
+		return 1;
+	}
+	// all shots are kept in memory till the session ends. Allocating all their buffers at once would stall the game, so the pool only starts
+	// with as many as a session writing shots while capturing uses and allocates the others when they're acquired. They're released when
+	// the session ends, as the pool only keeps the number of buffers it was prepared with.
+	return (std::min)(_maxNumberOfShotsInFlight + 1, _numberOfShotsToTake);
+}
+
+
+void ScreenshotController::prepareShotStaging()
+{
+	if(_shotStagingPrepared)
+	{
+		return;
+	}
+	_shotStagingPrepared = true;
+	if(_isTestRun || shouldProcessShotsWhileCapturing())
+	{
+		// only a couple of shots are in memory at any time.
+		return;
+	}
+	// the buffers shots are grabbed in hold RGBA pixels, which are packed to RGB afterwards.
+	const uint64_t requiredMemory = (uint64_t)_numberOfShotsToTake * _framebufferWidth * _framebufferHeight * 4;
+	const uint64_t memoryBudget = getMemoryBudgetInBytes();
+	if(requiredMemory <= memoryBudget)
+	{
+		return;
+	}
+	const std::string optionalBackslash = (_rootFolder.ends_with('\\')) ? "" : "\\";
+	const std::string filename = _rootFolder + optionalBackslash + "IgcsConnectorShots.tmp";
+	if(!_scratchFile.create(filename, _numberOfShotsToTake, (size_t)_framebufferWidth * _framebufferHeight * 3))
+	{
+		IGCS::Utils::logLineToReshade(reshade::log::level::warning, "The shots need %llu MB, which is more than the memory budget of %llu MB, but the scratch file '%s' couldn't be created. Keeping the shots in memory.",
+									  requiredMemory / (1024 * 1024), memoryBudget / (1024 * 1024), filename.c_str());
+		return;
+	}
+	_shotIsInScratchFile.assign(_numberOfShotsToTake, false);
+	IGCS::Utils::logLineToReshade(reshade::log::level::info, "The shots need %llu MB, which is more than the memory budget of %llu MB. Staging the shots in the scratch file '%s'.",
+								  requiredMemory / (1024 * 1024), memoryBudget / (1024 * 1024), filename.c_str());
+}
+
+
+uint64_t ScreenshotController::getMemoryBudgetInBytes()
+{
+	uint64_t budget = (uint64_t)_shotMemoryBudgetInMB * 1024 * 1024;
+	MEMORYSTATUSEX memoryStatus;
+	memoryStatus.dwLength = sizeof(memoryStatus);
+	if(GlobalMemoryStatusEx(&memoryStatus))
+	{
+		// leave room for the game, paging it out is worse than writing shots to disk.
+		budget = (std::min)(budget, (uint64_t)(memoryStatus.ullAvailPhys / 2));
+	}
+	return budget;
+}
+
+
+bool ScreenshotController::hasFrameSettled()
+{
+	_adaptiveFrameWaitCounter++;
+	// the first frame checked after a camera move has nothing to compare with, so it's never settled.
+	const float difference = IGCS::FrameSignature::getAverageDifference(_previousFrameSignature, _currentFrameSignature);
+	std::swap(_previousFrameSignature, _currentFrameSignature);
+	if(difference <= _adaptiveFrameWaitThreshold)
+	{
+		return true;
+	}
+	if(_numberOfFramesToWaitBetweenSteps + _adaptiveFrameWaitCounter >= _adaptiveFrameWaitMaxFrames)
+	{
+		IGCS::Utils::logLineToReshade(reshade::log::level::info, "Shot %d didn't settle within %d frames (difference %.2f), taking it anyway.", _shotCounter, _adaptiveFrameWaitMaxFrames, difference);
+		return true;
+	}
+	return false;
+}
+
+
+bool ScreenshotController::isDuplicateOfPreviousShot(const uint8_t* data)
+{
+	const uint64_t shotHash = IGCS::FrameSignature::calculateSampleHash(data, (size_t)_framebufferWidth * 3, _framebufferHeight);
+	if(_hasPreviousShotHash && shotHash == _previousShotHash)
+	{
+		_telemetry.recordDuplicateFrame(_shotCounter);
+		if(_duplicateFrameRetries < _maxDuplicateFrameRetries)
+		{
+			_duplicateFrameRetries++;
+			IGCS::Utils::logLineToReshade(reshade::log::level::info, "Shot %d is the same as the previous shot, grabbing it again (attempt %d of %d).", _shotCounter, 
+										  _duplicateFrameRetries, _maxDuplicateFrameRetries);
+			return true;
+		}
+		IGCS::Utils::logLineToReshade(reshade::log::level::warning, "Shot %d is still the same as the previous shot after %d attempts, taking it anyway.", _shotCounter, 
+									  _maxDuplicateFrameRetries);
+	}
+	_previousShotHash = shotHash;
+	_hasPreviousShotHash = true;
+	_duplicateFrameRetries = 0;
+	return false;
+}
+
+
+void ScreenshotController::logFrameBufferPoolStatistics()
+{
+	const FrameBufferPoolStatistics statistics = _frameBufferPool.getStatistics();
+	IGCS::Utils::logLineToReshade(reshade::log::level::info, "Frame buffer pool: %d buffers allocated (%llu MB), %d allocations avoided by reusing buffers (%llu MB).", 
+								  statistics.numberOfAllocations, statistics.bytesAllocated / (1024 * 1024), statistics.numberOfReuses, statistics.bytesReused / (1024 * 1024));
+}
+
+
+void ScreenshotController::reportSessionTelemetry()
+{
+	_telemetry.end();
+	const std::string summary = _telemetry.getSummary();
+	if(!_sessionFolder.empty())
+	{
+		const std::string reportFilename = _sessionFolder + "\\SessionTimings.csv";
+		if(!_telemetry.writeCsvReport(reportFilename))
+		{
+			IGCS::Utils::logLineToReshade(reshade::log::level::warning, "Couldn't write the session timings to '%s'.", reportFilename.c_str());
+		}
+	}
+	IGCS::Utils::logLineToReshade(reshade::log::level::info, "%s: %s.", typeOfShotAsString().c_str(), summary.c_str());
+	OverlayControl::addNotification(summary);
+}
+
+
+void ScreenshotController::startPngRecompression()
+{
+	if(!_recompressPngsAfterSession || _isTestRun || _sessionFolder.empty())
+	{
+		return;
+	}
+	// runs in the background at low priority, this session is done as far as the user is concerned.
+	_pngRecompressor.recompressFolder(_sessionFolder);
+}
+
+
+void ScreenshotController::addShotToFilmstrip(const uint8_t* data, int frameNumber)
+{
+	if(!_generateThumbnails || _isTestRun)
+	{
+		return;
+	}
+	_filmstrip.addShot(frameNumber, data, _framebufferWidth, _framebufferHeight);
+}
+
+
+void ScreenshotController::startCompletionJob()
+{
+	_sessionCancellationToken = CancellationToken();
+	if(_generateThumbnails && !_isTestRun)
+	{
+		// the strip of the previous session is replaced as soon as a new session starts, so it never shows shots of two sessions.
+		_filmstrip.begin(typeOfShotAsString(), _numberOfShotsToTake);
+	}
+	const bool jobQueued = _completionWorkers.submit([this](const CancellationToken& cancellationToken)
+													  {
+														  completeShotSession(cancellationToken);
+													  }, _sessionCancellationToken);
+	if(!jobQueued)
+	{
+		IGCS::Utils::logLineToReshade(reshade::log::level::error, "Couldn't queue the completion of the %s session. The session is ended.", typeOfShotAsString().c_str());
+		OverlayControl::addNotification("Screenshot session couldn't be started.");
+		_cameraToolsConnector.endScreenshotSession();
+		// there's no completion thread, so the session is ended here.
+		endSession();
+	}
+}
+
+
+void ScreenshotController::releaseDeviceResources(reshade::api::effect_runtime* runtime)
+{
+	_filmstrip.releaseTextures(runtime->get_device());
+	_frameSignatureReadback.releaseTexture(runtime->get_device());
+}
+
+
+void ScreenshotController::shutdown()
+{
+	cancelSession();
+	// the completion thread queues the recompression, so it's stopped first.
+	_completionWorkers.shutdown();
+	_pngRecompressor.shutdown();
+	if(_state != ScreenshotControllerState::Off)
+	{
+		// the completion job was still queued, so nothing ended the session.
+		endSession();
+	}
+}
+
+
+void ScreenshotController::wakeCompletionThread()
+{
+	{
+		// taking the lock makes sure the completion thread is either waiting or hasn't checked its wait condition yet, so it can't miss the wake up.
+		std::unique_lock lock(_waitCompletionMutex);
+	}
+	_waitCompletionHandle.notify_all();
 }
 
 
@@ -492,16 +1591,51 @@ void ScreenshotController::reset()
 {
 	// don't reset framebuffer width/height, numberOfFramesToWaitBetweenSteps, movementSpeed, 
 	// rotationSpeed, rootFolder as those are set through configure!
+	// the completion thread of the previous session has released everything it used before the state became Off, so only the fields
+	// which are used on this thread are reset here.
 	_typeOfShot = ScreenshotType::HorizontalPanorama;
-	_state = ScreenshotControllerState::Off;
 	_pano_totalFoVRadians = 0.0f;
 	_pano_currentFoVRadians = 0.0f;
 	_lightField_distancePerStep = 0.0f;
+	_lightField_verticalDistancePerStep = 0.0f;
+	_lightField_numberOfColumns = 1;
+	_lightField_numberOfRows = 1;
 	_pano_anglePerStep = 0.0f;
 	_numberOfShotsToTake = 0;
 	_convolutionFrameCounter = 0;
+	_framesWaitedForShot = 0;
+	_adaptiveFrameWaitCounter = 0;
+	_previousFrameSignature.clear();
+	_duplicateFrameRetries = 0;
+	_previousShotHash = 0;
+	_hasPreviousShotHash = false;
 	_shotCounter = 0;
 	_overlapPercentagePerPanoShot = 30.0f;
 	_isTestRun = false;
+	_sessionFolder = "";
+	_numberOfShotsInScratchFile = 0;
+	_shotIsInScratchFile.clear();
+	_shotStagingPrepared = false;
+}
+
+
+void ScreenshotController::endSession()
+{
+	// the render thread doesn't touch any of this once the session is past InSession, and can't start a new session till the state is Off.
 	_grabbedFrames.clear();
+	_scratchFile.close();
+	_panoramaStitcher.clear();
+	_quiltAssembler.clear();
+	_tileAssembler.clear();
+	_viewCompositor.clear();
+	// a cancelled session leaves the file open. What's been written so far is kept.
+	_frameContainer.close();
+	_sessionManifest.close(true);
+	_lightfieldDeltaStore.clear();
+	// keep the buffers a session writing shots while capturing needs, so the next session doesn't have to allocate them again. The buffers
+	// of a session which kept all its shots in memory are released, so that memory isn't taken from the game till the next session.
+	_frameBufferPool.trim(_maxNumberOfShotsInFlight + 1);
+	_frameBufferPool.resetStatistics();
+	// last, with release semantics, so everything above is done before the render thread can start a new session.
+	_state.store(ScreenshotControllerState::Off, std::memory_order_release);
 }
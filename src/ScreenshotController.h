@@ -31,12 +31,32 @@
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 /////////////////////////////////////////////////////////////////////////
 #pragma once
+#include <atomic>
+#include <condition_variable>
+#include <functional>
 #include <mutex>
 #include <reshade_api.hpp>
 #include <string>
+#include <vector>
 
 #include "CameraToolsConnector.h"
 #include "ConstantsEnums.h"
+#include "Filmstrip.h"
+#include "FrameBufferPool.h"
+#include "FrameSignatureReadback.h"
+#include "LightfieldDeltaStore.h"
+#include "PanoramaStitcher.h"
+#include "PngRecompressor.h"
+#include "QuiltAssembler.h"
+#include "TileAssembler.h"
+#include "ViewCompositor.h"
+#include "ScreenshotSettings.h"
+#include "SessionManifest.h"
+#include "SessionTelemetry.h"
+#include "ShotScratchFile.h"
+#include "SpscRing.h"
+#include "WorkerPool.h"
+#include "Y4mWriter.h"
 
 
 // Simple controller class which controls the screenshot session.
@@ -46,32 +66,242 @@ public:
 	ScreenshotController(CameraToolsConnector& connector);
 	~ScreenshotController() = default;
 
-	void configure(std::string rootFolder, int numberOfFramesToWaitBetweenSteps, ScreenshotFiletype filetype);
+	void configure(const ScreenshotSettings& settings);
 	void startHorizontalPanoramaShot(float totalFoVInDegrees, float overlapPercentagePerPanoShot, float currentFoVInDegrees, bool isTestRun);
-	void startLightfieldShot(float distancePerStep, int numberOfShots, bool isTestRun);
+	void startLightfieldShot(float distancePerStep, int numberOfShotsPerRow, int numberOfRows, float verticalDistancePerStep, bool isTestRun);
+	void startTiledGridShot(int numberOfColumns, int numberOfRows, float horizontalDistancePerStep, float verticalDistancePerStep, float overlapPercentage, 
+							float currentFoVInDegrees, bool isTestRun);
+	void startStereoShot(int numberOfViews, float distanceBetweenViews, ViewLayout layout, bool reverseViews, bool isTestRun);
 	void startDebugGridShot();
 	ScreenshotControllerState getState() { return _state; }
+	/// <summary>
+	/// Resets the fields of the session which are used on the render thread. Only to be called when no session is running.
+	/// </summary>
 	void reset();
 	bool shouldTakeShot();		// returns true if a shot should be taken, false otherwise. 
 	void presentCalled();
 	void reshadeEffectsRendered(reshade::api::effect_runtime* runtime);
 	void cancelSession();
-	void completeShotSession();
+	void completeShotSession(const CancellationToken& cancellationToken);
 	void displayScreenshotSessionStartError(ScreenshotSessionStartReturnCode sessionStartResult);
+	/// <summary>
+	/// Draws the thumbnails of the shots of the last session. Has to be called from the overlay callback.
+	/// </summary>
+	void displayFilmstrip(reshade::api::effect_runtime* runtime) { _filmstrip.draw(runtime); }
+	/// <summary>
+	/// Destroys the textures of the filmstrip and the frame signature readback. Has to be called when the effect runtime is destroyed.
+	/// </summary>
+	void releaseDeviceResources(reshade::api::effect_runtime* runtime);
+	/// <summary>
+	/// Cancels the running session and the png recompression, and stops their threads. Has to be called before the dll is unloaded, outside
+	/// DllMain. A new session starts the threads again.
+	/// </summary>
+	void shutdown();
+	/// <summary>
+	/// Returns true if the tiles of a tiled grid can be written as a single image of the file type specified, which is only the case for file types which
+	/// can be written a band at a time.
+	/// </summary>
+	static bool canAssembleTiles(ScreenshotFiletype filetype) { return filetype == ScreenshotFiletype::Bmp || filetype == ScreenshotFiletype::Png; }
 
 private:
+	// processes the shots of a session on the completion thread, see getShotProcessor.
+	using ShotProcessor = void (ScreenshotController::*)(const CancellationToken&);
+
 	/// <summary>
 	/// Starts a screenshot session. Displays the error if one occurs.
 	/// </summary>
 	/// <returns>true if session could successfully be started, false otherwise</returns>
 	bool startSession();
+	/// <summary>
+	/// Queues completeShotSession on the completion worker. Ends the session if that fails.
+	/// </summary>
+	void startCompletionJob();
+	/// <summary>
+	/// Releases what the completion thread used during the session and switches the state to Off, which allows a new session to be started.
+	/// Called by the completion thread at the end of the session.
+	/// </summary>
+	void endSession();
+	/// <summary>
+	/// Wakes up the completion thread if it's waiting for a shot or for the end of the session.
+	/// </summary>
+	void wakeCompletionThread();
 	void waitForShots();
-	void saveGrabbedShots();
-	void storeGrabbedShot(std::vector<uint8_t>);
-	void saveShotToFile(std::string destinationFolder, const std::vector<uint8_t>& data, int frameNumber);
+	/// <summary>
+	/// Returns the function which processes the shots of the session till they're all written, which depends on the type of session.
+	/// </summary>
+	ShotProcessor getShotProcessor();
+	/// <summary>
+	/// Delta compresses the grabbed shots of a lightfield session while the session is still capturing, and writes them once all shots have been taken.
+	/// </summary>
+	void saveGrabbedShotsAsDeltas(const CancellationToken& cancellationToken);
+	/// <summary>
+	/// Waits till all shots have been taken and writes them, unless it's a test run.
+	/// </summary>
+	void saveGrabbedShotsAfterCapturing(const CancellationToken& cancellationToken);
+	void saveGrabbedShots(const CancellationToken& cancellationToken);
+	/// <summary>
+	/// Saves the grabbed shots while the session is still capturing: every shot stored by storeGrabbedShot is picked up here right away, so
+	/// encoding and writing shot N overlaps the frame waits for shot N+1. Returns when all shots have been written or the session was cancelled.
+	/// </summary>
+	void saveGrabbedShotsWhileCapturing(const CancellationToken& cancellationToken);
+	/// <summary>
+	/// Adds the grabbed shots of a lightfield session to _lightfieldDeltaStore while the session is still capturing. Returns when all shots
+	/// have been added or the session was cancelled.
+	/// </summary>
+	void storeGrabbedShotsAsDeltas(const CancellationToken& cancellationToken);
+	/// <summary>
+	/// Reconstructs the shots in _lightfieldDeltaStore and writes them to disk.
+	/// </summary>
+	void saveLightfieldDeltas(const CancellationToken& cancellationToken);
+	/// <summary>
+	/// Calls processShot for every grabbed shot as soon as storeGrabbedShot has stored it, on the calling thread. Returns when all shots have
+	/// been processed or the session was cancelled. The shot's buffer is handed back to the pool after processShot returns.
+	/// </summary>
+	/// <param name="processShot">called with the RGB data of the shot and its frame number</param>
+	void processGrabbedShotsWhileCapturing(const CancellationToken& cancellationToken, const std::function<void(const uint8_t*, int)>& processShot);
+	/// <summary>
+	/// Downscales the grabbed shots of a lightfield session into _quiltAssembler while the session is still capturing, and saves the quilt
+	/// once all shots have been added. Returns when the quilt has been saved or the session was cancelled.
+	/// </summary>
+	void assembleQuiltWhileCapturing(const CancellationToken& cancellationToken);
+	/// <summary>
+	/// Saves the quilt in _quiltAssembler in a new screenshot folder.
+	/// </summary>
+	void saveQuilt();
+	/// <summary>
+	/// Streams the grabbed tiles of a tiled grid session into a single image file while the session is still capturing. Returns when all
+	/// tiles have been added or the session was cancelled.
+	/// </summary>
+	void assembleTilesWhileCapturing(const CancellationToken& cancellationToken);
+	/// <summary>
+	/// Copies the grabbed views of a stereo session into _viewCompositor while the session is still capturing, and saves the composed image
+	/// once all views have been added. Returns when the image has been saved or the session was cancelled.
+	/// </summary>
+	void compositeViewsWhileCapturing(const CancellationToken& cancellationToken);
+	/// <summary>
+	/// Saves the image in _viewCompositor in a new screenshot folder.
+	/// </summary>
+	void saveComposedViews();
+	bool shouldAssembleTiles() { return _typeOfShot == ScreenshotType::TiledGrid && !_isTestRun; }
+	bool shouldCompositeViews() { return _typeOfShot == ScreenshotType::Stereo && !_isTestRun; }
+	bool shouldAssembleQuilt() { return _lightField_output == LightfieldOutput::Quilt && _typeOfShot == ScreenshotType::MultiShot && !_isTestRun; }
+	bool shouldStreamShotsToDisk() { return _writeShotsWhileCapturing && !_isTestRun && !shouldAssembleQuilt() && !shouldAssembleTiles() && !shouldCompositeViews() && !shouldStoreShotsAsDeltas(); }
+	// keeping the shots delta compressed is explicitly asked for, so it takes precedence over writing the shots while capturing.
+	bool shouldStoreShotsAsDeltas() { return _lightField_storeShotsAsDeltas && _typeOfShot == ScreenshotType::MultiShot && !_isTestRun && !shouldAssembleQuilt(); }
+	/// <summary>
+	/// Returns true if the grabbed shots are picked up by the session's completion thread while the session is still capturing.
+	/// </summary>
+	bool shouldProcessShotsWhileCapturing() { return shouldStreamShotsToDisk() || shouldStoreShotsAsDeltas() || shouldAssembleQuilt() || shouldAssembleTiles() || shouldCompositeViews(); }
+	void storeGrabbedShot(FrameBuffer grabbedShot);
+	void saveShotToFile(std::string destinationFolder, const uint8_t* data, int frameNumber);
+	/// <summary>
+	/// Returns the name, relative to the session folder, of the file the shot with the frame number specified is written to.
+	/// </summary>
+	std::string getShotFilenameWithoutExtension(int frameNumber);
+	/// <summary>
+	/// Returns the extension, including the '.', of the files saveImageToFile writes.
+	/// </summary>
+	std::string getImageFileExtension();
+	/// <summary>
+	/// Creates the manifest of the session in the folder specified, to which saveShotToFile adds every shot written.
+	/// </summary>
+	void openSessionManifest(const std::string& destinationFolder);
+	/// <summary>
+	/// Returns the step of the camera from the start position of the session for the shot with the frame number specified.
+	/// </summary>
+	void getCameraStepForShot(int frameNumber, float& horizontalStep, float& verticalStep);
+	/// <summary>
+	/// Appends the shot to _frameContainer, which is created in the folder specified when the first shot is appended. Returns the number
+	/// of bytes written, 0 if the shot couldn't be written.
+	/// </summary>
+	uint64_t appendShotToFrameContainer(const std::string& destinationFolder, const uint8_t* data, int frameNumber);
+	/// <summary>
+	/// Closes _frameContainer, if it's open, and logs if not all shots made it to disk.
+	/// </summary>
+	void closeFrameContainer();
+	/// <summary>
+	/// Encodes the RGB image in data in the configured file type and writes it to filenameWithoutExtension plus the file type's extension.
+	/// The timings are recorded in the telemetry for the shot with number frameNumber, if there is one. Returns the number of bytes written,
+	/// 0 if the image couldn't be written.
+	/// </summary>
+	uint64_t saveImageToFile(const std::string& filenameWithoutExtension, const uint8_t* data, uint32_t width, uint32_t height, int frameNumber);
+	bool isLightfieldGrid() { return _typeOfShot == ScreenshotType::MultiShot && _lightField_numberOfRows > 1; }
+	/// <summary>
+	/// Moves the camera to the position of the view with the index specified in a lightfield grid, relative to the start position.
+	/// </summary>
+	void moveCameraForLightfieldGrid(int shotIndex);
+	/// <summary>
+	/// Returns the row and column in the lightfield grid of the view with the index specified. Rows are visited in serpentine order.
+	/// </summary>
+	void getLightfieldGridPosition(int shotIndex, int& row, int& column);
+	/// <summary>
+	/// Returns the offset of the camera from the start position of the session for the view at the row and column specified.
+	/// </summary>
+	void getLightfieldCameraOffset(int row, int column, float& horizontalOffset, float& verticalOffset);
+	/// <summary>
+	/// Writes Lightfield.json in the folder specified, which describes the grid and where every view of a lightfield session is stored.
+	/// </summary>
+	void writeLightfieldIndex(const std::string& destinationFolder);
+	bool shouldStitchPanorama() { return _pano_stitchShots && _typeOfShot == ScreenshotType::HorizontalPanorama && !_isTestRun; }
+	/// <summary>
+	/// Starts the panorama, if the shots of the session are stitched. Called before the first shot is saved.
+	/// </summary>
+	void beginPanorama();
+	/// <summary>
+	/// Adds the shot to the panorama, if it has been started. Shots have to be passed in the order they were taken.
+	/// </summary>
+	void addShotToPanorama(const uint8_t* data, int frameNumber);
+	/// <summary>
+	/// Finishes the stitched panorama, if any, and saves it as 'Panorama' in the folder specified.
+	/// </summary>
+	void savePanorama(const std::string& destinationFolder);
+	/// <summary>
+	/// Returns the number of frame buffers the pool allocates up front for the current session. A session which keeps all its shots in memory
+	/// needs more, those are allocated by the pool as the shots are grabbed.
+	/// </summary>
+	int numberOfFrameBuffersToPrepare();
+	/// <summary>
+	/// Decides at the first shot of a session, when the framebuffer size is known, where the grabbed shots are kept till they're written: in
+	/// memory or, if they don't fit in the memory budget, in a memory mapped scratch file.
+	/// </summary>
+	void prepareShotStaging();
+	/// <summary>
+	/// Returns the memory budget for keeping grabbed shots in memory: the configured budget, but at most half of the physical memory available.
+	/// </summary>
+	uint64_t getMemoryBudgetInBytes();
+	/// <summary>
+	/// Used with the adaptive frame wait: returns true if the frame of the signature in _currentFrameSignature is nearly the same as the frame
+	/// checked in the previous call, or when we've waited the max. number of frames.
+	/// </summary>
+	bool hasFrameSettled();
+	/// <summary>
+	/// Returns true if the packed RGB shot in data is the same as the previous shot taken and it should be grabbed again. Stalled frames and
+	/// camera steps which haven't been applied yet give a shot which is byte for byte the same as the previous one.
+	/// </summary>
+	bool isDuplicateOfPreviousShot(const uint8_t* data);
+	void logFrameBufferPoolStatistics();
+	/// <summary>
+	/// Writes the telemetry of the session as a CSV file in the session's folder, if one was created, and posts the throughput summary.
+	/// </summary>
+	void reportSessionTelemetry();
+	/// <summary>
+	/// Queues the recompression of the png files in the session's folder, if enabled.
+	/// </summary>
+	void startPngRecompression();
+	/// <summary>
+	/// Adds the thumbnail of the shot to the filmstrip shown in the overlay, if enabled.
+	/// </summary>
+	void addShotToFilmstrip(const uint8_t* data, int frameNumber);
+	/// <summary>
+	/// Writes the encoded shot to the file specified. Records the time it took in the telemetry. Returns the number of bytes written, 0 if
+	/// the shot couldn't be written completely.
+	/// </summary>
+	uint64_t writeEncodedShot(const std::string& filename, const std::vector<uint8_t>& encodedData, int frameNumber, double encodeMs);
 	std::string createScreenshotFolder();
 	void moveCameraForLightfield(int direction, bool end);
 	void moveCameraForPanorama(int direction, bool end);
+	void moveCameraForTiledGrid(int tileIndex);
+	void moveCameraForStereo(int viewIndex);
 	void moveCameraForDebugGrid(int shotCounter, bool end);
 	void modifyCamera();
 	std::string typeOfShotAsString();
@@ -81,25 +311,89 @@ private:
 	float _pano_currentFoVRadians = 0.0f;
 	float _pano_anglePerStep = 0.0f;
 	float _lightField_distancePerStep = 0.0f;
+	float _lightField_verticalDistancePerStep = 0.0f;
+	int _lightField_numberOfColumns = 1;
+	int _lightField_numberOfRows = 1;
 	float _overlapPercentagePerPanoShot = 30.0f;
+	bool _pano_stitchShots = false;
+	int _tiled_numberOfColumns = 1;
+	int _tiled_numberOfRows = 1;
+	float _tiled_horizontalDistancePerStep = 0.0f;
+	float _tiled_verticalDistancePerStep = 0.0f;
+	float _tiled_overlapPercentage = 0.0f;
+	float _tiled_tileFoVInDegrees = 0.0f;
+	float _stereo_distanceBetweenViews = 0.0f;
+	ViewLayout _stereo_layout = ViewLayout::SideBySide;
+	bool _stereo_reverseViews = false;
 	int _numberOfShotsToTake = 0;
 	int _convolutionFrameCounter = 0;		// counts down to 0 from _amountOfFramesToWaitBetweenSteps
 	int _shotCounter = 0;
 	int _numberOfFramesToWaitBetweenSteps = 1;
+	bool _adaptiveFrameWait = false;
+	int _adaptiveFrameWaitMaxFrames = 30;
+	float _adaptiveFrameWaitThreshold = 0.5f;
+	int _framesWaitedForShot = 0;		// number of frames presented since the last shot was taken.
+	int _adaptiveFrameWaitCounter = 0;		// number of frames checked by hasFrameSettled since the camera was moved.
+	std::vector<float> _previousFrameSignature;		// only used on the render thread
+	std::vector<float> _currentFrameSignature;		// only used on the render thread
+	FrameSignatureReadback _frameSignatureReadback;		// only used on the render thread
+	bool _detectDuplicateFrames = true;
+	int _maxDuplicateFrameRetries = 3;
+	int _duplicateFrameRetries = 0;		// number of times the current shot has been grabbed again because it was the same as the previous shot.
+	uint64_t _previousShotHash = 0;		// only used on the render thread
+	bool _hasPreviousShotHash = false;		// only used on the render thread
 	uint32_t _framebufferWidth = 0;
 	uint32_t _framebufferHeight = 0;
 	ScreenshotType _typeOfShot = ScreenshotType::HorizontalPanorama;
-	ScreenshotControllerState _state = ScreenshotControllerState::Off;
+	std::atomic<ScreenshotControllerState> _state = ScreenshotControllerState::Off;		// read by the completion thread, so atomic.
 	ScreenshotFiletype _filetype = ScreenshotFiletype::Jpeg;
+	int _jpegQuality = 98;
+	JpegChromaSubsampling _jpegChromaSubsampling = JpegChromaSubsampling::Subsampling444;
+	int _y4mFramesPerSecond = 30;
+	bool _recompressPngsAfterSession = false;
+	bool _generateThumbnails = true;
 	bool _isTestRun = false;
+	bool _writeShotsWhileCapturing = true;
+	int _maxNumberOfShotsInFlight = 4;		// max number of grabbed shots waiting to be written when writing shots while capturing.
+	int _shotMemoryBudgetInMB = 4096;
+	bool _lightField_storeShotsAsDeltas = false;
+	int _lightField_maxShiftSearch = 64;
+	LightfieldOutput _lightField_output = LightfieldOutput::SeparateShots;
+	int _lightField_quiltColumns = 8;
+	int _lightField_quiltRows = 6;
+	int _lightField_quiltViewWidth = 420;
+	int _lightField_quiltViewHeight = 560;
+	bool _shotStagingPrepared = false;
+	int _numberOfShotsInScratchFile = 0;
+	std::vector<bool> _shotIsInScratchFile;		// per shot. A shot is stored in the slot with its index, so a shot which couldn't be stored leaves a gap.
 
 	std::string _rootFolder;
-	std::vector<std::vector<uint8_t>> _grabbedFrames;
+	std::string _sessionFolder;		// the folder created by createScreenshotFolder for the current session, if any.
+	SessionTelemetry _telemetry;
+	FrameBufferPool _frameBufferPool;		// has to be declared before _grabbedFrames, as the frames are handed back to it when destroyed.
+	SpscRing<FrameBuffer> _grabbedFrames;		// produced by the render thread, consumed by the completion thread.
+	ShotScratchFile _scratchFile;		// holds the grabbed shots instead of _grabbedFrames if they don't fit in the memory budget.
+	PanoramaStitcher _panoramaStitcher;		// stitches the shots of a panorama session if enabled. Only used by the completion thread.
+	ViewCompositor _viewCompositor;		// holds the composed views of a stereo session. Only used by the completion thread.
+	TileAssembler _tileAssembler;		// streams the tiles of a tiled grid session to disk. Only used by the completion thread.
+	QuiltAssembler _quiltAssembler;		// holds the quilt of a lightfield session if the shots are assembled into a quilt. Only used by the completion thread.
+	SessionManifest _sessionManifest;		// lists the shots written in the session folder. Only used by the completion thread.
+	Y4mWriter _frameContainer;		// receives all shots of the session if the file type is Y4m. Only used by the completion thread.
+	LightfieldDeltaStore _lightfieldDeltaStore;		// holds the grabbed shots of a lightfield session if they're stored as deltas. Only used by the completion thread.
 
 	// Used together to make sure the main thread in System doesn't busy-wait and waits till the grabbing process has been completed.
+	// When shots are written while capturing, the handle is also signaled when a grabbed shot has been added to _grabbedFrames.
 	std::mutex _waitCompletionMutex;
 	std::condition_variable _waitCompletionHandle;
 
+	PngRecompressor _pngRecompressor;		// recompresses the png files of finished sessions in the background.
+	Filmstrip _filmstrip;		// thumbnails of the shots of the last session, filled by the completion thread and drawn by the render thread.
+
+	CancellationToken _sessionCancellationToken;		// token of the completion job of the current session
+	// runs completeShotSession for every session. Sessions run one at a time, so one worker is enough; the job of a session started right
+	// after the previous one ends is queued behind the previous job. Declared last so it's destroyed first.
+	WorkerPool _completionWorkers{ 1, 4 };
+
 };
 
 
@@ -43,11 +43,43 @@ struct ScreenshotSettings
 {
 	int typeOfScreenshot = (int)ScreenshotType::HorizontalPanorama;
 	int screenshotFileType = (int)ScreenshotFiletype::Jpeg;
+	int jpegQuality = 98;
+	int jpegChromaSubsampling = (int)JpegChromaSubsampling::Subsampling444;
+	int y4mFramesPerSecond = 30;
+	bool recompressPngsAfterSession = false;
+	bool generateThumbnails = true;
 	int numberOfFramesToWaitBetweenSteps = 1;
+	bool adaptiveFrameWait = false;
+	int adaptiveFrameWaitMaxFrames = 30;
+	float adaptiveFrameWaitThreshold = 0.5f;
+	bool detectDuplicateFrames = true;
+	int maxDuplicateFrameRetries = 3;
+	bool writeShotsWhileCapturing = true;
+	int maxNumberOfShotsInFlight = 4;
+	int shotMemoryBudgetInMB = 4096;
 	float lightField_distanceBetweenShots = 1.0f;
 	int lightField_numberOfShotsToTake = 45;
+	int lightField_numberOfRows = 1;
+	float lightField_verticalDistanceBetweenShots = 1.0f;
+	bool lightField_storeShotsAsDeltas = false;
+	int lightField_maxShiftSearch = 64;
+	int lightField_output = (int)LightfieldOutput::SeparateShots;
+	int lightField_quiltColumns = 8;
+	int lightField_quiltRows = 6;
+	int lightField_quiltViewWidth = 420;
+	int lightField_quiltViewHeight = 560;
 	float pano_totalAngleDegrees = 110.0f;
 	float pano_overlapPercentagePerShot = 80.0f;
+	bool pano_stitchShots = false;
+	int tiled_numberOfColumns = 4;
+	int tiled_numberOfRows = 4;
+	float tiled_horizontalDistanceBetweenTiles = 1.0f;
+	float tiled_verticalDistanceBetweenTiles = 0.5625f;
+	float tiled_overlapPercentage = 10.0f;
+	int stereo_numberOfViews = 2;
+	float stereo_distanceBetweenViews = 0.5f;
+	int stereo_layout = (int)ViewLayout::SideBySide;
+	bool stereo_reverseViews = false;
 	char screenshotFolder[_MAX_PATH + 1] = { 0 };
 
 	ScreenshotSettings()
@@ -0,0 +1,107 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+#include "SessionManifest.h"
+#include "Utils.h"
+
+SessionManifest::~SessionManifest()
+{
+	// a manifest which wasn't closed properly is left without its last line, like it would be after a crash.
+	if(nullptr != _file)
+	{
+		fclose(_file);
+	}
+}
+
+
+bool SessionManifest::open(const std::string& filename, const SessionManifestHeader& header)
+{
+	if(nullptr != _file)
+	{
+		fclose(_file);
+		_file = nullptr;
+	}
+	if(fopen_s(&_file, filename.c_str(), "w") != 0)
+	{
+		_file = nullptr;
+		return false;
+	}
+	_numberOfShotsRecorded = 0;
+	std::string line = IGCS::Utils::formatString("{\"type\": \"session\", \"typeOfShot\": %s, \"fileType\": %s, \"width\": %u, \"height\": %u, \"numberOfShots\": %d, \"stepUnit\": %s, \"parameters\": {",
+												 IGCS::Utils::toJsonString(header.typeOfShot).c_str(), IGCS::Utils::toJsonString(header.fileType).c_str(), header.width, header.height, header.numberOfShots,
+												 IGCS::Utils::toJsonString(header.stepUnit).c_str());
+	for(size_t i = 0; i < header.parameters.size(); i++)
+	{
+		line += IGCS::Utils::formatString("%s%s: %g", i > 0 ? ", " : "", IGCS::Utils::toJsonString(header.parameters[i].first).c_str(), header.parameters[i].second);
+	}
+	writeLine(line + "}}");
+	return true;
+}
+
+
+void SessionManifest::recordShot(const SessionManifestShot& shot)
+{
+	if(nullptr == _file)
+	{
+		return;
+	}
+	std::string line = IGCS::Utils::formatString("{\"type\": \"shot\", \"index\": %d, \"file\": %s", shot.index, IGCS::Utils::toJsonString(shot.file).c_str());
+	if(shot.frameInFile >= 0)
+	{
+		line += IGCS::Utils::formatString(", \"frame\": %d", shot.frameInFile);
+	}
+	writeLine(line + IGCS::Utils::formatString(", \"horizontalStep\": %g, \"verticalStep\": %g, \"bytes\": %llu}", shot.horizontalStep, shot.verticalStep, shot.bytesWritten));
+	_numberOfShotsRecorded++;
+}
+
+
+void SessionManifest::close(bool wasCancelled)
+{
+	if(nullptr == _file)
+	{
+		return;
+	}
+	writeLine(IGCS::Utils::formatString("{\"type\": \"end\", \"state\": \"%s\", \"numberOfShotsWritten\": %d}", wasCancelled ? "cancelled" : "complete", _numberOfShotsRecorded));
+	fclose(_file);
+	_file = nullptr;
+}
+
+
+void SessionManifest::writeLine(const std::string& line)
+{
+	fputs(line.c_str(), _file);
+	fputc('\n', _file);
+	// hand the line to the OS right away: it then survives a crash of the game and other processes can read it.
+	fflush(_file);
+}
@@ -0,0 +1,105 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <utility>
+#include <vector>
+
+/// <summary>
+/// The data of a session which is written once, at the top of the manifest.
+/// </summary>
+struct SessionManifestHeader
+{
+	std::string typeOfShot;
+	std::string fileType;			// extension of the shot files, without the '.'
+	uint32_t width = 0;
+	uint32_t height = 0;
+	int numberOfShots = 0;
+	std::string stepUnit;			// unit of the camera steps of the shots: "radians" for rotations, "distance" for movements
+	std::vector<std::pair<std::string, float>> parameters;		// the settings the camera steps were calculated with
+};
+
+
+/// <summary>
+/// A shot which has been written completely.
+/// </summary>
+struct SessionManifestShot
+{
+	int index = 0;
+	std::string file;				// relative to the manifest
+	int frameInFile = -1;			// the frame in file the shot is stored as, if file is a container, -1 otherwise
+	float horizontalStep = 0.0f;	// camera step from the start position of the session. Positive is right.
+	float verticalStep = 0.0f;		// positive is up.
+	uint64_t bytesWritten = 0;
+};
+
+
+/// <summary>
+/// Writes the manifest of a screenshot session as JSON lines: one line with the session data, one line per shot as soon as it's been
+/// written and a last line with the final state of the session. Every line is flushed to the OS right away, so a tool can pick up shots
+/// while the session is still writing, and a session which crashed can be recognized by the missing last line and resumed or re-encoded
+/// from the shots listed.
+/// </summary>
+class SessionManifest
+{
+public:
+	SessionManifest() = default;
+	~SessionManifest();
+	SessionManifest(const SessionManifest&) = delete;
+	SessionManifest& operator=(const SessionManifest&) = delete;
+
+	/// <summary>
+	/// Creates the manifest with the name specified and writes the session line. Closes the current manifest, if any.
+	/// </summary>
+	/// <returns>true if the manifest was created, false otherwise</returns>
+	bool open(const std::string& filename, const SessionManifestHeader& header);
+	/// <summary>
+	/// Adds the line of a shot which has been written.
+	/// </summary>
+	void recordShot(const SessionManifestShot& shot);
+	/// <summary>
+	/// Writes the last line with the state of the session and closes the manifest.
+	/// </summary>
+	/// <param name="wasCancelled">true if the session was cancelled before all shots were written</param>
+	void close(bool wasCancelled);
+	bool isOpen() const { return nullptr != _file; }
+
+private:
+	void writeLine(const std::string& line);
+
+	FILE* _file = nullptr;
+	int _numberOfShotsRecorded = 0;
+};
@@ -0,0 +1,155 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+#include "SessionTelemetry.h"
+#include <cstdio>
+#include "Utils.h"
+
+void SessionTelemetry::begin(int numberOfShots)
+{
+	std::unique_lock lock(_mutex);
+	_shots.assign(numberOfShots < 0 ? 0 : numberOfShots, ShotTelemetry());
+	_numberOfShotsGrabbed = 0;
+	_sessionStart = std::chrono::steady_clock::now();
+	_sessionEnd = _sessionStart;
+}
+
+
+void SessionTelemetry::end()
+{
+	std::unique_lock lock(_mutex);
+	_sessionEnd = std::chrono::steady_clock::now();
+}
+
+
+void SessionTelemetry::recordGrab(int shotNumber, int framesWaited, double captureMs, double packMs)
+{
+	std::unique_lock lock(_mutex);
+	ShotTelemetry* shot = getShot(shotNumber);
+	if(nullptr == shot)
+	{
+		return;
+	}
+	shot->framesWaited = framesWaited;
+	shot->captureMs = captureMs;
+	shot->packMs = packMs;
+	_numberOfShotsGrabbed++;
+}
+
+
+void SessionTelemetry::recordSave(int shotNumber, double encodeMs, double writeMs, uint64_t bytesWritten)
+{
+	std::unique_lock lock(_mutex);
+	ShotTelemetry* shot = getShot(shotNumber);
+	if(nullptr == shot)
+	{
+		return;
+	}
+	shot->encodeMs = encodeMs;
+	shot->writeMs = writeMs;
+	shot->bytesWritten = bytesWritten;
+}
+
+
+void SessionTelemetry::recordDuplicateFrame(int shotNumber)
+{
+	std::unique_lock lock(_mutex);
+	ShotTelemetry* shot = getShot(shotNumber);
+	if(nullptr == shot)
+	{
+		return;
+	}
+	shot->duplicateFrames++;
+}
+
+
+bool SessionTelemetry::writeCsvReport(const std::string& filename)
+{
+	std::unique_lock lock(_mutex);
+	FILE* csvFile;
+	if(fopen_s(&csvFile, filename.c_str(), "w") != 0)
+	{
+		return false;
+	}
+	fprintf(csvFile, "Shot,FramesWaited,DuplicateFrames,CaptureMs,PackMs,EncodeMs,WriteMs,BytesWritten\n");
+	for(size_t i = 0; i < _shots.size(); i++)
+	{
+		const ShotTelemetry& shot = _shots[i];
+		fprintf(csvFile, "%zu,%d,%d,%.3f,%.3f,%.3f,%.3f,%llu\n", i, shot.framesWaited, shot.duplicateFrames, shot.captureMs, shot.packMs, shot.encodeMs, shot.writeMs, 
+				shot.bytesWritten);
+	}
+	const bool succeeded = ferror(csvFile) == 0;
+	fclose(csvFile);
+	return succeeded;
+}
+
+
+std::string SessionTelemetry::getSummary()
+{
+	std::unique_lock lock(_mutex);
+	uint64_t totalBytesWritten = 0;
+	int totalDuplicateFrames = 0;
+	for(const ShotTelemetry& shot : _shots)
+	{
+		totalBytesWritten += shot.bytesWritten;
+		totalDuplicateFrames += shot.duplicateFrames;
+	}
+	const double sessionSeconds = std::chrono::duration<double>(_sessionEnd - _sessionStart).count();
+	const double megabytesWritten = (double)totalBytesWritten / (1024.0 * 1024.0);
+	std::string summary;
+	if(sessionSeconds <= 0.0)
+	{
+		summary = IGCS::Utils::formatString("%d shots, %.0f MB written", _numberOfShotsGrabbed, megabytesWritten);
+	}
+	else
+	{
+		summary = IGCS::Utils::formatString("%d shots in %.1fs (%.1f shots/s), %.0f MB written (%.1f MB/s)", _numberOfShotsGrabbed, sessionSeconds, 
+											(double)_numberOfShotsGrabbed / sessionSeconds, megabytesWritten, megabytesWritten / sessionSeconds);
+	}
+	if(totalDuplicateFrames > 0)
+	{
+		summary += IGCS::Utils::formatString(", %d duplicate frames", totalDuplicateFrames);
+	}
+	return summary;
+}
+
+
+ShotTelemetry* SessionTelemetry::getShot(int shotNumber)
+{
+	if(shotNumber < 0 || shotNumber >= (int)_shots.size())
+	{
+		return nullptr;
+	}
+	return &_shots[shotNumber];
+}
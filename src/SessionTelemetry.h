@@ -0,0 +1,98 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// The timings of a single shot of a screenshot session, in milliseconds.
+/// </summary>
+struct ShotTelemetry
+{
+	int framesWaited = 0;		// frames presented between the previous shot (or the start of the session) and this shot.
+	int duplicateFrames = 0;		// frames grabbed for this shot which were the same as the previous shot.
+	double captureMs = 0.0;
+	double packMs = 0.0;
+	double encodeMs = 0.0;
+	double writeMs = 0.0;
+	uint64_t bytesWritten = 0;
+};
+
+
+/// <summary>
+/// Collects the per-shot timings of a screenshot session. Shots are grabbed on the render thread and written on the session's completion
+/// thread, so all methods are thread safe.
+/// </summary>
+class SessionTelemetry
+{
+public:
+	/// <summary>
+	/// Clears the collected timings and starts the session clock.
+	/// </summary>
+	void begin(int numberOfShots);
+	/// <summary>
+	/// Stops the session clock.
+	/// </summary>
+	void end();
+	void recordGrab(int shotNumber, int framesWaited, double captureMs, double packMs);
+	void recordSave(int shotNumber, double encodeMs, double writeMs, uint64_t bytesWritten);
+	void recordDuplicateFrame(int shotNumber);
+	/// <summary>
+	/// Writes the timings as a CSV file with one line per shot.
+	/// </summary>
+	/// <returns>true if the file was written, false otherwise</returns>
+	bool writeCsvReport(const std::string& filename);
+	/// <summary>
+	/// Returns a one line throughput summary of the session, e.g. "45 shots in 12.3s (3.7 shots/s), 410 MB written (33.3 MB/s)". The number
+	/// of duplicate frames is appended if there were any.
+	/// </summary>
+	std::string getSummary();
+
+	static double getMillisecondsSince(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+private:
+	ShotTelemetry* getShot(int shotNumber);		// assumes _mutex is locked
+
+	std::mutex _mutex;
+	std::vector<ShotTelemetry> _shots;
+	int _numberOfShotsGrabbed = 0;
+	std::chrono::steady_clock::time_point _sessionStart;
+	std::chrono::steady_clock::time_point _sessionEnd;
+};
@@ -0,0 +1,164 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+#include "ShotScratchFile.h"
+#include <cstring>
+
+MappedFrame::~MappedFrame()
+{
+	unmap();
+}
+
+
+MappedFrame::MappedFrame(MappedFrame&& other) noexcept : _view(other._view)
+{
+	other._view = nullptr;
+}
+
+
+MappedFrame& MappedFrame::operator=(MappedFrame&& other) noexcept
+{
+	if(this != &other)
+	{
+		unmap();
+		_view = other._view;
+		other._view = nullptr;
+	}
+	return *this;
+}
+
+
+void MappedFrame::unmap()
+{
+	if(nullptr != _view)
+	{
+		UnmapViewOfFile(_view);
+		_view = nullptr;
+	}
+}
+
+
+ShotScratchFile::~ShotScratchFile()
+{
+	close();
+}
+
+
+bool ShotScratchFile::create(const std::string& filename, int numberOfFrames, size_t frameSize)
+{
+	close();
+	if(numberOfFrames <= 0 || frameSize == 0)
+	{
+		return false;
+	}
+	SYSTEM_INFO systemInfo;
+	GetSystemInfo(&systemInfo);
+	const uint64_t granularity = systemInfo.dwAllocationGranularity;
+	const uint64_t frameStride = ((frameSize + granularity - 1) / granularity) * granularity;
+	const uint64_t fileSize = frameStride * numberOfFrames;
+
+	// Temporary: the cache manager keeps the data in memory if it can instead of writing it to disk right away. Delete on close: the file
+	// is removed when the last handle is closed, also when the game crashes.
+	HANDLE fileHandle = CreateFileA(filename.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE, nullptr);
+	if(INVALID_HANDLE_VALUE == fileHandle)
+	{
+		return false;
+	}
+	// this sets the file size as well.
+	HANDLE mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READWRITE, (DWORD)(fileSize >> 32), (DWORD)(fileSize & 0xFFFFFFFF), nullptr);
+	if(nullptr == mappingHandle)
+	{
+		CloseHandle(fileHandle);
+		return false;
+	}
+	_fileHandle = fileHandle;
+	_mappingHandle = mappingHandle;
+	_numberOfFrames = numberOfFrames;
+	_frameSize = frameSize;
+	_frameStride = frameStride;
+	return true;
+}
+
+
+bool ShotScratchFile::storeFrame(int index, const uint8_t* data)
+{
+	if(nullptr == data)
+	{
+		return false;
+	}
+	void* view = mapView(index, true);
+	if(nullptr == view)
+	{
+		return false;
+	}
+	memcpy(view, data, _frameSize);
+	// unmapping doesn't write the data to disk, the pages are written when the OS needs the memory or when the file is read back.
+	UnmapViewOfFile(view);
+	return true;
+}
+
+
+MappedFrame ShotScratchFile::mapFrame(int index)
+{
+	return MappedFrame(mapView(index, false));
+}
+
+
+void ShotScratchFile::close()
+{
+	if(nullptr != _mappingHandle)
+	{
+		CloseHandle(_mappingHandle);
+		_mappingHandle = nullptr;
+	}
+	if(nullptr != _fileHandle)
+	{
+		CloseHandle(_fileHandle);
+		_fileHandle = nullptr;
+	}
+	_numberOfFrames = 0;
+	_frameSize = 0;
+	_frameStride = 0;
+}
+
+
+void* ShotScratchFile::mapView(int index, bool forWriting)
+{
+	if(nullptr == _mappingHandle || index < 0 || index >= _numberOfFrames)
+	{
+		return nullptr;
+	}
+	const uint64_t offset = _frameStride * index;
+	return MapViewOfFile(_mappingHandle, forWriting ? FILE_MAP_WRITE : FILE_MAP_READ, (DWORD)(offset >> 32), (DWORD)(offset & 0xFFFFFFFF), _frameSize);
+}
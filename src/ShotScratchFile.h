@@ -0,0 +1,105 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <cstdint>
+#include <string>
+
+/// <summary>
+/// Move-only read-only view on a frame stored in a ShotScratchFile. The view is unmapped when the handle is destroyed.
+/// </summary>
+class MappedFrame
+{
+public:
+	MappedFrame() = default;
+	~MappedFrame();
+	MappedFrame(const MappedFrame&) = delete;
+	MappedFrame& operator=(const MappedFrame&) = delete;
+	MappedFrame(MappedFrame&& other) noexcept;
+	MappedFrame& operator=(MappedFrame&& other) noexcept;
+
+	const uint8_t* data() const { return static_cast<const uint8_t*>(_view); }
+	bool isValid() const { return nullptr != _view; }
+	void unmap();
+
+private:
+	friend class ShotScratchFile;
+	explicit MappedFrame(void* view) : _view(view) {}
+
+	void* _view = nullptr;
+};
+
+
+/// <summary>
+/// Memory mapped scratch file which holds the grabbed shots of a session which don't fit in memory. Every frame is mapped only while it's
+/// written or read, so the OS can write the frames out to disk when it needs the memory, instead of paging out the game. The file is
+/// temporary: it's deleted when it's closed, also when the process dies.
+/// </summary>
+class ShotScratchFile
+{
+public:
+	ShotScratchFile() = default;
+	~ShotScratchFile();
+	ShotScratchFile(const ShotScratchFile&) = delete;
+	ShotScratchFile& operator=(const ShotScratchFile&) = delete;
+
+	/// <summary>
+	/// Creates the scratch file with the name specified, with room for numberOfFrames frames of frameSize bytes. Closes the current file, if any.
+	/// </summary>
+	/// <returns>true if the file was created, false otherwise</returns>
+	bool create(const std::string& filename, int numberOfFrames, size_t frameSize);
+	/// <summary>
+	/// Copies frameSize bytes from data into the slot of the frame with the index specified.
+	/// </summary>
+	/// <returns>true if the frame was stored, false otherwise</returns>
+	bool storeFrame(int index, const uint8_t* data);
+	/// <summary>
+	/// Maps the frame with the index specified for reading. The returned view is invalid if the frame couldn't be mapped.
+	/// </summary>
+	MappedFrame mapFrame(int index);
+	/// <summary>
+	/// Closes the file, which deletes it. Views still mapped stay valid till they're unmapped.
+	/// </summary>
+	void close();
+	bool isOpen() const { return nullptr != _mappingHandle; }
+	size_t getFrameSize() const { return _frameSize; }
+
+private:
+	void* mapView(int index, bool forWriting);
+
+	void* _fileHandle = nullptr;
+	void* _mappingHandle = nullptr;
+	int _numberOfFrames = 0;
+	size_t _frameSize = 0;
+	uint64_t _frameStride = 0;			// frame size rounded up to the allocation granularity, as views have to start at a multiple of it.
+};
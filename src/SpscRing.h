@@ -0,0 +1,126 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+/// <summary>
+/// Lock-free bounded queue for handing items from exactly one producer thread to exactly one consumer thread. tryPush may only be called by
+/// the producer and tryPop / clear only by the consumer. T has to be default constructible and movable.
+/// </summary>
+template<typename T>
+class SpscRing
+{
+public:
+	SpscRing() = default;
+	SpscRing(const SpscRing&) = delete;
+	SpscRing& operator=(const SpscRing&) = delete;
+
+	/// <summary>
+	/// Empties the ring and resizes it so it can hold at least capacity items. Not thread safe: only call this when neither the producer nor
+	/// the consumer uses the ring.
+	/// </summary>
+	void reset(size_t capacity)
+	{
+		size_t slotCount = 1;
+		while(slotCount < capacity)
+		{
+			slotCount <<= 1;
+		}
+		_slots = std::vector<T>(slotCount);
+		_mask = slotCount - 1;
+		_head.store(0, std::memory_order_relaxed);
+		_tail.store(0, std::memory_order_relaxed);
+	}
+
+	/// <summary>
+	/// Moves item into the ring. Producer only.
+	/// </summary>
+	/// <returns>true if the item was added, false if the ring is full, in which case item is left untouched</returns>
+	bool tryPush(T&& item)
+	{
+		const size_t tail = _tail.load(std::memory_order_relaxed);
+		if(_slots.empty() || tail - _head.load(std::memory_order_acquire) >= _slots.size())
+		{
+			return false;
+		}
+		_slots[tail & _mask] = std::move(item);
+		// publishes the slot to the consumer
+		_tail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	/// <summary>
+	/// Moves the oldest item in the ring into item. Consumer only.
+	/// </summary>
+	/// <returns>true if an item was taken, false if the ring is empty</returns>
+	bool tryPop(T& item)
+	{
+		const size_t head = _head.load(std::memory_order_relaxed);
+		if(head == _tail.load(std::memory_order_acquire))
+		{
+			return false;
+		}
+		item = std::move(_slots[head & _mask]);
+		// hands the slot back to the producer
+		_head.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	/// <summary>
+	/// Destroys the items in the ring. Consumer only.
+	/// </summary>
+	void clear()
+	{
+		T item;
+		while(tryPop(item))
+		{
+			item = T();
+		}
+	}
+
+	/// <summary>
+	/// Returns the number of items in the ring. Exact when called by the producer or consumer while the other side is idle, a snapshot otherwise.
+	/// </summary>
+	size_t size() const { return _tail.load(std::memory_order_acquire) - _head.load(std::memory_order_acquire); }
+	bool empty() const { return size() == 0; }
+
+private:
+	// head and tail are written by different threads, so keep them on separate cache lines.
+	alignas(64) std::atomic<size_t> _head = 0;		// next slot to pop, written by the consumer
+	alignas(64) std::atomic<size_t> _tail = 0;		// next slot to push, written by the producer
+	alignas(64) std::vector<T> _slots;
+	size_t _mask = 0;
+};
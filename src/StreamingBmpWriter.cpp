@@ -0,0 +1,151 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+#include "StreamingBmpWriter.h"
+#include <cstring>
+
+namespace
+{
+	constexpr uint32_t HeaderSize = 14 + 40;		// BITMAPFILEHEADER + BITMAPINFOHEADER
+
+	void storeUInt16(uint8_t* destination, uint16_t value)
+	{
+		destination[0] = (uint8_t)value;
+		destination[1] = (uint8_t)(value >> 8);
+	}
+
+	void storeUInt32(uint8_t* destination, uint32_t value)
+	{
+		storeUInt16(destination, (uint16_t)value);
+		storeUInt16(destination + 2, (uint16_t)(value >> 16));
+	}
+}
+
+
+StreamingBmpWriter::~StreamingBmpWriter()
+{
+	close();
+}
+
+
+bool StreamingBmpWriter::open(const std::string& filename, uint32_t width, uint32_t height)
+{
+	close();
+	if(width == 0 || height == 0 || width > INT32_MAX || height > INT32_MAX)
+	{
+		return false;
+	}
+	if(fopen_s(&_file, filename.c_str(), "wb") != 0)
+	{
+		_file = nullptr;
+		return false;
+	}
+	_width = width;
+	_height = height;
+	_rowStride = ((uint64_t)width * 3 + 3) & ~(uint64_t)3;
+	_writeFailed = false;
+	_rowBuffer.assign(_rowStride, 0);
+
+	const uint64_t imageSize = _rowStride * height;
+	const uint64_t fileSize = HeaderSize + imageSize;
+	uint8_t header[HeaderSize] = { 0 };
+	header[0] = 'B';
+	header[1] = 'M';
+	// the sizes are 32 bit. Readers which handle files over 4GB ignore them, and 0 is allowed for the image size of uncompressed images.
+	storeUInt32(header + 2, fileSize > UINT32_MAX ? 0 : (uint32_t)fileSize);
+	storeUInt32(header + 10, HeaderSize);
+	storeUInt32(header + 14, 40);
+	storeUInt32(header + 18, width);
+	storeUInt32(header + 22, height);		// positive: the rows are stored bottom to top
+	storeUInt16(header + 26, 1);				// planes
+	storeUInt16(header + 28, 24);				// bits per pixel
+	storeUInt32(header + 34, imageSize > UINT32_MAX ? 0 : (uint32_t)imageSize);
+	storeUInt32(header + 38, 2835);			// 72 dpi
+	storeUInt32(header + 42, 2835);
+	if(fwrite(header, HeaderSize, 1, _file) != 1)
+	{
+		close();
+		return false;
+	}
+	// give the file its final size up front, so the bands can be written at their position in any order.
+	if(_fseeki64(_file, (int64_t)(fileSize - 1), SEEK_SET) != 0 || fputc(0, _file) == EOF)
+	{
+		close();
+		return false;
+	}
+	return true;
+}
+
+
+bool StreamingBmpWriter::writeRows(uint32_t firstRow, uint32_t numberOfRows, const uint8_t* data)
+{
+	if(!isOpen() || nullptr == data || firstRow >= _height || numberOfRows > _height - firstRow)
+	{
+		return false;
+	}
+	const size_t sourceRowSize = (size_t)_width * 3;
+	for(uint32_t i = 0; i < numberOfRows; i++)
+	{
+		// BMP stores BGR, bottom row first.
+		const uint8_t* source = data + i * sourceRowSize;
+		for(uint32_t x = 0; x < _width; x++)
+		{
+			_rowBuffer[x * 3 + 0] = source[x * 3 + 2];
+			_rowBuffer[x * 3 + 1] = source[x * 3 + 1];
+			_rowBuffer[x * 3 + 2] = source[x * 3 + 0];
+		}
+		const uint64_t offset = HeaderSize + (uint64_t)(_height - 1 - (firstRow + i)) * _rowStride;
+		if(_fseeki64(_file, (int64_t)offset, SEEK_SET) != 0 || fwrite(_rowBuffer.data(), _rowStride, 1, _file) != 1)
+		{
+			_writeFailed = true;
+			return false;
+		}
+	}
+	return true;
+}
+
+
+bool StreamingBmpWriter::close()
+{
+	if(nullptr == _file)
+	{
+		return false;
+	}
+	const bool closed = fclose(_file) == 0;
+	const bool succeeded = closed && !_writeFailed;
+	_file = nullptr;
+	_rowBuffer.clear();
+	_rowBuffer.shrink_to_fit();
+	return succeeded;
+}
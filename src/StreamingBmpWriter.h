@@ -0,0 +1,76 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Writes a 24-bit BMP file row band by row band, so an image which doesn't fit in memory can be written. The file is created with its
+/// final size up front and every band is written at its position in the file, so bands can be written in any order.
+/// </summary>
+class StreamingBmpWriter
+{
+public:
+	StreamingBmpWriter() = default;
+	~StreamingBmpWriter();
+	StreamingBmpWriter(const StreamingBmpWriter&) = delete;
+	StreamingBmpWriter& operator=(const StreamingBmpWriter&) = delete;
+
+	/// <summary>
+	/// Creates the file with the name specified and writes the header for an image of width x height pixels. Closes the current file, if any.
+	/// </summary>
+	/// <returns>true if the file was created, false otherwise</returns>
+	bool open(const std::string& filename, uint32_t width, uint32_t height);
+	/// <summary>
+	/// Writes numberOfRows RGB rows, of which the top one is row firstRow of the image (0 is the top row), from data.
+	/// </summary>
+	/// <returns>true if the rows were written, false otherwise</returns>
+	bool writeRows(uint32_t firstRow, uint32_t numberOfRows, const uint8_t* data);
+	/// <summary>
+	/// Closes the file.
+	/// </summary>
+	/// <returns>true if all writes succeeded, false otherwise</returns>
+	bool close();
+	bool isOpen() const { return nullptr != _file; }
+
+private:
+	FILE* _file = nullptr;
+	uint32_t _width = 0;
+	uint32_t _height = 0;
+	uint64_t _rowStride = 0;			// rows are padded to a multiple of 4 bytes
+	bool _writeFailed = false;
+	std::vector<uint8_t> _rowBuffer;
+};
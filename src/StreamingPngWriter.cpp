@@ -0,0 +1,126 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+#include "StreamingPngWriter.h"
+#include <algorithm>
+
+StreamingPngWriter::~StreamingPngWriter()
+{
+	close();
+}
+
+
+bool StreamingPngWriter::open(const std::string& filename, uint32_t width, uint32_t height)
+{
+	close();
+	if(width == 0 || height == 0)
+	{
+		return false;
+	}
+	if(fopen_s(&_file, filename.c_str(), "wb") != 0)
+	{
+		_file = nullptr;
+		return false;
+	}
+	_width = width;
+	_height = height;
+	_writeFailed = false;
+	if(!_encoder.begin(width, height, 3, &StreamingPngWriter::writeToFile, _file))
+	{
+		fclose(_file);
+		_file = nullptr;
+		return false;
+	}
+	return true;
+}
+
+
+bool StreamingPngWriter::writeRows(uint32_t firstRow, uint32_t numberOfRows, const uint8_t* data)
+{
+	if(!isOpen() || nullptr == data || firstRow < _encoder.get_rows_added() || firstRow >= _height || numberOfRows > _height - firstRow)
+	{
+		return false;
+	}
+	if(!writeBlackRows(firstRow - _encoder.get_rows_added()) || !_encoder.add_rows(data, numberOfRows))
+	{
+		_writeFailed = true;
+		return false;
+	}
+	return true;
+}
+
+
+bool StreamingPngWriter::close()
+{
+	if(nullptr == _file)
+	{
+		return false;
+	}
+	if(!_writeFailed && !writeBlackRows(_height - _encoder.get_rows_added()))
+	{
+		_writeFailed = true;
+	}
+	const bool closed = fclose(_file) == 0;
+	const bool succeeded = closed && !_writeFailed && _encoder.is_complete();
+	_file = nullptr;
+	return succeeded;
+}
+
+
+bool StreamingPngWriter::writeBlackRows(uint32_t numberOfRows)
+{
+	if(numberOfRows == 0)
+	{
+		return true;
+	}
+	// at most 64 black rows at a time, so a large gap doesn't need a large buffer.
+	const uint32_t rowsPerWrite = 64;
+	const std::vector<uint8_t> blackRows((size_t)_width * 3 * (std::min)(numberOfRows, rowsPerWrite), 0);
+	while(numberOfRows > 0)
+	{
+		const uint32_t rowsToWrite = (std::min)(numberOfRows, rowsPerWrite);
+		if(!_encoder.add_rows(blackRows.data(), rowsToWrite))
+		{
+			return false;
+		}
+		numberOfRows -= rowsToWrite;
+	}
+	return true;
+}
+
+
+bool StreamingPngWriter::writeToFile(void* file, const void* data, size_t length)
+{
+	return fwrite(data, 1, length, (FILE*)file) == length;
+}
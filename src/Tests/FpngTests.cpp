@@ -0,0 +1,132 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+// Compares fpng's SSE4.1, PCLMUL and AVX2 code with its scalar code. fpng's features are process wide, which is fine in this test, but not in the
+// addon, where sessions and the png recompressor encode at the same time.
+#include "../fpng.h"
+#include "../CpuFeatures.h"
+#include "TestFramework.h"
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace IGCS::Tests
+{
+	namespace
+	{
+		struct FpngLevel
+		{
+			const char* name;
+			fpng::fpng_cpu_features features;
+		};
+
+		struct FpngResult
+		{
+			uint32_t adler32;
+			uint32_t crc32;
+			std::vector<uint8_t> encodedData;
+		};
+
+		/// <summary>
+		/// Creates an image with smooth areas and noisy areas, so fpng uses both its run and its literal paths.
+		/// </summary>
+		std::vector<uint8_t> createImage(uint32_t width, uint32_t height)
+		{
+			std::mt19937 generator(7);
+			std::vector<uint8_t> image((size_t)width * height * 3);
+			for(uint32_t y = 0; y < height; ++y)
+			{
+				for(uint32_t x = 0; x < width; ++x)
+				{
+					uint8_t* pixel = image.data() + ((size_t)y * width + x) * 3;
+					const bool isNoisy = ((x / 16) + (y / 16)) % 2 == 1;
+					for(int channel = 0; channel < 3; ++channel)
+					{
+						pixel[channel] = isNoisy ? (uint8_t)generator() : (uint8_t)(x + y * channel);
+					}
+				}
+			}
+			return image;
+		}
+
+
+		FpngResult encodeWith(const fpng::fpng_cpu_features& features, const std::vector<uint8_t>& image, uint32_t width, uint32_t height)
+		{
+			fpng::fpng_init(features);
+			FpngResult result;
+			result.adler32 = fpng::fpng_adler32(image.data(), image.size());
+			result.crc32 = fpng::fpng_crc32(image.data(), image.size());
+			fpng::fpng_encode_image_to_memory(image.data(), width, height, 3, result.encodedData);
+			return result;
+		}
+	}
+
+
+	IGCS_TEST(fpngLevelsMatchScalarCode)
+	{
+		const CpuFeatures::FeatureSet& detected = CpuFeatures::get();
+		std::vector<FpngLevel> levels;
+		if(detected.sse41)
+		{
+			levels.push_back({ "SSE4.1", { true, false, false } });
+		}
+		if(detected.pclmul)
+		{
+			levels.push_back({ "SSE4.1+PCLMUL", { true, true, false } });
+		}
+		if(detected.avx2)
+		{
+			levels.push_back({ "AVX2", { true, detected.pclmul, true } });
+		}
+		const uint32_t sizes[][2] = { { 1, 1 }, { 7, 3 }, { 67, 33 }, { 640, 360 } };
+		for(const auto& size : sizes)
+		{
+			const auto image = createImage(size[0], size[1]);
+			const FpngResult expected = encodeWith({ false, false, false }, image, size[0], size[1]);
+			IGCS_CHECK(!expected.encodedData.empty());
+			for(const auto& level : levels)
+			{
+				const FpngResult result = encodeWith(level.features, image, size[0], size[1]);
+				if(result.adler32 != expected.adler32 || result.crc32 != expected.crc32 || result.encodedData != expected.encodedData)
+				{
+					char message[128];
+					std::snprintf(message, sizeof(message), "%s differs from the scalar code at %ux%u", level.name, size[0], size[1]);
+					reportFailure(__FILE__, __LINE__, message);
+				}
+			}
+		}
+		// the other tests use the features the addon uses.
+		CpuFeatures::initialize();
+	}
+}
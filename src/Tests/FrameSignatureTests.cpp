@@ -0,0 +1,114 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#include "../FrameSignature.h"
+#include "TestFramework.h"
+#include <cfloat>
+#include <cstdint>
+#include <vector>
+
+namespace IGCS::Tests
+{
+	namespace
+	{
+		struct FrameSize
+		{
+			uint32_t width;
+			uint32_t height;
+		};
+
+		// frames smaller than the 64x36 signature grid, in one or both directions, and a frame with padded rows.
+		const FrameSize FrameSizes[] = { { 1, 1 }, { 3, 2 }, { 63, 35 }, { 64, 36 }, { 200, 10 }, { 10, 200 }, { 640, 360 } };
+
+		std::vector<uint8_t> createFrame(uint32_t width, uint32_t height, size_t rowPitch, uint8_t red, uint8_t green, uint8_t blue)
+		{
+			std::vector<uint8_t> frame(rowPitch * height, 0);
+			for(uint32_t y = 0; y < height; ++y)
+			{
+				for(uint32_t x = 0; x < width; ++x)
+				{
+					uint8_t* pixel = frame.data() + y * rowPitch + x * 4;
+					pixel[0] = red;
+					pixel[1] = green;
+					pixel[2] = blue;
+					pixel[3] = 255;
+				}
+			}
+			return frame;
+		}
+	}
+
+
+	IGCS_TEST(framesSmallerThanTheSignatureGridHaveASignature)
+	{
+		for(const auto& size : FrameSizes)
+		{
+			const size_t rowPitch = (size_t)size.width * 4 + 12;
+			const auto grayFrame = createFrame(size.width, size.height, rowPitch, 100, 100, 100);
+			const auto whiteFrame = createFrame(size.width, size.height, rowPitch, 255, 255, 255);
+			std::vector<float> graySignature;
+			std::vector<float> whiteSignature;
+			FrameSignature::calculateLumaSignature(grayFrame.data(), size.width, size.height, rowPitch, false, graySignature);
+			FrameSignature::calculateLumaSignature(whiteFrame.data(), size.width, size.height, rowPitch, false, whiteSignature);
+			IGCS_CHECK(graySignature.size() == FrameSignature::SignatureWidth * FrameSignature::SignatureHeight);
+			IGCS_CHECK_AT_MOST(FrameSignature::getAverageDifference(graySignature, graySignature), 0.0f, "%ux%u", size.width, size.height);
+			// every cell sees the change, so the difference is the full difference in luma.
+			const float difference = FrameSignature::getAverageDifference(graySignature, whiteSignature);
+			IGCS_CHECK_AT_MOST(150.0f, difference, "%ux%u", size.width, size.height);
+		}
+	}
+
+
+	IGCS_TEST(bgraFramesHaveTheSameSignatureAsRgbaFrames)
+	{
+		const auto rgbaFrame = createFrame(64, 36, 64 * 4, 200, 50, 10);
+		const auto bgraFrame = createFrame(64, 36, 64 * 4, 10, 50, 200);
+		std::vector<float> rgbaSignature;
+		std::vector<float> bgraSignature;
+		FrameSignature::calculateLumaSignature(rgbaFrame.data(), 64, 36, 64 * 4, false, rgbaSignature);
+		FrameSignature::calculateLumaSignature(bgraFrame.data(), 64, 36, 64 * 4, true, bgraSignature);
+		IGCS_CHECK_AT_MOST(FrameSignature::getAverageDifference(rgbaSignature, bgraSignature), 0.0f, "%s", "64x36");
+	}
+
+
+	IGCS_TEST(missingFramesCantBeCompared)
+	{
+		const auto frame = createFrame(16, 16, 16 * 4, 100, 100, 100);
+		std::vector<float> signature;
+		FrameSignature::calculateLumaSignature(nullptr, 16, 16, 16 * 4, false, signature);
+		IGCS_CHECK(signature.empty());
+		FrameSignature::calculateLumaSignature(frame.data(), 0, 16, 16 * 4, false, signature);
+		IGCS_CHECK(signature.empty());
+		IGCS_CHECK(FrameSignature::getAverageDifference(signature, signature) == FLT_MAX);
+	}
+}
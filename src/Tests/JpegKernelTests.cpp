@@ -0,0 +1,222 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+// Compares the SSE2 and AVX2 kernels of the JPEG writer with its scalar code. The kernels are compiled into this test, so they can be called
+// directly, with the SIMD level as argument: nothing here touches the level the addon uses.
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#define STB_IMAGE_WRITE_STATIC
+#include "../std_image_write.h"
+#include "../CpuFeatures.h"
+#include "TestFramework.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace IGCS::Tests
+{
+	namespace
+	{
+		// The vector kernels do the same float operations in the same order as the scalar code, and the compiler doesn't contract the scalar
+		// code into fused multiply-adds with /fp:precise, so the results are identical and no difference is allowed.
+		constexpr float MaxColorConversionDifference = 0.0f;
+		constexpr int MaxCoefficientDifference = 0;
+
+		const int OddSizes[] = { 1, 3, 7, 9, 15, 17, 33, 67 };
+
+		/// <summary>
+		/// Returns the highest SIMD level of the kernels which can run on this cpu: 1 (SSE2) or, if the cpu has it, 2 (AVX2).
+		/// </summary>
+		int getHighestSimdLevel()
+		{
+			static const int highestSimdLevel = CpuFeatures::get().avx2 ? 2 : 1;
+			static bool skipLogged = false;
+			if(highestSimdLevel < 2 && !skipLogged)
+			{
+				std::printf("No AVX2 on this cpu, only the SSE2 kernels are tested.\n");
+				skipLogged = true;
+			}
+			return highestSimdLevel;
+		}
+
+
+		/// <summary>
+		/// Fills an image with noise, so every kernel lane gets different values, with the extremes 0 and 255 in the first pixels.
+		/// </summary>
+		std::vector<uint8_t> createNoiseImage(int width, int height, int numberOfChannels, uint32_t seed)
+		{
+			std::mt19937 generator(seed);
+			std::vector<uint8_t> image((size_t)width * height * numberOfChannels);
+			for(auto& value : image)
+			{
+				value = (uint8_t)(generator() & 0xFF);
+			}
+			for(size_t i = 0; i < std::min<size_t>(image.size(), 12); ++i)
+			{
+				image[i] = (i / numberOfChannels) % 2 == 0 ? 0 : 255;
+			}
+			return image;
+		}
+
+
+		void appendToVector(void* context, void* data, int size)
+		{
+			auto destination = static_cast<std::vector<uint8_t>*>(context);
+			destination->insert(destination->end(), static_cast<const uint8_t*>(data), static_cast<const uint8_t*>(data) + size);
+		}
+
+
+		std::vector<uint8_t> encode(const std::vector<uint8_t>& image, int width, int height, int numberOfChannels, int subsample, int simdLevel)
+		{
+			std::vector<uint8_t> encodedData;
+			stbi_write_jpg_params params;
+			if(!stbi_write_jpg_init_params(&params, width, height, numberOfChannels, 90, subsample))
+			{
+				return encodedData;
+			}
+			params.simd_level = simdLevel;
+			stbi_write_jpg_headers_to_func(&appendToVector, &encodedData, &params);
+			stbi_write_jpg_mcu_rows_to_func(&appendToVector, &encodedData, &params, image.data(), 0, params.num_mcu_rows);
+			stbi_write_jpg_end_to_func(&appendToVector, &encodedData);
+			return encodedData;
+		}
+	}
+
+
+	IGCS_TEST(colorConversionKernelsMatchScalarCode)
+	{
+		for(int simdLevel = 1; simdLevel <= getHighestSimdLevel(); ++simdLevel)
+		{
+			for(int numberOfChannels = 3; numberOfChannels <= 4; ++numberOfChannels)
+			{
+				// the AVX2 kernel converts 8 pixels at once, the encoder passes 8 or 16.
+				for(int numberOfPixels = 8; numberOfPixels <= 16; numberOfPixels += 8)
+				{
+					const auto pixels = createNoiseImage(numberOfPixels, 1, numberOfChannels, 1000 * simdLevel + 10 * numberOfChannels + numberOfPixels);
+					float expected[3][16];
+					float actual[3][16];
+					stbiw__jpg_rgb_to_ycc(pixels.data(), numberOfChannels, numberOfPixels, expected[0], expected[1], expected[2], 0);
+					stbiw__jpg_rgb_to_ycc(pixels.data(), numberOfChannels, numberOfPixels, actual[0], actual[1], actual[2], simdLevel);
+					float maxDifference = 0.0f;
+					for(int component = 0; component < 3; ++component)
+					{
+						for(int i = 0; i < numberOfPixels; ++i)
+						{
+							maxDifference = std::max(maxDifference, std::fabs(expected[component][i] - actual[component][i]));
+						}
+					}
+					IGCS_CHECK_AT_MOST(maxDifference, MaxColorConversionDifference, "simd level %d, %d channels, %d pixels", simdLevel, numberOfChannels, numberOfPixels);
+				}
+			}
+		}
+	}
+
+
+	IGCS_TEST(dctAndQuantizationKernelsMatchScalarCode)
+	{
+		std::mt19937 generator(4711);
+		for(int simdLevel = 1; simdLevel <= getHighestSimdLevel(); ++simdLevel)
+		{
+			for(int quality : { 1, 50, 90, 100 })
+			{
+				stbi_write_jpg_params params;
+				stbi_write_jpg_init_params(&params, 16, 16, 3, quality, 0);
+				// stride 8 for a single block, 16 for a block of a 4:2:0 MCU
+				for(int duStride = 8; duStride <= 16; duStride += 8)
+				{
+					int maxDifference = 0;
+					for(int block = 0; block < 200; ++block)
+					{
+						float samples[16 * 8];
+						for(auto& sample : samples)
+						{
+							// level shifted samples, -128 up to 128 in 1/16th steps
+							sample = (float)(int)(generator() % 4096) / 16.0f - 128.0f;
+						}
+						for(const float* fdtbl : { params.fdtbl_Y, params.fdtbl_UV })
+						{
+							// the kernels transform the block in place
+							float scalarSamples[16 * 8];
+							float simdSamples[16 * 8];
+							std::copy(std::begin(samples), std::end(samples), scalarSamples);
+							std::copy(std::begin(samples), std::end(samples), simdSamples);
+							int expected[64];
+							int actual[64];
+							stbiw__jpg_fdct_quantize(scalarSamples, duStride, fdtbl, expected, 0);
+							stbiw__jpg_fdct_quantize(simdSamples, duStride, fdtbl, actual, simdLevel);
+							for(int i = 0; i < 64; ++i)
+							{
+								maxDifference = std::max(maxDifference, std::abs(expected[i] - actual[i]));
+							}
+						}
+					}
+					IGCS_CHECK_AT_MOST(maxDifference, MaxCoefficientDifference, "simd level %d, quality %d, stride %d", simdLevel, quality, duStride);
+				}
+			}
+		}
+	}
+
+
+	IGCS_TEST(oddSizedImagesEncodeLikeScalarCode)
+	{
+		// Odd sizes make the encoder use the kernels for the full runs of a row and the scalar code for the rest of it, and pad the last
+		// MCU row and column. If the kernels match the scalar code, the encoded files are identical.
+		for(int width : OddSizes)
+		{
+			for(int height : OddSizes)
+			{
+				for(int numberOfChannels = 3; numberOfChannels <= 4; ++numberOfChannels)
+				{
+					const auto image = createNoiseImage(width, height, numberOfChannels, width * 1000 + height * 10 + numberOfChannels);
+					for(int subsample = 0; subsample <= 1; ++subsample)
+					{
+						const auto expected = encode(image, width, height, numberOfChannels, subsample, 0);
+						IGCS_CHECK(!expected.empty());
+						for(int simdLevel = 1; simdLevel <= getHighestSimdLevel(); ++simdLevel)
+						{
+							const auto actual = encode(image, width, height, numberOfChannels, subsample, simdLevel);
+							size_t numberOfDifferentBytes = expected.size() > actual.size() ? expected.size() - actual.size() : actual.size() - expected.size();
+							for(size_t i = 0; i < std::min(expected.size(), actual.size()); ++i)
+							{
+								numberOfDifferentBytes += expected[i] != actual[i] ? 1 : 0;
+							}
+							IGCS_CHECK_AT_MOST(numberOfDifferentBytes, (size_t)0, "simd level %d, %dx%d, %d channels, subsample %d", simdLevel, width, height,
+											   numberOfChannels, subsample);
+						}
+					}
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,186 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#include "../Qoi.h"
+#include "TestFramework.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <random>
+#include <vector>
+
+namespace IGCS::Tests
+{
+	namespace
+	{
+		enum class TestImage
+		{
+			Noise,				// mostly OpRGB(A), some OpIndex
+			Flat,				// runs, longer than the 62 pixels of a single OpRun
+			Alternating,		// two colors, OpIndex after the first row
+			Gradient,			// small steps, OpDiff and OpLuma
+		};
+
+		struct ImageSize
+		{
+			int width;
+			int height;
+		};
+
+		// 1x1, widths which aren't a multiple of 4 and an image which is larger than the encoder's 64KB write buffer.
+		const ImageSize ImageSizes[] = { { 1, 1 }, { 1, 7 }, { 2, 3 }, { 3, 3 }, { 5, 2 }, { 7, 9 }, { 13, 1 }, { 63, 5 }, { 67, 33 }, { 258, 131 } };
+
+		const char* getTestImageName(TestImage testImage)
+		{
+			switch(testImage)
+			{
+			case TestImage::Noise:
+				return "noise";
+			case TestImage::Flat:
+				return "flat";
+			case TestImage::Alternating:
+				return "alternating";
+			default:
+				return "gradient";
+			}
+		}
+
+
+		std::vector<uint8_t> createImage(TestImage testImage, int width, int height, int numberOfChannels)
+		{
+			std::mt19937 generator(width * 1000 + height * 10 + numberOfChannels);
+			std::vector<uint8_t> image((size_t)width * height * numberOfChannels);
+			for(int y = 0; y < height; ++y)
+			{
+				for(int x = 0; x < width; ++x)
+				{
+					uint8_t* pixel = image.data() + ((size_t)y * width + x) * numberOfChannels;
+					for(int channel = 0; channel < numberOfChannels; ++channel)
+					{
+						switch(testImage)
+						{
+						case TestImage::Noise:
+							pixel[channel] = (uint8_t)(generator() & 0xFF);
+							break;
+						case TestImage::Flat:
+							pixel[channel] = (uint8_t)(40 + channel * 50);
+							break;
+						case TestImage::Alternating:
+							pixel[channel] = (x + y) % 2 == 0 ? (uint8_t)(10 + channel) : (uint8_t)(245 - channel);
+							break;
+						case TestImage::Gradient:
+							pixel[channel] = (uint8_t)(x + y * (channel + 1) + (channel == 3 ? x / 16 : 0));
+							break;
+						}
+					}
+				}
+			}
+			return image;
+		}
+
+
+		void checkRoundTrip(const std::vector<uint8_t>& image, const std::vector<uint8_t>& encodedData, TestImage testImage, const ImageSize& size,
+							int numberOfChannels)
+		{
+			std::vector<uint8_t> decodedImage;
+			int decodedWidth = 0;
+			int decodedHeight = 0;
+			IGCS_CHECK(Qoi::decode(encodedData.data(), encodedData.size(), decodedImage, decodedWidth, decodedHeight, numberOfChannels));
+			IGCS_CHECK(decodedWidth == size.width && decodedHeight == size.height);
+			size_t numberOfDifferentBytes = decodedImage.size() == image.size() ? 0 : image.size();
+			for(size_t i = 0; i < std::min(decodedImage.size(), image.size()); ++i)
+			{
+				numberOfDifferentBytes += decodedImage[i] != image[i] ? 1 : 0;
+			}
+			IGCS_CHECK_AT_MOST(numberOfDifferentBytes, (size_t)0, "%s image, %dx%d, %d channels", getTestImageName(testImage), size.width, size.height, numberOfChannels);
+		}
+	}
+
+
+	IGCS_TEST(qoiImagesDecodeToTheEncodedPixels)
+	{
+		for(TestImage testImage : { TestImage::Noise, TestImage::Flat, TestImage::Alternating, TestImage::Gradient })
+		{
+			for(const auto& size : ImageSizes)
+			{
+				for(int numberOfChannels = 3; numberOfChannels <= 4; ++numberOfChannels)
+				{
+					const auto image = createImage(testImage, size.width, size.height, numberOfChannels);
+					std::vector<uint8_t> encodedData;
+					IGCS_CHECK(Qoi::encodeToMemory(encodedData, image.data(), size.width, size.height, numberOfChannels));
+					checkRoundTrip(image, encodedData, testImage, size, numberOfChannels);
+				}
+			}
+		}
+	}
+
+
+	IGCS_TEST(qoiFilesMatchTheEncodedMemory)
+	{
+		const auto filename = (std::filesystem::temp_directory_path() / "IgcsConnectorTests.qoi").string();
+		for(TestImage testImage : { TestImage::Noise, TestImage::Flat, TestImage::Alternating, TestImage::Gradient })
+		{
+			for(const auto& size : ImageSizes)
+			{
+				const int numberOfChannels = 4;
+				const auto image = createImage(testImage, size.width, size.height, numberOfChannels);
+				std::vector<uint8_t> encodedData;
+				IGCS_CHECK(Qoi::encodeToMemory(encodedData, image.data(), size.width, size.height, numberOfChannels));
+				IGCS_CHECK(Qoi::encodeToFile(filename, image.data(), size.width, size.height, numberOfChannels));
+				std::vector<uint8_t> fileContents(std::filesystem::file_size(filename));
+				FILE* file = std::fopen(filename.c_str(), "rb");
+				IGCS_CHECK(nullptr != file);
+				if(nullptr != file)
+				{
+					IGCS_CHECK(std::fread(fileContents.data(), 1, fileContents.size(), file) == fileContents.size());
+					std::fclose(file);
+				}
+				IGCS_CHECK(fileContents == encodedData);
+				checkRoundTrip(image, fileContents, testImage, size, numberOfChannels);
+			}
+		}
+		std::filesystem::remove(filename);
+	}
+
+
+	IGCS_TEST(qoiEncoderRejectsInvalidImages)
+	{
+		const std::vector<uint8_t> image(16 * 4, 0);
+		std::vector<uint8_t> encodedData;
+		IGCS_CHECK(!Qoi::encodeToMemory(encodedData, image.data(), 0, 4, 4));
+		IGCS_CHECK(!Qoi::encodeToMemory(encodedData, image.data(), 4, 0, 4));
+		IGCS_CHECK(!Qoi::encodeToMemory(encodedData, image.data(), 4, 4, 2));
+		IGCS_CHECK(!Qoi::encodeToMemory(encodedData, nullptr, 4, 4, 4));
+	}
+}
@@ -0,0 +1,77 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <cstdio>
+
+// Minimal test runner for the encoders and kernels of the addon which can run outside the game. Tests are registered with IGCS_TEST and run
+// by TestMain, which returns a non-zero exit code if a check failed. The test project runs the tests as a post build step, so a failing test
+// fails the build.
+namespace IGCS::Tests
+{
+	using TestFunction = void(*)();
+
+	/// <summary>
+	/// Adds the test to the tests TestMain runs. Used through IGCS_TEST, as a static object.
+	/// </summary>
+	struct TestRegistration
+	{
+		TestRegistration(const char* name, TestFunction function);
+	};
+
+	/// <summary>
+	/// Marks the running test as failed and logs where and why.
+	/// </summary>
+	void reportFailure(const char* file, int line, const char* message);
+}
+
+#define IGCS_TEST(name) \
+	static void name(); \
+	static IGCS::Tests::TestRegistration name##Registration(#name, &name); \
+	static void name()
+
+#define IGCS_CHECK(condition) \
+	do { if(!(condition)) { IGCS::Tests::reportFailure(__FILE__, __LINE__, #condition); } } while(false)
+
+// Checks value <= limit and logs both if it's not, with the context passed, a printf style format and its arguments.
+#define IGCS_CHECK_AT_MOST(value, limit, contextFormat, ...) \
+	do { \
+		const auto igcsValue = (value); \
+		const auto igcsLimit = (limit); \
+		if(!(igcsValue <= igcsLimit)) \
+		{ \
+			char igcsMessage[512]; \
+			std::snprintf(igcsMessage, sizeof(igcsMessage), "%s is %g, at most %g allowed. " contextFormat, #value, (double)igcsValue, (double)igcsLimit, __VA_ARGS__); \
+			IGCS::Tests::reportFailure(__FILE__, __LINE__, igcsMessage); \
+		} \
+	} while(false)
@@ -0,0 +1,89 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#include "TestFramework.h"
+#include <cstdio>
+#include <vector>
+
+namespace IGCS::Tests
+{
+	namespace
+	{
+		struct Test
+		{
+			const char* name;
+			TestFunction function;
+		};
+
+		// function local, as the tests register themselves during static initialization.
+		std::vector<Test>& getTests()
+		{
+			static std::vector<Test> tests;
+			return tests;
+		}
+
+		int numberOfFailuresInTest = 0;
+	}
+
+
+	TestRegistration::TestRegistration(const char* name, TestFunction function)
+	{
+		getTests().push_back({ name, function });
+	}
+
+
+	void reportFailure(const char* file, int line, const char* message)
+	{
+		// only the first few failures of a test, a kernel which is off is off for every pixel.
+		if(numberOfFailuresInTest < 10)
+		{
+			std::printf("%s(%d): check failed: %s\n", file, line, message);
+		}
+		numberOfFailuresInTest++;
+	}
+}
+
+
+int main()
+{
+	int numberOfFailedTests = 0;
+	for(const auto& test : IGCS::Tests::getTests())
+	{
+		IGCS::Tests::numberOfFailuresInTest = 0;
+		test.function();
+		std::printf("%s %s\n", IGCS::Tests::numberOfFailuresInTest == 0 ? "[passed]" : "[FAILED]", test.name);
+		numberOfFailedTests += IGCS::Tests::numberOfFailuresInTest == 0 ? 0 : 1;
+	}
+	std::printf("%zu tests, %d failed\n", IGCS::Tests::getTests().size(), numberOfFailedTests);
+	return numberOfFailedTests == 0 ? 0 : 1;
+}
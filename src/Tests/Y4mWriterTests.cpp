@@ -0,0 +1,74 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#include "../Y4mWriter.h"
+#include "TestFramework.h"
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <vector>
+
+namespace IGCS::Tests
+{
+	IGCS_TEST(y4mFramesStoreFullRangeYCbCr)
+	{
+		// red, green, blue, white and black, with their full range BT.601 YCbCr values. The chroma of pure red and pure blue is the maximum.
+		const std::vector<uint8_t> frame = { 255, 0, 0,  0, 255, 0,  0, 0, 255,  255, 255, 255,  0, 0, 0 };
+		const uint8_t expectedPlanes[] = { 76, 150, 29, 255, 0,			// Y
+										   85, 44, 255, 128, 128,		// Cb
+										   255, 21, 107, 128, 128 };	// Cr
+		const auto filename = (std::filesystem::temp_directory_path() / "IgcsConnectorTests.y4m").string();
+		Y4mWriter writer;
+		IGCS_CHECK(writer.open(filename, 5, 1, 30));
+		IGCS_CHECK(writer.appendFrame(0, frame.data()) > 0);
+		IGCS_CHECK(writer.close());
+
+		std::vector<uint8_t> fileContents(std::filesystem::file_size(filename));
+		FILE* file = std::fopen(filename.c_str(), "rb");
+		IGCS_CHECK(nullptr != file);
+		if(nullptr != file)
+		{
+			IGCS_CHECK(std::fread(fileContents.data(), 1, fileContents.size(), file) == fileContents.size());
+			std::fclose(file);
+		}
+		// the planes are the last bytes of the file, after the frame header.
+		IGCS_CHECK(fileContents.size() > sizeof(expectedPlanes));
+		if(fileContents.size() > sizeof(expectedPlanes))
+		{
+			IGCS_CHECK(std::memcmp(fileContents.data() + fileContents.size() - sizeof(expectedPlanes), expectedPlanes, sizeof(expectedPlanes)) == 0);
+		}
+		std::filesystem::remove(filename);
+		std::filesystem::remove(filename + ".idx");
+	}
+}
@@ -0,0 +1,105 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+#include "Thumbnail.h"
+#include <algorithm>
+#include <emmintrin.h>
+
+namespace IGCS::Thumbnail
+{
+	namespace
+	{
+		// adds the bytes of a source row to the 16 bit column sums. 256 rows of 255 still fit.
+		void accumulateRow(const uint8_t* source, uint16_t* columnSums, size_t numberOfBytes)
+		{
+			const __m128i zero = _mm_setzero_si128();
+			size_t i = 0;
+			for(; i + 16 <= numberOfBytes; i += 16)
+			{
+				const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+				__m128i* sums = reinterpret_cast<__m128i*>(columnSums + i);
+				_mm_storeu_si128(sums, _mm_add_epi16(_mm_loadu_si128(sums), _mm_unpacklo_epi8(bytes, zero)));
+				_mm_storeu_si128(sums + 1, _mm_add_epi16(_mm_loadu_si128(sums + 1), _mm_unpackhi_epi8(bytes, zero)));
+			}
+			for(; i < numberOfBytes; i++)
+			{
+				columnSums[i] += source[i];
+			}
+		}
+	}
+
+
+	bool downscaleBox(const uint8_t* data, uint32_t width, uint32_t height, uint32_t thumbnailWidth, uint32_t thumbnailHeight, std::vector<uint8_t>& thumbnail)
+	{
+		if(nullptr == data || thumbnailWidth == 0 || thumbnailHeight == 0 || thumbnailWidth > width || thumbnailHeight > height || 
+		   (height + thumbnailHeight - 1) / thumbnailHeight > 256)
+		{
+			return false;
+		}
+		thumbnail.resize((size_t)thumbnailWidth * thumbnailHeight * 4);
+		const size_t rowSize = (size_t)width * 3;
+		std::vector<uint16_t> columnSums(rowSize);
+		for(uint32_t y = 0; y < thumbnailHeight; y++)
+		{
+			// the blocks differ at most a pixel in size if the sizes aren't a multiple of each other.
+			const uint32_t firstRow = (uint32_t)((uint64_t)y * height / thumbnailHeight);
+			const uint32_t endRow = (uint32_t)((uint64_t)(y + 1) * height / thumbnailHeight);
+			std::fill(columnSums.begin(), columnSums.end(), (uint16_t)0);
+			for(uint32_t row = firstRow; row < endRow; row++)
+			{
+				accumulateRow(data + row * rowSize, columnSums.data(), rowSize);
+			}
+			uint8_t* destination = thumbnail.data() + (size_t)y * thumbnailWidth * 4;
+			for(uint32_t x = 0; x < thumbnailWidth; x++)
+			{
+				const uint32_t firstColumn = (uint32_t)((uint64_t)x * width / thumbnailWidth);
+				const uint32_t endColumn = (uint32_t)((uint64_t)(x + 1) * width / thumbnailWidth);
+				uint32_t sums[3] = { 0, 0, 0 };
+				for(uint32_t column = firstColumn; column < endColumn; column++)
+				{
+					sums[0] += columnSums[column * 3];
+					sums[1] += columnSums[column * 3 + 1];
+					sums[2] += columnSums[column * 3 + 2];
+				}
+				const uint32_t numberOfPixels = (endColumn - firstColumn) * (endRow - firstRow);
+				for(int channel = 0; channel < 3; channel++)
+				{
+					destination[x * 4 + channel] = (uint8_t)((sums[channel] + numberOfPixels / 2) / numberOfPixels);
+				}
+				destination[x * 4 + 3] = 255;
+			}
+		}
+		return true;
+	}
+}
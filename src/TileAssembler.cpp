@@ -0,0 +1,143 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+#include "TileAssembler.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+bool TileAssembler::begin(const std::string& filename, uint32_t tileWidth, uint32_t tileHeight, int numberOfColumns, int numberOfRows, float overlapPercentage)
+{
+	clear();
+	if(tileWidth == 0 || tileHeight == 0 || numberOfColumns < 1 || numberOfRows < 1)
+	{
+		return false;
+	}
+	_tileWidth = tileWidth;
+	_tileHeight = tileHeight;
+	_croppedTileWidth = getCroppedSize(tileWidth, overlapPercentage);
+	_croppedTileHeight = getCroppedSize(tileHeight, overlapPercentage);
+	_cropLeft = (tileWidth - _croppedTileWidth) / 2;
+	_cropTop = (tileHeight - _croppedTileHeight) / 2;
+	_numberOfColumns = numberOfColumns;
+	_numberOfRows = numberOfRows;
+	_writePng = filename.ends_with(".png");
+	const bool opened = _writePng ? _pngWriter.open(filename, getImageWidth(), getImageHeight()) : _writer.open(filename, getImageWidth(), getImageHeight());
+	if(!opened)
+	{
+		return false;
+	}
+	_band.assign((size_t)getImageWidth() * _croppedTileHeight * 3, 0);
+	return true;
+}
+
+
+void TileAssembler::addTile(int tileIndex, const uint8_t* data)
+{
+	if(!isActive() || nullptr == data || tileIndex <= _lastTileAdded || tileIndex >= _numberOfColumns * _numberOfRows)
+	{
+		return;
+	}
+	_lastTileAdded = tileIndex;
+	const int row = tileIndex / _numberOfColumns;
+	const int column = tileIndex % _numberOfColumns;
+	if(_bandRow >= 0 && _bandRow != row)
+	{
+		// the last tile of the previous row was skipped.
+		writeBand();
+	}
+	_bandRow = row;
+	const size_t tileRowSize = (size_t)_tileWidth * 3;
+	const size_t bandRowSize = (size_t)getImageWidth() * 3;
+	const size_t croppedRowSize = (size_t)_croppedTileWidth * 3;
+	for(uint32_t y = 0; y < _croppedTileHeight; y++)
+	{
+		memcpy(_band.data() + y * bandRowSize + column * croppedRowSize, data + (_cropTop + y) * tileRowSize + _cropLeft * 3, croppedRowSize);
+	}
+	if(column == _numberOfColumns - 1)
+	{
+		writeBand();
+	}
+}
+
+
+bool TileAssembler::finish()
+{
+	if(!isActive())
+	{
+		return false;
+	}
+	if(_bandRow >= 0)
+	{
+		writeBand();
+	}
+	const bool allTilesAdded = _lastTileAdded == _numberOfColumns * _numberOfRows - 1;
+	const bool closed = _writePng ? _pngWriter.close() : _writer.close();
+	const bool succeeded = closed && !_writeFailed && allTilesAdded;
+	clear();
+	return succeeded;
+}
+
+
+void TileAssembler::clear()
+{
+	_writer.close();
+	_pngWriter.close();
+	_band.clear();
+	_band.shrink_to_fit();
+	_lastTileAdded = -1;
+	_bandRow = -1;
+	_writeFailed = false;
+}
+
+
+uint32_t TileAssembler::getCroppedSize(uint32_t size, float overlapPercentage)
+{
+	const float overlapFraction = std::clamp(overlapPercentage, 0.0f, 90.0f) / 100.0f;
+	return (std::max)(1u, (uint32_t)std::lround(size * (1.0f - overlapFraction)));
+}
+
+
+void TileAssembler::writeBand()
+{
+	const uint32_t firstRow = _bandRow * _croppedTileHeight;
+	const bool written = _writePng ? _pngWriter.writeRows(firstRow, _croppedTileHeight, _band.data()) : _writer.writeRows(firstRow, _croppedTileHeight, _band.data());
+	if(!written)
+	{
+		_writeFailed = true;
+	}
+	// rows of which tiles are skipped stay black.
+	std::fill(_band.begin(), _band.end(), (uint8_t)0);
+	_bandRow = -1;
+}
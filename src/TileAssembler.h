@@ -0,0 +1,96 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "StreamingBmpWriter.h"
+#include "StreamingPngWriter.h"
+
+/// <summary>
+/// Assembles the tiles of a tiled grid session into a single image which is streamed to a BMP file one row of tiles at a time, so only one
+/// row of tiles is in memory, no matter how large the image is. If the filename ends with .png, a PNG file is written instead. Tiles are numbered left to right, top to bottom and have to be added in
+/// that order. Of every tile only the center is used: the overlap with the neighboring tiles is cut off, half on either side.
+/// </summary>
+class TileAssembler
+{
+public:
+	TileAssembler() = default;
+	TileAssembler(const TileAssembler&) = delete;
+	TileAssembler& operator=(const TileAssembler&) = delete;
+
+	/// <summary>
+	/// Creates the BMP or PNG file with the name specified for a grid of numberOfColumns x numberOfRows RGB tiles of tileWidth x tileHeight pixels.
+	/// </summary>
+	/// <param name="overlapPercentage">the percentage of a tile which overlaps with its neighbors</param>
+	/// <returns>true if the file was created, false otherwise</returns>
+	bool begin(const std::string& filename, uint32_t tileWidth, uint32_t tileHeight, int numberOfColumns, int numberOfRows, float overlapPercentage);
+	/// <summary>
+	/// Adds the RGB tile in data as tile tileIndex. When the last tile of a row has been added, the row is written to the file.
+	/// </summary>
+	void addTile(int tileIndex, const uint8_t* data);
+	/// <summary>
+	/// Writes the last row of tiles, if it hasn't been written yet, and closes the file. Missing tiles are black.
+	/// </summary>
+	/// <returns>true if the whole image was written, false otherwise</returns>
+	bool finish();
+	void clear();
+	bool isActive() const { return _writePng ? _pngWriter.isOpen() : _writer.isOpen(); }
+	uint32_t getImageWidth() const { return _numberOfColumns * _croppedTileWidth; }
+	uint32_t getImageHeight() const { return _numberOfRows * _croppedTileHeight; }
+
+	/// <summary>
+	/// Returns the part of a tile which is left after cutting off the overlap, in pixels.
+	/// </summary>
+	static uint32_t getCroppedSize(uint32_t size, float overlapPercentage);
+
+private:
+	void writeBand();
+
+	StreamingBmpWriter _writer;
+	StreamingPngWriter _pngWriter;
+	bool _writePng = false;
+	uint32_t _tileWidth = 0;
+	uint32_t _tileHeight = 0;
+	uint32_t _croppedTileWidth = 0;
+	uint32_t _croppedTileHeight = 0;
+	uint32_t _cropLeft = 0;
+	uint32_t _cropTop = 0;
+	int _numberOfColumns = 0;
+	int _numberOfRows = 0;
+	int _lastTileAdded = -1;
+	int _bandRow = -1;					// the row of tiles in _band, -1 if _band is empty
+	bool _writeFailed = false;
+	std::vector<uint8_t> _band;			// one row of cropped tiles, RGB
+};
@@ -53,6 +53,12 @@ namespace IGCS::Utils
 	}
 
 
+	float radiansToDegrees(float angleInRadians)
+	{
+		return 180 * (angleInRadians / DirectX::XM_PI);
+	}
+
+
 	string formatString(const char *fmt, ...)
 	{
 		va_list args;
@@ -69,12 +75,32 @@ namespace IGCS::Utils
 		va_copy(args_copy, args);
 
 		int len = vsnprintf(NULL, 0, fmt, args_copy);
-		char* buffer = new char[len + 2];
-		vsnprintf(buffer, len + 1, fmt, args_copy);
-		string toReturn(buffer, len + 1);
-		return toReturn;
+		va_end(args_copy);
+		if(len <= 0)
+		{
+			return "";
+		}
+		// the terminating 0 isn't part of the string, otherwise appending to the result produces a string which ends at the 0.
+		vector<char> buffer(len + 1);
+		vsnprintf(buffer.data(), buffer.size(), fmt, args);
+		return string(buffer.data(), len);
 	}
 
+	string toJsonString(const string& value)
+	{
+		string toReturn = "\"";
+		for(const char c : value)
+		{
+			if(c == '"' || c == '\\')
+			{
+				toReturn += '\\';
+			}
+			toReturn += c;
+		}
+		return toReturn + "\"";
+	}
+
+
 	bool stringStartsWith(const char *a, const char *b)
 	{
 		return strncmp(a, b, strlen(b)) == 0 ? 1 : 0;
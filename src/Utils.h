@@ -33,9 +33,14 @@
 namespace IGCS::Utils
 {
 	float degreesToRadians(float angleInDegrees);
+	float radiansToDegrees(float angleInRadians);
 	std::string formatString(const char* fmt, ...);
 	std::string formatStringVa(const char* fmt, va_list args);
 	void logLineToReshade(const reshade::log::level logLevel, const char* fmt, ...);
+	/// <summary>
+	/// Returns value as a quoted JSON string, with quotes and backslashes escaped.
+	/// </summary>
+	std::string toJsonString(const std::string& value);
 
 	BYTE CharToByte(char c);
 	bool stringStartsWith(const char *a, const char *b);
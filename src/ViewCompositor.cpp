@@ -0,0 +1,110 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+#include "ViewCompositor.h"
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+namespace
+{
+	// copying is bound by memory bandwidth, so a band has to be large enough to be worth a thread.
+	constexpr uint32_t MinimumNumberOfRowsPerBand = 128;
+}
+
+
+bool ViewCompositor::begin(uint32_t viewWidth, uint32_t viewHeight, int numberOfViews, ViewLayout layout, bool reverseViews)
+{
+	clear();
+	if(viewWidth == 0 || viewHeight == 0 || numberOfViews <= 0)
+	{
+		return false;
+	}
+	_viewWidth = viewWidth;
+	_viewHeight = viewHeight;
+	_numberOfViews = (uint32_t)numberOfViews;
+	_layout = layout;
+	_reverseViews = reverseViews;
+	_image.assign((size_t)getImageWidth() * getImageHeight() * 3, 0);
+	return true;
+}
+
+
+void ViewCompositor::addView(int viewIndex, const uint8_t* data, int maxNumberOfThreads)
+{
+	if(!isActive() || nullptr == data || viewIndex < 0 || (uint32_t)viewIndex >= _numberOfViews)
+	{
+		return;
+	}
+	const uint32_t position = _reverseViews ? _numberOfViews - 1 - (uint32_t)viewIndex : (uint32_t)viewIndex;
+	uint8_t* viewTopLeft = _layout == ViewLayout::SideBySide ? _image.data() + (size_t)position * _viewWidth * 3
+															  : _image.data() + (size_t)position * _viewHeight * _viewWidth * 3;
+
+	uint32_t numberOfBands = maxNumberOfThreads > 0 ? (uint32_t)maxNumberOfThreads : (std::max)(1u, std::thread::hardware_concurrency());
+	numberOfBands = (std::min)(numberOfBands, (std::max)(1u, _viewHeight / MinimumNumberOfRowsPerBand));
+	const uint32_t rowsPerBand = (_viewHeight + numberOfBands - 1) / numberOfBands;
+	// Band 0 is copied on the calling thread.
+	std::vector<std::thread> threads;
+	threads.reserve(numberOfBands - 1);
+	for(uint32_t i = 1; i < numberOfBands && i * rowsPerBand < _viewHeight; i++)
+	{
+		threads.emplace_back(&ViewCompositor::copyRows, this, data, viewTopLeft, i * rowsPerBand, (std::min)(_viewHeight, (i + 1) * rowsPerBand));
+	}
+	copyRows(data, viewTopLeft, 0, (std::min)(_viewHeight, rowsPerBand));
+	for(auto& thread : threads)
+	{
+		thread.join();
+	}
+}
+
+
+void ViewCompositor::clear()
+{
+	_image.clear();
+	_image.shrink_to_fit();
+	_viewWidth = 0;
+	_viewHeight = 0;
+	_numberOfViews = 0;
+}
+
+
+void ViewCompositor::copyRows(const uint8_t* data, uint8_t* viewTopLeft, uint32_t firstRow, uint32_t endRow) const
+{
+	const size_t viewRowSize = (size_t)_viewWidth * 3;
+	const size_t imageRowSize = (size_t)getImageWidth() * 3;
+	for(uint32_t y = firstRow; y < endRow; y++)
+	{
+		memcpy(viewTopLeft + y * imageRowSize, data + y * viewRowSize, viewRowSize);
+	}
+}
@@ -0,0 +1,78 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "ConstantsEnums.h"
+
+/// <summary>
+/// Composes the views of a stereo (or N-view) session into a single image: next to each other, view 0 at the left, or stacked, view 0 at
+/// the top. Views can be composed in reverse order, e.g. for cross-eyed viewing of a stereo pair.
+/// </summary>
+class ViewCompositor
+{
+public:
+	ViewCompositor() = default;
+	ViewCompositor(const ViewCompositor&) = delete;
+	ViewCompositor& operator=(const ViewCompositor&) = delete;
+
+	/// <summary>
+	/// Clears the compositor and prepares a black image for numberOfViews RGB views of viewWidth x viewHeight pixels, laid out as specified.
+	/// </summary>
+	/// <returns>true if the image was set up, false if one of the sizes is invalid</returns>
+	bool begin(uint32_t viewWidth, uint32_t viewHeight, int numberOfViews, ViewLayout layout, bool reverseViews);
+	/// <summary>
+	/// Copies the RGB view in data to its place in the image. Views can be added in any order. The rows of the view are spread over
+	/// maxNumberOfThreads threads (0: one per hardware thread).
+	/// </summary>
+	void addView(int viewIndex, const uint8_t* data, int maxNumberOfThreads = 0);
+	/// <summary>
+	/// Releases the image.
+	/// </summary>
+	void clear();
+	bool isActive() const { return !_image.empty(); }
+	const uint8_t* getImage() const { return _image.data(); }
+	uint32_t getImageWidth() const { return _layout == ViewLayout::SideBySide ? _viewWidth * _numberOfViews : _viewWidth; }
+	uint32_t getImageHeight() const { return _layout == ViewLayout::SideBySide ? _viewHeight : _viewHeight * _numberOfViews; }
+
+private:
+	void copyRows(const uint8_t* data, uint8_t* viewTopLeft, uint32_t firstRow, uint32_t endRow) const;
+
+	uint32_t _viewWidth = 0;
+	uint32_t _viewHeight = 0;
+	uint32_t _numberOfViews = 0;
+	ViewLayout _layout = ViewLayout::SideBySide;
+	bool _reverseViews = false;
+	std::vector<uint8_t> _image;		// RGB
+};
@@ -0,0 +1,135 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+#include "WorkerPool.h"
+
+WorkerPool::WorkerPool(int numberOfWorkers, int maxNumberOfQueuedJobs) : _sharedState(std::make_shared<SharedState>()),
+	_numberOfWorkers(numberOfWorkers < 1 ? 1 : numberOfWorkers), _maxNumberOfQueuedJobs(maxNumberOfQueuedJobs < 1 ? 1 : (size_t)maxNumberOfQueuedJobs)
+{
+}
+
+
+WorkerPool::~WorkerPool()
+{
+	if(_workers.empty())
+	{
+		return;
+	}
+	// shutdown wasn't called. The pool is destroyed when the dll is unloaded, inside DllMain, where joining the workers would deadlock on
+	// the loader lock. All we can do is ask them to stop and let go of them: they own the shared state.
+	requestStop();
+	for(std::thread& worker : _workers)
+	{
+		worker.detach();
+	}
+}
+
+
+void WorkerPool::shutdown()
+{
+	requestStop();
+	for(std::thread& worker : _workers)
+	{
+		worker.join();
+	}
+	_workers.clear();
+	std::unique_lock lock(_sharedState->mutex);
+	_sharedState->stopRequested = false;
+}
+
+
+void WorkerPool::requestStop()
+{
+	{
+		std::unique_lock lock(_sharedState->mutex);
+		_sharedState->stopRequested = true;
+		for(QueuedJob& queuedJob : _sharedState->queuedJobs)
+		{
+			queuedJob.cancellationToken.cancel();
+		}
+		_sharedState->queuedJobs.clear();
+		for(CancellationToken& runningJob : _sharedState->runningJobs)
+		{
+			runningJob.cancel();
+		}
+	}
+	_sharedState->jobAvailable.notify_all();
+}
+
+
+bool WorkerPool::submit(Job job, CancellationToken cancellationToken)
+{
+	{
+		std::unique_lock lock(_sharedState->mutex);
+		if(_sharedState->stopRequested || _sharedState->queuedJobs.size() >= _maxNumberOfQueuedJobs)
+		{
+			return false;
+		}
+		_sharedState->queuedJobs.push_back({ std::move(job), std::move(cancellationToken) });
+	}
+	if(_workers.empty())
+	{
+		for(int i = 0; i < _numberOfWorkers; i++)
+		{
+			_workers.emplace_back(&WorkerPool::runWorker, _sharedState);
+		}
+	}
+	_sharedState->jobAvailable.notify_one();
+	return true;
+}
+
+
+void WorkerPool::runWorker(std::shared_ptr<SharedState> sharedState)
+{
+	for(;;)
+	{
+		QueuedJob queuedJob;
+		std::list<CancellationToken>::iterator runningJob;
+		{
+			std::unique_lock lock(sharedState->mutex);
+			sharedState->jobAvailable.wait(lock, [&] { return sharedState->stopRequested || !sharedState->queuedJobs.empty(); });
+			if(sharedState->stopRequested)
+			{
+				return;
+			}
+			queuedJob = std::move(sharedState->queuedJobs.front());
+			sharedState->queuedJobs.pop_front();
+			// so a stop request can cancel the job while it runs.
+			runningJob = sharedState->runningJobs.insert(sharedState->runningJobs.end(), queuedJob.cancellationToken);
+		}
+		queuedJob.job(queuedJob.cancellationToken);
+		std::unique_lock lock(sharedState->mutex);
+		sharedState->runningJobs.erase(runningJob);
+	}
+}
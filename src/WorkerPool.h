@@ -0,0 +1,114 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// <summary>
+/// Flag which is used to ask a running job to stop. Copies share the same flag.
+/// </summary>
+class CancellationToken
+{
+public:
+	CancellationToken() : _cancellationRequested(std::make_shared<std::atomic<bool>>(false)) {}
+
+	void cancel() { _cancellationRequested->store(true); }
+	bool isCancellationRequested() const { return _cancellationRequested->load(); }
+
+private:
+	std::shared_ptr<std::atomic<bool>> _cancellationRequested;
+};
+
+
+/// <summary>
+/// Persistent pool of worker threads which run the jobs submitted in the order they were submitted. The threads are started when the first
+/// job is submitted and then kept around, so subsequent jobs don't pay for thread creation. The number of jobs waiting to run is bounded.
+/// The threads have to be stopped with shutdown before the dll is unloaded, as that can't be done in DllMain.
+/// </summary>
+class WorkerPool
+{
+public:
+	using Job = std::function<void(const CancellationToken&)>;
+
+	WorkerPool(int numberOfWorkers, int maxNumberOfQueuedJobs);
+	~WorkerPool();
+	WorkerPool(const WorkerPool&) = delete;
+	WorkerPool& operator=(const WorkerPool&) = delete;
+
+	/// <summary>
+	/// Queues the job to run on one of the workers. The job receives the token specified, which it has to check to see whether it has to stop.
+	/// </summary>
+	/// <returns>true if the job was queued, false if the maximum number of queued jobs has been reached</returns>
+	bool submit(Job job, CancellationToken cancellationToken);
+	/// <summary>
+	/// Cancels the queued and running jobs, and waits till the workers have stopped. Submitting a job afterwards starts the workers again.
+	/// Has to be called on the thread which submits the jobs, and not from inside DllMain.
+	/// </summary>
+	void shutdown();
+
+private:
+	struct QueuedJob
+	{
+		Job job;
+		CancellationToken cancellationToken;
+	};
+
+	// the state shared with the workers. It's kept alive by the workers themselves, see the destructor.
+	struct SharedState
+	{
+		std::mutex mutex;
+		std::condition_variable jobAvailable;
+		std::deque<QueuedJob> queuedJobs;		// guarded by mutex
+		std::list<CancellationToken> runningJobs;	// the tokens of the jobs being run, guarded by mutex
+		bool stopRequested = false;				// guarded by mutex
+	};
+
+	static void runWorker(std::shared_ptr<SharedState> sharedState);
+	/// <summary>
+	/// Tells the workers to stop and cancels the queued and running jobs.
+	/// </summary>
+	void requestStop();
+
+	std::shared_ptr<SharedState> _sharedState;
+	std::vector<std::thread> _workers;			// only touched by the thread submitting jobs
+	int _numberOfWorkers;
+	size_t _maxNumberOfQueuedJobs;
+};
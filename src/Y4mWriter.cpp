@@ -0,0 +1,218 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+#include "Y4mWriter.h"
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+	// big enough to keep the number of writes per frame low, small enough to not matter next to the shots themselves.
+	constexpr size_t StagingBufferSize = 8 * 1024 * 1024;
+	const char FrameHeader[] = "FRAME\n";
+	constexpr size_t FrameHeaderLength = sizeof(FrameHeader) - 1;
+
+	// Full range BT.601 coefficients in 16.16 fixed point, the same conversion jpeg uses. The chroma of pure blue and pure red rounds up to 256,
+	// so chroma is clamped before it's stored in a byte.
+	inline uint8_t toY(const uint8_t* rgb)
+	{
+		return (uint8_t)((19595 * rgb[0] + 38470 * rgb[1] + 7471 * rgb[2] + 32768) >> 16);
+	}
+
+	inline uint8_t toCb(const uint8_t* rgb)
+	{
+		return (uint8_t)(std::min)((-11059 * rgb[0] - 21709 * rgb[1] + 32768 * rgb[2] + (128 << 16) + 32768) >> 16, 255);
+	}
+
+	inline uint8_t toCr(const uint8_t* rgb)
+	{
+		return (uint8_t)(std::min)((32768 * rgb[0] - 27439 * rgb[1] - 5329 * rgb[2] + (128 << 16) + 32768) >> 16, 255);
+	}
+}
+
+
+Y4mWriter::~Y4mWriter()
+{
+	close();
+}
+
+
+bool Y4mWriter::open(const std::string& filename, uint32_t width, uint32_t height, int framesPerSecond)
+{
+	close();
+	if(width == 0 || height == 0 || framesPerSecond <= 0)
+	{
+		return false;
+	}
+	if(fopen_s(&_file, filename.c_str(), "wb") != 0)
+	{
+		_file = nullptr;
+		return false;
+	}
+	_filename = filename;
+	_width = width;
+	_height = height;
+	_bytesWritten = 0;
+	_writeFailed = false;
+	_stagingBuffer.resize(StagingBufferSize);
+	_bytesInStagingBuffer = 0;
+	_planeRow.resize(width);
+	_frameIndex.clear();
+	// we do our own buffering.
+	setvbuf(_file, nullptr, _IONBF, 0);
+
+	char header[128];
+	const int headerLength = snprintf(header, sizeof(header), "YUV4MPEG2 W%u H%u F%d:1 Ip A1:1 C444 XCOLORRANGE=FULL\n", width, height, framesPerSecond);
+	if(headerLength <= 0 || !writeBuffered((const uint8_t*)header, (size_t)headerLength))
+	{
+		close();
+		return false;
+	}
+	return true;
+}
+
+
+uint64_t Y4mWriter::appendFrame(int frameNumber, const uint8_t* data)
+{
+	if(!isOpen() || nullptr == data || _writeFailed)
+	{
+		return 0;
+	}
+	const uint64_t frameStart = _bytesWritten;
+	if(!writeBuffered((const uint8_t*)FrameHeader, FrameHeaderLength))
+	{
+		return 0;
+	}
+	const uint64_t planeDataOffset = _bytesWritten;
+	// the planes are stored one after the other: Y, Cb, Cr. Every plane gets its own loop, with the conversion inlined, as this runs for every pixel
+	// three times.
+	const auto writePlane = [&](auto convert)
+		{
+			for(uint32_t y = 0; y < _height; y++)
+			{
+				const uint8_t* source = data + (size_t)y * _width * 3;
+				for(uint32_t x = 0; x < _width; x++)
+				{
+					_planeRow[x] = convert(source + x * 3);
+				}
+				if(!writeBuffered(_planeRow.data(), _width))
+				{
+					return false;
+				}
+			}
+			return true;
+		};
+	if(!writePlane([](const uint8_t* rgb) { return toY(rgb); }) || !writePlane([](const uint8_t* rgb) { return toCb(rgb); }) ||
+	   !writePlane([](const uint8_t* rgb) { return toCr(rgb); }))
+	{
+		return 0;
+	}
+	_frameIndex.emplace_back(frameNumber, planeDataOffset);
+	return _bytesWritten - frameStart;
+}
+
+
+bool Y4mWriter::close()
+{
+	if(nullptr == _file)
+	{
+		return false;
+	}
+	const bool flushed = flushBuffer();
+	const bool closed = fclose(_file) == 0;
+	_file = nullptr;
+	bool succeeded = flushed && closed && !_writeFailed;
+	if(succeeded)
+	{
+		succeeded = writeIndex();
+	}
+	_stagingBuffer.clear();
+	_stagingBuffer.shrink_to_fit();
+	_planeRow.clear();
+	_frameIndex.clear();
+	return succeeded;
+}
+
+
+bool Y4mWriter::writeBuffered(const uint8_t* data, size_t size)
+{
+	while(size > 0)
+	{
+		if(_bytesInStagingBuffer == _stagingBuffer.size() && !flushBuffer())
+		{
+			return false;
+		}
+		const size_t bytesToCopy = (std::min)(size, _stagingBuffer.size() - _bytesInStagingBuffer);
+		memcpy(_stagingBuffer.data() + _bytesInStagingBuffer, data, bytesToCopy);
+		_bytesInStagingBuffer += bytesToCopy;
+		_bytesWritten += bytesToCopy;
+		data += bytesToCopy;
+		size -= bytesToCopy;
+	}
+	return true;
+}
+
+
+bool Y4mWriter::flushBuffer()
+{
+	if(_bytesInStagingBuffer == 0)
+	{
+		return !_writeFailed;
+	}
+	if(fwrite(_stagingBuffer.data(), 1, _bytesInStagingBuffer, _file) != _bytesInStagingBuffer)
+	{
+		_writeFailed = true;
+	}
+	_bytesInStagingBuffer = 0;
+	return !_writeFailed;
+}
+
+
+bool Y4mWriter::writeIndex()
+{
+	FILE* indexFile;
+	if(fopen_s(&indexFile, (_filename + ".idx").c_str(), "w") != 0)
+	{
+		return false;
+	}
+	// plain text, one line per frame, so it's usable from scripts without knowing the container format.
+	bool succeeded = fprintf(indexFile, "frame offset size\n") > 0;
+	const uint64_t frameSize = (uint64_t)_width * _height * 3;
+	for(const auto& [frameNumber, offset] : _frameIndex)
+	{
+		succeeded &= fprintf(indexFile, "%d %llu %llu\n", frameNumber, (unsigned long long)offset, (unsigned long long)frameSize) > 0;
+	}
+	succeeded &= fclose(indexFile) == 0;
+	return succeeded;
+}
@@ -0,0 +1,90 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of IGCS Connector, an add on for Reshade 5+ which allows you
+// to connect IGCS built camera tools with reshade to exchange data and control
+// from Reshade.
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/IgcsConnector
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <utility>
+#include <vector>
+
+/// <summary>
+/// Writes RGB frames of equal size into a single YUV4MPEG2 (.y4m) file, which video tools like ffmpeg read directly. Frames are converted to
+/// full range 4:4:4 YCbCr and appended through a large staging buffer, so the disk sees few, large sequential writes instead of a file
+/// create/write/close per frame. When the file is closed, an index is written next to it (filename + ".idx") which maps every frame number
+/// to the offset of its data in the container.
+/// </summary>
+class Y4mWriter
+{
+public:
+	Y4mWriter() = default;
+	~Y4mWriter();
+	Y4mWriter(const Y4mWriter&) = delete;
+	Y4mWriter& operator=(const Y4mWriter&) = delete;
+
+	/// <summary>
+	/// Creates the file with the name specified and writes the stream header for frames of width x height pixels. Closes the current file, if any.
+	/// </summary>
+	/// <returns>true if the file was created, false otherwise</returns>
+	bool open(const std::string& filename, uint32_t width, uint32_t height, int framesPerSecond);
+	/// <summary>
+	/// Appends the RGB frame in data, which is width x height pixels, as the frame with the number specified.
+	/// </summary>
+	/// <returns>the number of bytes the frame takes in the container, or 0 if the frame couldn't be written</returns>
+	uint64_t appendFrame(int frameNumber, const uint8_t* data);
+	/// <summary>
+	/// Flushes the buffered frames, closes the file and writes the frame index.
+	/// </summary>
+	/// <returns>true if all writes succeeded, false otherwise</returns>
+	bool close();
+	bool isOpen() const { return nullptr != _file; }
+	uint32_t getWidth() const { return _width; }
+	uint32_t getHeight() const { return _height; }
+	int getNumberOfFrames() const { return (int)_frameIndex.size(); }
+
+private:
+	bool writeBuffered(const uint8_t* data, size_t size);
+	bool flushBuffer();
+	bool writeIndex();
+
+	FILE* _file = nullptr;
+	std::string _filename;
+	uint32_t _width = 0;
+	uint32_t _height = 0;
+	uint64_t _bytesWritten = 0;			// offset in the file of the next byte written, including the bytes still in the staging buffer.
+	bool _writeFailed = false;
+	std::vector<uint8_t> _stagingBuffer;
+	size_t _bytesInStagingBuffer = 0;
+	std::vector<uint8_t> _planeRow;
+	std::vector<std::pair<int, uint64_t>> _frameIndex;		// frame number, offset of the frame's plane data
+};
@@ -15,6 +15,8 @@
 #include "fpng.h"
 #include <assert.h>
 #include <string.h>
+#include <atomic>
+#include <thread>
 
 #ifdef _MSC_VER
 	#pragma warning (disable:4127) // conditional expression is constant
@@ -40,6 +42,7 @@
 	#include <emmintrin.h>		// SSE2
 	#include <smmintrin.h>		// SSE4.1
 	#include <wmmintrin.h>		// pclmul
+	#include <immintrin.h>		// AVX2
 #endif
 
 #ifndef FPNG_NO_STDIO
@@ -313,7 +316,7 @@ namespace fpng
 	{
 		cpu_info() { memset(this, 0, sizeof(*this)); }
 
-		bool m_initialized, m_has_fpu, m_has_mmx, m_has_sse, m_has_sse2, m_has_sse3, m_has_ssse3, m_has_sse41, m_has_sse42, m_has_avx, m_has_avx2, m_has_pclmulqdq;
+		bool m_initialized, m_has_fpu, m_has_mmx, m_has_sse, m_has_sse2, m_has_sse3, m_has_ssse3, m_has_sse41, m_has_sse42, m_has_avx, m_has_avx2, m_has_pclmulqdq, m_os_saves_ymm;
 				
 		void init()
 		{
@@ -337,6 +340,8 @@ namespace fpng
 				do_cpuid(1, 0, (uint32_t*)regs);
 #endif
 				extract_x86_flags(regs[2], regs[3]);
+				// AVX2 can only be used if the OS saves the ymm registers on a context switch: osxsave, and xmm/ymm state enabled in XCR0.
+				m_os_saves_ymm = (regs[2] & (1 << 27)) != 0 && m_has_avx && (_xgetbv(0) & 6) == 6;
 			}
 
 			if (max_eax >= 7U)
@@ -354,6 +359,17 @@ namespace fpng
 
 		bool can_use_sse41() const { return m_has_sse && m_has_sse2 && m_has_sse3 && m_has_ssse3 && m_has_sse41; }
 		bool can_use_pclmul() const	{ return m_has_pclmulqdq && can_use_sse41(); }
+		bool can_use_avx2() const { return m_has_avx2 && m_os_saves_ymm && can_use_sse41(); }
+
+		// Uses the features detected by the caller instead of detecting them, so the whole addon dispatches on the same features.
+		void init(const fpng_cpu_features& features)
+		{
+			memset(this, 0, sizeof(*this));
+			m_has_sse = m_has_sse2 = m_has_sse3 = m_has_ssse3 = m_has_sse41 = features.m_sse41;
+			m_has_pclmulqdq = features.m_pclmul;
+			m_has_avx = m_has_avx2 = m_os_saves_ymm = features.m_avx2;
+			m_initialized = true;
+		}
 
 	private:
 		void extract_x86_flags(uint32_t ecx, uint32_t edx)
@@ -372,10 +388,19 @@ namespace fpng
 	{
 		g_cpu_info.init();
 	}
+
+	void fpng_init(const fpng_cpu_features& features)
+	{
+		g_cpu_info.init(features);
+	}
 #else
 	void fpng_init()
 	{
 	}
+
+	void fpng_init(const fpng_cpu_features&)
+	{
+	}
 #endif
 
 	bool fpng_cpu_supports_sse41()
@@ -388,6 +413,15 @@ namespace fpng
 #endif
 	}
 
+	bool fpng_cpu_supports_avx2()
+	{
+#if FPNG_X86_OR_X64_CPU && !FPNG_NO_SSE 
+		return g_cpu_info.can_use_avx2();
+#else
+		return false;
+#endif
+	}
+
 	uint32_t fpng_crc32(const void* pData, size_t size, uint32_t prev_crc32)
 	{
 #if FPNG_X86_OR_X64_CPU && !FPNG_NO_SSE 
@@ -453,6 +487,53 @@ namespace fpng
 
 		return (s1 % K) | ((s2 % K) << 16);
 	}
+
+	// AVX2, 32 bytes per iteration. s1 is summed with vpsadbw, s2 with the bytes weighted 32..1 by vpmaddubsw. Every block adds 32x the s1 at the 
+	// start of the block to s2, which is collected in s1Sums and multiplied by 32 at the end of a run. A run is at most 5536 bytes, so, like in 
+	// the scalar version, s2 can't overflow 32 bits before it's reduced.
+	static uint32_t adler32_avx2(const uint8_t* p, size_t len, uint32_t initial)
+	{
+		uint32_t s1 = initial & 0xFFFF, s2 = initial >> 16;
+		const uint32_t K = 65521;
+		const __m256i weights = _mm256_setr_epi8(32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17, 16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1);
+		const __m256i ones = _mm256_set1_epi16(1);
+		const __m256i zero = _mm256_setzero_si256();
+
+		while (len >= 32)
+		{
+			const size_t n = minimum<size_t>(len >> 5, 5552 / 32);
+			__m256i vs1 = _mm256_zextsi128_si256(_mm_cvtsi32_si128((int)s1));
+			__m256i vs2 = _mm256_zextsi128_si256(_mm_cvtsi32_si128((int)s2));
+			__m256i s1Sums = _mm256_setzero_si256();
+
+			for (size_t i = 0; i < n; i++)
+			{
+				const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i * 32));
+				s1Sums = _mm256_add_epi32(s1Sums, vs1);
+				vs1 = _mm256_add_epi32(vs1, _mm256_sad_epu8(bytes, zero));
+				vs2 = _mm256_add_epi32(vs2, _mm256_madd_epi16(_mm256_maddubs_epi16(bytes, weights), ones));
+			}
+			vs2 = _mm256_add_epi32(vs2, _mm256_slli_epi32(s1Sums, 5));
+
+			uint32_t sa[8], sb[8];
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(sa), vs1);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(sb), vs2);
+			uint64_t vs1Total = 0, vs2Total = 0;
+			for (uint32_t i = 0; i < 8; i++)
+			{
+				vs1Total += sa[i];
+				vs2Total += sb[i];
+			}
+			s1 = (uint32_t)(vs1Total % K);
+			s2 = (uint32_t)(vs2Total % K);
+
+			p += n * 32;
+			len -= n * 32;
+		}
+		_mm256_zeroupper();
+
+		return adler32_sse_8(p, len, s1 | (s2 << 16));
+	}
 #endif
 
 	static uint32_t fpng_adler32_scalar(const uint8_t* ptr, size_t buf_len, uint32_t adler)
@@ -473,6 +554,8 @@ namespace fpng
 	uint32_t fpng_adler32(const uint8_t* ptr, size_t buf_len, uint32_t adler)
 	{
 #if FPNG_X86_OR_X64_CPU && !FPNG_NO_SSE 
+		if (g_cpu_info.can_use_avx2())
+			return adler32_avx2(ptr, buf_len, adler);
 		if (g_cpu_info.can_use_sse41())
 			return adler32_sse_8(ptr, buf_len, adler);
 #endif
@@ -572,6 +655,19 @@ namespace fpng
 		{12,0x2FF},{12,0xAFF},{12,0x6FF},{12,0xEFF},{12,0x1FF},{12,0x9FF},{12,0x5FF},{12,0xDFF},{12,0x3FF},{12,0xBFF},{12,0x7FF},{12,0xFFF},{7,0x2B},{0,0x0},{0,0x0},{0,0x0},
 	};
 
+	// Used when an image is compressed/decompressed as a series of horizontal strips, see fpng_encode_image_to_memory_parallel(). 
+	// Each strip is a separate dynamic Deflate block. The first strip starts the zlib stream, the last strip ends it.
+	enum
+	{
+		FPNG_STRIP_FIRST = 1,
+		FPNG_STRIP_LAST = 2,
+		FPNG_STRIP_WHOLE_IMAGE = FPNG_STRIP_FIRST | FPNG_STRIP_LAST
+	};
+
+	// Minimum number of scanlines per strip, so the per-strip overhead (Huffman table, sync flush) stays negligible.
+	static const uint32_t FPNG_MIN_ROWS_PER_STRIP = 64;
+	static const uint32_t FPNG_MAX_STRIPS = 256;
+
 #define PUT_BITS(bb, ll) do { uint32_t b = bb, l = ll; assert((l) >= 0 && (l) <= 16); assert((b) < (1ULL << (l))); bit_buf |= (((uint64_t)(b)) << bit_buf_size); bit_buf_size += (l); assert(bit_buf_size <= 64); } while(0)
 #define PUT_BITS_CZ(bb, ll) do { uint32_t b = bb, l = ll; assert((l) >= 1 && (l) <= 16); assert((b) < (1ULL << (l))); bit_buf |= (((uint64_t)(b)) << bit_buf_size); bit_buf_size += (l); assert(bit_buf_size <= 64); } while(0)
 
@@ -1081,14 +1177,20 @@ do { \
 
 	static uint32_t pixel_deflate_dyn_3_rle_one_pass(
 		const uint8_t* pImg, uint32_t w, uint32_t h,
-		uint8_t* pDst, uint32_t dst_buf_size)
+		uint8_t* pDst, uint32_t dst_buf_size, uint32_t strip_flags = FPNG_STRIP_WHOLE_IMAGE)
 	{
 		const uint32_t bpl = 1 + w * 3;
 
-		if (dst_buf_size < sizeof(g_dyn_huff_3))
+		// Strips other than the first one continue the zlib stream of the previous strip, so they don't get the zlib header.
+		const uint32_t hdr_ofs = (strip_flags & FPNG_STRIP_FIRST) ? 0 : 2;
+		if (dst_buf_size < sizeof(g_dyn_huff_3) - hdr_ofs)
 			return false;
-		memcpy(pDst, g_dyn_huff_3, sizeof(g_dyn_huff_3));
-		uint32_t dst_ofs = sizeof(g_dyn_huff_3);
+		memcpy(pDst, g_dyn_huff_3 + hdr_ofs, sizeof(g_dyn_huff_3) - hdr_ofs);
+		uint32_t dst_ofs = sizeof(g_dyn_huff_3) - hdr_ofs;
+
+		// More blocks follow, so clear the block's BFINAL bit
+		if ((strip_flags & FPNG_STRIP_LAST) == 0)
+			pDst[2 - hdr_ofs] &= ~1;
 
 		uint64_t bit_buf = DYN_HUFF_3_BITBUF;
 		int bit_buf_size = DYN_HUFF_3_BITBUF_SIZE;
@@ -1096,7 +1198,8 @@ do { \
 		const uint8_t* pSrc = pImg;
 		uint32_t src_ofs = 0;
 
-		uint32_t src_adler32 = fpng_adler32(pImg, bpl * h, FPNG_ADLER32_INIT);
+		// When compressing a strip the caller combines the adler32's of all strips.
+		uint32_t src_adler32 = (strip_flags == FPNG_STRIP_WHOLE_IMAGE) ? fpng_adler32(pImg, bpl * h, FPNG_ADLER32_INIT) : 0;
 
 		for (uint32_t y = 0; y < h; y++)
 		{
@@ -1167,8 +1270,25 @@ do { \
 
 		PUT_BITS_CZ(g_dyn_huff_3_codes[256].m_code, g_dyn_huff_3_codes[256].m_code_size);
 
+		if ((strip_flags & FPNG_STRIP_LAST) == 0)
+		{
+			// End the strip byte aligned with an empty stored block (a sync flush), so the next strip can be appended as-is.
+			PUT_BITS(0, 3);
+			PUT_BITS_FORCE_FLUSH;
+			if ((dst_ofs + 4) > dst_buf_size)
+				return 0;
+			pDst[dst_ofs++] = 0;
+			pDst[dst_ofs++] = 0;
+			pDst[dst_ofs++] = 0xFF;
+			pDst[dst_ofs++] = 0xFF;
+			return dst_ofs;
+		}
+
 		PUT_BITS_FORCE_FLUSH;
 
+		if (strip_flags != FPNG_STRIP_WHOLE_IMAGE)
+			return dst_ofs;
+
 		// Write zlib adler32
 		for (uint32_t i = 0; i < 4; i++)
 		{
@@ -1366,14 +1486,20 @@ do { \
 
 	static uint32_t pixel_deflate_dyn_4_rle_one_pass(
 		const uint8_t* pImg, uint32_t w, uint32_t h,
-		uint8_t* pDst, uint32_t dst_buf_size)
+		uint8_t* pDst, uint32_t dst_buf_size, uint32_t strip_flags = FPNG_STRIP_WHOLE_IMAGE)
 	{
 		const uint32_t bpl = 1 + w * 4;
 
-		if (dst_buf_size < sizeof(g_dyn_huff_4))
+		// Strips other than the first one continue the zlib stream of the previous strip, so they don't get the zlib header.
+		const uint32_t hdr_ofs = (strip_flags & FPNG_STRIP_FIRST) ? 0 : 2;
+		if (dst_buf_size < sizeof(g_dyn_huff_4) - hdr_ofs)
 			return false;
-		memcpy(pDst, g_dyn_huff_4, sizeof(g_dyn_huff_4));
-		uint32_t dst_ofs = sizeof(g_dyn_huff_4);
+		memcpy(pDst, g_dyn_huff_4 + hdr_ofs, sizeof(g_dyn_huff_4) - hdr_ofs);
+		uint32_t dst_ofs = sizeof(g_dyn_huff_4) - hdr_ofs;
+
+		// More blocks follow, so clear the block's BFINAL bit
+		if ((strip_flags & FPNG_STRIP_LAST) == 0)
+			pDst[2 - hdr_ofs] &= ~1;
 
 		uint64_t bit_buf = DYN_HUFF_4_BITBUF;
 		int bit_buf_size = DYN_HUFF_4_BITBUF_SIZE;
@@ -1381,7 +1507,8 @@ do { \
 		const uint8_t* pSrc = pImg;
 		uint32_t src_ofs = 0;
 
-		uint32_t src_adler32 = fpng_adler32(pImg, bpl * h, FPNG_ADLER32_INIT);
+		// When compressing a strip the caller combines the adler32's of all strips.
+		uint32_t src_adler32 = (strip_flags == FPNG_STRIP_WHOLE_IMAGE) ? fpng_adler32(pImg, bpl * h, FPNG_ADLER32_INIT) : 0;
 
 		for (uint32_t y = 0; y < h; y++)
 		{
@@ -1481,8 +1608,25 @@ do_literals:
 
 		PUT_BITS_CZ(g_dyn_huff_4_codes[256].m_code, g_dyn_huff_4_codes[256].m_code_size);
 
+		if ((strip_flags & FPNG_STRIP_LAST) == 0)
+		{
+			// End the strip byte aligned with an empty stored block (a sync flush), so the next strip can be appended as-is.
+			PUT_BITS(0, 3);
+			PUT_BITS_FORCE_FLUSH;
+			if ((dst_ofs + 4) > dst_buf_size)
+				return 0;
+			pDst[dst_ofs++] = 0;
+			pDst[dst_ofs++] = 0;
+			pDst[dst_ofs++] = 0xFF;
+			pDst[dst_ofs++] = 0xFF;
+			return dst_ofs;
+		}
+
 		PUT_BITS_FORCE_FLUSH;
 
+		if (strip_flags != FPNG_STRIP_WHOLE_IMAGE)
+			return dst_ofs;
+
 		// Write zlib adler32
 		for (uint32_t i = 0; i < 4; i++)
 		{
@@ -1507,6 +1651,35 @@ do_literals:
 		}
 	}
 		
+	// Filter 2 (up) is a byte wise subtraction of the previous scanline, so the number of channels doesn't matter.
+	static void subtract_scanlines(uint32_t bpl, const uint8_t* pSrc, const uint8_t* pPrev_src, uint8_t* pDst)
+	{
+		uint32_t x = 0;
+#if FPNG_X86_OR_X64_CPU && !FPNG_NO_SSE 
+		if (g_cpu_info.can_use_avx2())
+		{
+			for (; x + 32 <= bpl; x += 32)
+			{
+				const __m256i cur = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pSrc + x));
+				const __m256i prev = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pPrev_src + x));
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(pDst + x), _mm256_sub_epi8(cur, prev));
+			}
+			_mm256_zeroupper();
+		}
+		else if (g_cpu_info.can_use_sse41())
+		{
+			for (; x + 16 <= bpl; x += 16)
+			{
+				const __m128i cur = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + x));
+				const __m128i prev = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pPrev_src + x));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + x), _mm_sub_epi8(cur, prev));
+			}
+		}
+#endif
+		for (; x < bpl; x++)
+			pDst[x] = (uint8_t)(pSrc[x] - pPrev_src[x]);
+	}
+
 	static void apply_filter(uint32_t filter, int w, int h, uint32_t num_chans, uint32_t bpl, const uint8_t* pSrc, const uint8_t* pPrev_src, uint8_t* pDst)
 	{
 		(void)h;
@@ -1527,33 +1700,9 @@ do_literals:
 			// Previous scanline
 			*pDst++ = 2;
 
-			if (num_chans == 3)
-			{
-				for (uint32_t x = 0; x < (uint32_t)w; x++)
-				{
-					pDst[0] = (uint8_t)(pSrc[0] - pPrev_src[0]);
-					pDst[1] = (uint8_t)(pSrc[1] - pPrev_src[1]);
-					pDst[2] = (uint8_t)(pSrc[2] - pPrev_src[2]);
-
-					pSrc += 3;
-					pPrev_src += 3;
-					pDst += 3;
-				}
-			}
-			else
-			{
-				for (uint32_t x = 0; x < (uint32_t)w; x++)
-				{
-					pDst[0] = (uint8_t)(pSrc[0] - pPrev_src[0]);
-					pDst[1] = (uint8_t)(pSrc[1] - pPrev_src[1]);
-					pDst[2] = (uint8_t)(pSrc[2] - pPrev_src[2]);
-					pDst[3] = (uint8_t)(pSrc[3] - pPrev_src[3]);
-
-					pSrc += 4;
-					pPrev_src += 4;
-					pDst += 4;
-				}
-			}
+			(void)w; (void)num_chans;
+			assert(bpl == (uint32_t)w * num_chans);
+			subtract_scanlines(bpl, pSrc, pPrev_src, pDst);
 			break;
 		}
 		default:
@@ -1673,8 +1822,8 @@ do_literals:
 			uint8_t pnghdr[58] = { 
 				0x89,0x50,0x4e,0x47,0x0d,0x0a,0x1a,0x0a,   // PNG sig
 				0x00,0x00,0x00,0x0d, 'I','H','D','R',  // IHDR chunk len, type
-			    0,0,(uint8_t)(w >> 8),(uint8_t)w, // width
-				0,0,(uint8_t)(h >> 8),(uint8_t)h, // height
+				(uint8_t)(w >> 24),(uint8_t)(w >> 16),(uint8_t)(w >> 8),(uint8_t)w, // width
+				(uint8_t)(h >> 24),(uint8_t)(h >> 16),(uint8_t)(h >> 8),(uint8_t)h, // height
 				8,   //bit_depth
 				s_color_type[num_chans], // color_type
 				0, // compression
@@ -1705,6 +1854,383 @@ do_literals:
 		return true;
 	}
 
+	// Returns the adler32 of the concatenation of two buffers, given the adler32 of both and the length of the second one (as zlib's adler32_combine()).
+	static uint32_t adler32_combine(uint32_t adler1, uint32_t adler2, size_t len2)
+	{
+		const uint32_t ADLER_MOD = 65521;
+
+		const uint32_t rem = (uint32_t)(len2 % ADLER_MOD);
+		uint32_t sum1 = adler1 & 0xFFFF;
+		uint32_t sum2 = (uint32_t)(((uint64_t)rem * sum1) % ADLER_MOD);
+		sum1 += (adler2 & 0xFFFF) + ADLER_MOD - 1;
+		sum2 += ((adler1 >> 16) & 0xFFFF) + ((adler2 >> 16) & 0xFFFF) + ADLER_MOD - rem;
+		if (sum1 >= ADLER_MOD) sum1 -= ADLER_MOD;
+		if (sum1 >= ADLER_MOD) sum1 -= ADLER_MOD;
+		if (sum2 >= (ADLER_MOD << 1)) sum2 -= (ADLER_MOD << 1);
+		if (sum2 >= ADLER_MOD) sum2 -= ADLER_MOD;
+		return sum1 | (sum2 << 16);
+	}
+
+	static void vector_append_be32(std::vector<uint8_t>& buf, uint32_t v)
+	{
+		const uint8_t bytes[4] = { (uint8_t)(v >> 24), (uint8_t)(v >> 16), (uint8_t)(v >> 8), (uint8_t)v };
+		vector_append(buf, bytes, 4);
+	}
+
+	// Appends a complete chunk: length, type, data and crc32.
+	static void vector_append_chunk(std::vector<uint8_t>& buf, const char* pType, const uint8_t* pData, uint32_t len)
+	{
+		vector_append_be32(buf, len);
+		const size_t type_ofs = buf.size();
+		vector_append(buf, pType, 4);
+		vector_append(buf, pData, len);
+		vector_append_be32(buf, fpng_crc32(buf.data() + type_ofs, 4 + len, FPNG_CRC32_INIT));
+	}
+
+	struct encode_strip
+	{
+		uint32_t m_first_row = 0;
+		uint32_t m_num_rows = 0;
+		uint32_t m_filtered_size = 0;
+		uint32_t m_adler32 = FPNG_ADLER32_INIT;
+		std::vector<uint8_t> m_comp;
+		uint32_t m_comp_size = 0;
+	};
+
+	// Filters and compresses one strip, pStrip_rows points at the strip's first row. The first scanline of a strip always uses filter 0, so a strip 
+	// never depends on the data of the strip above it. If allow_expansion is set, the strip is compressed even if the result is larger than the 
+	// filtered data (by at most 50%, the longest code is 12 bits), otherwise m_comp_size is 0 in that case.
+	static void encode_strip_rows(const uint8_t* pStrip_rows, uint32_t w, uint32_t num_chans, uint32_t strip_flags, encode_strip& strip, bool allow_expansion = false)
+	{
+		const uint32_t bpl = w * num_chans;
+
+		std::vector<uint8_t> temp_buf;
+		temp_buf.resize(((bpl + 1) * strip.m_num_rows + 7) & ~7);
+		for (uint32_t y = 0; y < strip.m_num_rows; ++y)
+		{
+			const uint8_t* pSrc = pStrip_rows + (size_t)y * bpl;
+			apply_filter(y ? 2 : 0, w, strip.m_num_rows, num_chans, bpl, pSrc, y ? (pSrc - bpl) : nullptr, &temp_buf[(size_t)y * (bpl + 1)]);
+		}
+
+		strip.m_filtered_size = (bpl + 1) * strip.m_num_rows;
+		strip.m_adler32 = fpng_adler32(temp_buf.data(), strip.m_filtered_size, FPNG_ADLER32_INIT);
+
+		// Same size limit as the single threaded encoder: if it doesn't compress, the whole image falls back to the single threaded path.
+		strip.m_comp.resize(allow_expansion ? (((size_t)strip.m_filtered_size * 3 / 2 + 1024 + 7) & ~7) : ((strip.m_filtered_size + 7) & ~7));
+		if (num_chans == 3)
+			strip.m_comp_size = pixel_deflate_dyn_3_rle_one_pass(temp_buf.data(), w, strip.m_num_rows, strip.m_comp.data(), (uint32_t)strip.m_comp.size(), strip_flags);
+		else
+			strip.m_comp_size = pixel_deflate_dyn_4_rle_one_pass(temp_buf.data(), w, strip.m_num_rows, strip.m_comp.data(), (uint32_t)strip.m_comp.size(), strip_flags);
+	}
+
+	bool fpng_encode_image_to_memory_parallel(const void* pImage, uint32_t w, uint32_t h, uint32_t num_chans, std::vector<uint8_t>& out_buf, uint32_t flags, uint32_t max_threads)
+	{
+		// Only the one pass compressor supports strips.
+		if (flags & (FPNG_ENCODE_SLOWER | FPNG_FORCE_UNCOMPRESSED))
+			return fpng_encode_image_to_memory(pImage, w, h, num_chans, out_buf, flags);
+
+		if (!endian_check())
+		{
+			assert(0);
+			return false;
+		}
+
+		if ((w < 1) || (h < 1) || (w * h > UINT32_MAX) || (w > FPNG_MAX_SUPPORTED_DIM) || (h > FPNG_MAX_SUPPORTED_DIM))
+		{
+			assert(0);
+			return false;
+		}
+
+		if ((num_chans != 3) && (num_chans != 4))
+		{
+			assert(0);
+			return false;
+		}
+
+		uint32_t num_strips = max_threads ? max_threads : std::thread::hardware_concurrency();
+		num_strips = minimum(minimum(num_strips, h / FPNG_MIN_ROWS_PER_STRIP), FPNG_MAX_STRIPS);
+		if (num_strips <= 1)
+			return fpng_encode_image_to_memory(pImage, w, h, num_chans, out_buf, flags);
+
+		std::vector<encode_strip> strips(num_strips);
+		const uint32_t rows_per_strip = h / num_strips;
+		const uint32_t extra_rows = h % num_strips;
+		uint32_t first_row = 0;
+		for (uint32_t i = 0; i < num_strips; i++)
+		{
+			strips[i].m_first_row = first_row;
+			strips[i].m_num_rows = rows_per_strip + ((i < extra_rows) ? 1 : 0);
+			first_row += strips[i].m_num_rows;
+		}
+		assert(first_row == h);
+
+		// Strip 0 is compressed on the calling thread.
+		std::vector<std::thread> threads;
+		threads.reserve(num_strips - 1);
+		for (uint32_t i = 1; i < num_strips; i++)
+		{
+			const uint32_t strip_flags = (i == (num_strips - 1)) ? FPNG_STRIP_LAST : 0;
+			threads.emplace_back(encode_strip_rows, (const uint8_t*)pImage + (size_t)strips[i].m_first_row * w * num_chans, w, num_chans, strip_flags, 
+								 std::ref(strips[i]), false);
+		}
+		encode_strip_rows((const uint8_t*)pImage, w, num_chans, FPNG_STRIP_FIRST, strips[0]);
+		for (std::thread& t : threads)
+			t.join();
+
+		uint64_t total_comp_size = 0;
+		uint32_t adler = strips[0].m_adler32;
+		for (uint32_t i = 0; i < num_strips; i++)
+		{
+			if (!strips[i].m_comp_size)
+			{
+				// A strip didn't compress, let the single threaded encoder handle it (it falls back to uncompressed blocks).
+				return fpng_encode_image_to_memory(pImage, w, h, num_chans, out_buf, flags);
+			}
+			total_comp_size += strips[i].m_comp_size;
+			if (i)
+				adler = adler32_combine(adler, strips[i].m_adler32, strips[i].m_filtered_size);
+		}
+
+		const uint64_t idat_len64 = total_comp_size + 4;
+		if (idat_len64 > (UINT32_MAX - 1024 - num_strips * 8))
+			return fpng_encode_image_to_memory(pImage, w, h, num_chans, out_buf, flags);
+		const uint32_t idat_len = (uint32_t)idat_len64;
+
+		out_buf.resize(0);
+		out_buf.reserve(128 + num_strips * 8 + idat_len);
+
+		static const uint8_t s_png_sig[8] = { 0x89,0x50,0x4e,0x47,0x0d,0x0a,0x1a,0x0a };
+		vector_append(out_buf, s_png_sig, sizeof(s_png_sig));
+
+		static const uint8_t s_color_type[] = { 0x00, 0x00, 0x04, 0x02, 0x06 };
+		const uint8_t ihdr[13] = {
+			(uint8_t)(w >> 24),(uint8_t)(w >> 16),(uint8_t)(w >> 8),(uint8_t)w, // width
+			(uint8_t)(h >> 24),(uint8_t)(h >> 16),(uint8_t)(h >> 8),(uint8_t)h, // height
+			8,   //bit_depth
+			s_color_type[num_chans], // color_type
+			0, // compression
+			0, // filter
+			0  // interlace
+		};
+		vector_append_chunk(out_buf, "IHDR", ihdr, sizeof(ihdr));
+
+		// our custom private, ancillary, do not copy, fdEC chunk
+		const uint8_t fdec[5] = { 82, 36, 147, 227, FPNG_FDEC_VERSION };
+		vector_append_chunk(out_buf, "fdEC", fdec, sizeof(fdec));
+
+		// our custom private, ancillary, do not copy, fdSP chunk: the strip table. Per strip the first scanline and the offset of the strip's 
+		// Deflate block in the IDAT data. Decoders which don't know it decode the IDAT as one regular zlib stream.
+		std::vector<uint8_t> strip_table;
+		strip_table.reserve(4 + num_strips * 8);
+		vector_append_be32(strip_table, num_strips);
+		uint32_t zlib_ofs = 0;
+		for (uint32_t i = 0; i < num_strips; i++)
+		{
+			vector_append_be32(strip_table, strips[i].m_first_row);
+			vector_append_be32(strip_table, zlib_ofs);
+			zlib_ofs += strips[i].m_comp_size;
+		}
+		vector_append_chunk(out_buf, "fdSP", strip_table.data(), (uint32_t)strip_table.size());
+
+		vector_append_be32(out_buf, idat_len);
+		const size_t idat_type_ofs = out_buf.size();
+		vector_append(out_buf, "IDAT", 4);
+		for (uint32_t i = 0; i < num_strips; i++)
+		{
+			vector_append(out_buf, strips[i].m_comp.data(), strips[i].m_comp_size);
+			strips[i].m_comp = std::vector<uint8_t>();
+		}
+		vector_append_be32(out_buf, adler);
+		vector_append_be32(out_buf, fpng_crc32(out_buf.data() + idat_type_ofs, 4 + idat_len, FPNG_CRC32_INIT));
+
+		vector_append(out_buf, "\0\0\0\0\x49\x45\x4e\x44\xae\x42\x60\x82", 12); // IEND chunk
+
+		return true;
+	}
+
+	fpng_stream_encoder::fpng_stream_encoder() :
+		m_w(0), m_h(0), m_num_chans(0), m_bpl(0), m_band_rows(0), m_rows_added(0), m_rows_in_band(0), m_adler32(FPNG_ADLER32_INIT), m_zlib_ofs(0),
+		m_pWrite_func(nullptr), m_pUser(nullptr), m_bytes_written(0), m_failed(false), m_complete(false)
+	{
+	}
+
+	fpng_stream_encoder::~fpng_stream_encoder()
+	{
+	}
+
+	bool fpng_stream_encoder::begin(uint32_t w, uint32_t h, uint32_t num_chans, fpng_write_func pWrite_func, void* pUser)
+	{
+		m_rows_added = 0;
+		m_rows_in_band = 0;
+		m_adler32 = FPNG_ADLER32_INIT;
+		m_zlib_ofs = 0;
+		m_bytes_written = 0;
+		m_failed = true;
+		m_complete = false;
+		m_band.clear();
+		m_strip_table.clear();
+
+		if ((!endian_check()) || (!pWrite_func))
+		{
+			assert(0);
+			return false;
+		}
+
+		if ((w < 1) || (h < 1) || ((uint64_t)w * h > UINT32_MAX) || (w > FPNG_MAX_SUPPORTED_DIM) || (h > FPNG_MAX_SUPPORTED_DIM) || ((num_chans != 3) && (num_chans != 4)))
+		{
+			assert(0);
+			return false;
+		}
+
+		m_w = w;
+		m_h = h;
+		m_num_chans = num_chans;
+		m_bpl = w * num_chans;
+		// Bands are at least as large as the parallel encoder's strips, and there can't be more of them than fit in the strip table.
+		m_band_rows = maximum(FPNG_MIN_ROWS_PER_STRIP, (h + FPNG_MAX_STRIPS - 1) / FPNG_MAX_STRIPS);
+		m_pWrite_func = pWrite_func;
+		m_pUser = pUser;
+		m_failed = false;
+
+		std::vector<uint8_t> header;
+		static const uint8_t s_png_sig[8] = { 0x89,0x50,0x4e,0x47,0x0d,0x0a,0x1a,0x0a };
+		vector_append(header, s_png_sig, sizeof(s_png_sig));
+
+		static const uint8_t s_color_type[] = { 0x00, 0x00, 0x04, 0x02, 0x06 };
+		const uint8_t ihdr[13] = {
+			(uint8_t)(w >> 24),(uint8_t)(w >> 16),(uint8_t)(w >> 8),(uint8_t)w, // width
+			(uint8_t)(h >> 24),(uint8_t)(h >> 16),(uint8_t)(h >> 8),(uint8_t)h, // height
+			8,   //bit_depth
+			s_color_type[num_chans], // color_type
+			0, // compression
+			0, // filter
+			0  // interlace
+		};
+		vector_append_chunk(header, "IHDR", ihdr, sizeof(ihdr));
+
+		const uint8_t fdec[5] = { 82, 36, 147, 227, FPNG_FDEC_VERSION };
+		vector_append_chunk(header, "fdEC", fdec, sizeof(fdec));
+
+		return write(header.data(), header.size());
+	}
+
+	bool fpng_stream_encoder::add_rows(const void* pRows, uint32_t num_rows)
+	{
+		if ((m_failed) || (!m_pWrite_func) || (!pRows) || (num_rows > (m_h - m_rows_added)))
+		{
+			m_failed = true;
+			return false;
+		}
+
+		const uint8_t* pSrc = static_cast<const uint8_t*>(pRows);
+		while (num_rows)
+		{
+			const uint32_t band_first_row = m_rows_added - m_rows_in_band;
+			const uint32_t band_rows = minimum(m_band_rows, m_h - band_first_row);
+
+			if ((!m_rows_in_band) && (num_rows >= band_rows))
+			{
+				// The whole band is in the caller's rows, so it's compressed from there.
+				m_rows_added += band_rows;
+				if (!encode_band(pSrc, band_first_row, band_rows))
+					return false;
+				pSrc += (size_t)band_rows * m_bpl;
+				num_rows -= band_rows;
+				continue;
+			}
+
+			if (m_band.empty())
+				m_band.resize((size_t)m_band_rows * m_bpl);
+
+			const uint32_t n = minimum(band_rows - m_rows_in_band, num_rows);
+			memcpy(m_band.data() + (size_t)m_rows_in_band * m_bpl, pSrc, (size_t)n * m_bpl);
+			m_rows_in_band += n;
+			m_rows_added += n;
+			pSrc += (size_t)n * m_bpl;
+			num_rows -= n;
+
+			if (m_rows_in_band == band_rows)
+			{
+				m_rows_in_band = 0;
+				if (!encode_band(m_band.data(), band_first_row, band_rows))
+					return false;
+			}
+		}
+
+		return true;
+	}
+
+	bool fpng_stream_encoder::encode_band(const uint8_t* pBand_rows, uint32_t first_row, uint32_t num_rows)
+	{
+		const bool is_first = (first_row == 0);
+		const bool is_last = ((first_row + num_rows) == m_h);
+		const uint32_t strip_flags = (is_first ? FPNG_STRIP_FIRST : 0) | (is_last ? FPNG_STRIP_LAST : 0);
+
+		encode_strip strip;
+		strip.m_first_row = first_row;
+		strip.m_num_rows = num_rows;
+		encode_strip_rows(pBand_rows, m_w, m_num_chans, strip_flags, strip, true);
+		if ((!strip.m_comp_size) || ((m_zlib_ofs + strip.m_comp_size + 4) > UINT32_MAX))
+		{
+			m_failed = true;
+			return false;
+		}
+
+		m_adler32 = is_first ? strip.m_adler32 : adler32_combine(m_adler32, strip.m_adler32, strip.m_filtered_size);
+		vector_append_be32(m_strip_table, first_row);
+		vector_append_be32(m_strip_table, (uint32_t)m_zlib_ofs);
+		m_zlib_ofs += strip.m_comp_size;
+
+		// Every band is its own IDAT chunk, the chunks together form the zlib stream. If the image is a single band, the compressor has already 
+		// appended the adler32, otherwise it's appended to the last band.
+		strip.m_comp.resize(strip.m_comp_size);
+		if ((is_last) && (!is_first))
+			vector_append_be32(strip.m_comp, m_adler32);
+		if (!write_chunk("IDAT", strip.m_comp.data(), (uint32_t)strip.m_comp.size()))
+			return false;
+
+		if (!is_last)
+			return true;
+
+		std::vector<uint8_t> trailer;
+		const uint32_t num_strips = (uint32_t)(m_strip_table.size() / 8);
+		if (num_strips > 1)
+		{
+			// The strip table goes after the IDAT chunks, as it's only known once the last band has been compressed. The decoder looks at all chunks.
+			std::vector<uint8_t> strip_table;
+			vector_append_be32(strip_table, num_strips);
+			vector_append(strip_table, m_strip_table.data(), m_strip_table.size());
+			vector_append_chunk(trailer, "fdSP", strip_table.data(), (uint32_t)strip_table.size());
+		}
+		vector_append(trailer, "\0\0\0\0\x49\x45\x4e\x44\xae\x42\x60\x82", 12); // IEND chunk
+		if (!write(trailer.data(), trailer.size()))
+			return false;
+
+		m_complete = true;
+		m_band = std::vector<uint8_t>();
+		m_strip_table = std::vector<uint8_t>();
+		return true;
+	}
+
+	bool fpng_stream_encoder::write_chunk(const char* pType, const uint8_t* pData, uint32_t len)
+	{
+		uint8_t prefix[8] = { (uint8_t)(len >> 24), (uint8_t)(len >> 16), (uint8_t)(len >> 8), (uint8_t)len, (uint8_t)pType[0], (uint8_t)pType[1], (uint8_t)pType[2], (uint8_t)pType[3] };
+		const uint32_t crc = fpng_crc32(pData, len, fpng_crc32(prefix + 4, 4, FPNG_CRC32_INIT));
+		const uint8_t suffix[4] = { (uint8_t)(crc >> 24), (uint8_t)(crc >> 16), (uint8_t)(crc >> 8), (uint8_t)crc };
+		return write(prefix, sizeof(prefix)) && write(pData, len) && write(suffix, sizeof(suffix));
+	}
+
+	bool fpng_stream_encoder::write(const void* pData, size_t len)
+	{
+		if ((m_failed) || (!m_pWrite_func(m_pUser, pData, len)))
+		{
+			m_failed = true;
+			return false;
+		}
+		m_bytes_written += len;
+		return true;
+	}
+
 #ifndef FPNG_NO_STDIO
 	bool fpng_encode_image_to_file(const char* pFilename, const void* pImage, uint32_t w, uint32_t h, uint32_t num_chans, uint32_t flags)
 	{
@@ -2102,10 +2628,29 @@ do_literals:
 		return (dst_ofs == dst_len);
 	}
 	
+	// A strip which isn't the last one ends right after its EOB symbol with an empty stored block: BFINAL=0, BTYPE=0, then byte aligned LEN=0 
+	// and NLEN=0xFFFF. bit_ofs is the offset in bits of the stored block header, which has to end exactly at strip_len.
+	static bool fpng_check_strip_end(const uint8_t* pSrc, uint32_t src_len, uint32_t strip_len, uint32_t bit_ofs)
+	{
+		const uint32_t byte_ofs = bit_ofs >> 3;
+		if ((byte_ofs + 2) > src_len)
+			return false;
+
+		const uint32_t block_hdr = ((pSrc[byte_ofs] | (pSrc[byte_ofs + 1] << 8)) >> (bit_ofs & 7)) & 7;
+		if (block_hdr != 0)
+			return false;
+
+		const uint32_t stored_ofs = (bit_ofs + 3 + 7) >> 3;
+		if (((stored_ofs + 4) != strip_len) || (strip_len > src_len))
+			return false;
+
+		return (pSrc[stored_ofs] == 0) && (pSrc[stored_ofs + 1] == 0) && (pSrc[stored_ofs + 2] == 0xFF) && (pSrc[stored_ofs + 3] == 0xFF);
+	}
+
 	template<uint32_t dst_comps>
 	static bool fpng_pixel_zlib_decompress_3(
 		const uint8_t* pSrc, uint32_t src_len, uint32_t zlib_len,
-		uint8_t* pDst, uint32_t w, uint32_t h)
+		uint8_t* pDst, uint32_t w, uint32_t h, uint32_t strip_flags = FPNG_STRIP_WHOLE_IMAGE)
 	{
 		assert(src_len >= (zlib_len + 4));
 
@@ -2115,14 +2660,26 @@ do_literals:
 		if (zlib_len < 7)
 			return false;
 
-		// check zlib header
-		if ((pSrc[0] != 0x78) || (pSrc[1] != 0x01))
-			return false;
+		uint32_t src_ofs = 0;
 
-		uint32_t src_ofs = 2;
+		// Only the first strip starts with the zlib header
+		if (strip_flags & FPNG_STRIP_FIRST)
+		{
+			// check zlib header
+			if ((pSrc[0] != 0x78) || (pSrc[1] != 0x01))
+				return false;
+
+			src_ofs = 2;
+		}
 		
 		if ((pSrc[src_ofs] & 6) == 0)
+		{
+			// Images compressed in strips never use raw blocks
+			if (strip_flags != FPNG_STRIP_WHOLE_IMAGE)
+				return false;
+
 			return fpng_pixel_zlib_raw_decompress(pSrc, src_len, zlib_len, pDst, w, h, 3, dst_comps);
+		}
 		
 		if ((src_ofs + 4) > src_len)
 			return false;
@@ -2135,8 +2692,8 @@ do_literals:
 		GET_BITS(bfinal, 1);
 		GET_BITS(btype, 2);
 
-		// Must be the final block or it's not valid, and type=1 (dynamic)
-		if ((bfinal != 1) || (btype != 2))
+		// Must be the final block (unless more strips follow) or it's not valid, and type=1 (dynamic)
+		if ((bfinal != ((strip_flags & FPNG_STRIP_LAST) ? 1U : 0U)) || (btype != 2))
 			return false;
 		
 		uint32_t lit_table[FPNG_DECODER_TABLE_SIZE];
@@ -2465,6 +3022,9 @@ do_literals:
 		bit_buf_size -= lit0_len;
 		bit_buf >>= lit0_len;
 
+		if ((strip_flags & FPNG_STRIP_LAST) == 0)
+			return fpng_check_strip_end(pSrc, src_len, zlib_len, src_ofs * 8 - bit_buf_size);
+
 		uint32_t align_bits = bit_buf_size & 7;
 		bit_buf_size -= align_bits;
 		bit_buf >>= align_bits;
@@ -2483,7 +3043,7 @@ do_literals:
 	template<uint32_t dst_comps>
 	static bool fpng_pixel_zlib_decompress_4(
 		const uint8_t* pSrc, uint32_t src_len, uint32_t zlib_len,
-		uint8_t* pDst, uint32_t w, uint32_t h)
+		uint8_t* pDst, uint32_t w, uint32_t h, uint32_t strip_flags = FPNG_STRIP_WHOLE_IMAGE)
 	{
 		assert(src_len >= (zlib_len + 4));
 
@@ -2493,14 +3053,26 @@ do_literals:
 		if (zlib_len < 7)
 			return false;
 
-		// check zlib header
-		if ((pSrc[0] != 0x78) || (pSrc[1] != 0x01))
-			return false;
+		uint32_t src_ofs = 0;
 
-		uint32_t src_ofs = 2;
+		// Only the first strip starts with the zlib header
+		if (strip_flags & FPNG_STRIP_FIRST)
+		{
+			// check zlib header
+			if ((pSrc[0] != 0x78) || (pSrc[1] != 0x01))
+				return false;
+
+			src_ofs = 2;
+		}
 
 		if ((pSrc[src_ofs] & 6) == 0)
+		{
+			// Images compressed in strips never use raw blocks
+			if (strip_flags != FPNG_STRIP_WHOLE_IMAGE)
+				return false;
+
 			return fpng_pixel_zlib_raw_decompress(pSrc, src_len, zlib_len, pDst, w, h, 4, dst_comps);
+		}
 
 		if ((src_ofs + 4) > src_len)
 			return false;
@@ -2513,8 +3085,8 @@ do_literals:
 		GET_BITS(bfinal, 1);
 		GET_BITS(btype, 2);
 
-		// Must be the final block or it's not valid, and type=1 (dynamic)
-		if ((bfinal != 1) || (btype != 2))
+		// Must be the final block (unless more strips follow) or it's not valid, and type=1 (dynamic)
+		if ((bfinal != ((strip_flags & FPNG_STRIP_LAST) ? 1U : 0U)) || (btype != 2))
 			return false;
 
 		uint32_t lit_table[FPNG_DECODER_TABLE_SIZE];
@@ -2781,6 +3353,9 @@ do_literals:
 		bit_buf_size -= lit0_len;
 		bit_buf >>= lit0_len;
 
+		if ((strip_flags & FPNG_STRIP_LAST) == 0)
+			return fpng_check_strip_end(pSrc, src_len, zlib_len, src_ofs * 8 - bit_buf_size);
+
 		uint32_t align_bits = bit_buf_size & 7;
 		bit_buf_size -= align_bits;
 		bit_buf >>= align_bits;
@@ -2823,7 +3398,9 @@ do_literals:
 	};
 #pragma pack(pop)
 
-	static int fpng_get_info_internal(const void* pImage, uint32_t image_size, uint32_t& width, uint32_t& height, uint32_t& channels_in_file, uint32_t &idat_ofs, uint32_t &idat_len)
+	// idat_len is the length of all IDAT chunks together, num_idats the number of IDAT chunks.
+	static int fpng_get_info_internal(const void* pImage, uint32_t image_size, uint32_t& width, uint32_t& height, uint32_t& channels_in_file, uint32_t &idat_ofs, uint32_t &idat_len, 
+									  uint32_t& num_idats, uint32_t& strip_table_ofs, uint32_t& num_strips)
 	{
 		static const uint8_t s_png_sig[8] = { 137, 80, 78, 71, 13, 10, 26, 10 };
 
@@ -2836,7 +3413,8 @@ do_literals:
 		width = 0;
 		height = 0;
 		channels_in_file = 0;
-		idat_ofs = 0, idat_len = 0;
+		idat_ofs = 0, idat_len = 0, num_idats = 0;
+		strip_table_ofs = 0, num_strips = 0;
 				
 		// Ensure the file has at least a minimum possible size
 		if (image_size < (sizeof(s_png_sig) + sizeof(png_ihdr) + sizeof(png_chunk_prefix) + 1 + sizeof(uint32_t) + sizeof(png_iend)))
@@ -2877,8 +3455,9 @@ do_literals:
 		if (!channels_in_file)
 			return FPNG_DECODE_NOT_FPNG;
 
-		// Scan all the chunks. Look for one IDAT, IEND, and our custom fdEC chunk that indicates the file was compressed by us. Skip any ancillary chunks.
+		// Scan all the chunks. Look for the IDAT(s), IEND, and our custom fdEC chunk that indicates the file was compressed by us. Skip any ancillary chunks.
 		bool found_fdec_chunk = false;
+		bool prev_chunk_was_idat = false;
 		
 		for (; ; )
 		{
@@ -2924,16 +3503,29 @@ do_literals:
 				break;
 			else if (is_idat)
 			{
-				// If there were multiple IDAT's, or we didn't find the fdEC chunk, then it's not FPNG.
-				if ((idat_ofs) || (!found_fdec_chunk))
-					return FPNG_DECODE_NOT_FPNG;
+				if (idat_ofs)
+				{
+					// fpng_stream_encoder writes an IDAT per band. They have to follow each other, otherwise it's not FPNG.
+					if ((!prev_chunk_was_idat) || (chunk_len > (UINT32_MAX - idat_len)))
+						return FPNG_DECODE_NOT_FPNG;
 
-				idat_ofs = (uint32_t)src_ofs;
-				idat_len = chunk_len;
+					idat_len += chunk_len;
+					num_idats++;
+				}
+				else
+				{
+					// If we didn't find the fdEC chunk, then it's not FPNG.
+					if (!found_fdec_chunk)
+						return FPNG_DECODE_NOT_FPNG;
 
-				// Sanity check the IDAT chunk length
-				if (idat_len < 7)
-					return FPNG_DECODE_FAILED_INVALID_IDAT;
+					idat_ofs = (uint32_t)src_ofs;
+					idat_len = chunk_len;
+					num_idats = 1;
+
+					// Sanity check the IDAT chunk length
+					if (idat_len < 7)
+						return FPNG_DECODE_FAILED_INVALID_IDAT;
+				}
 			}
 			else if (strcmp(chunk_type, "fdEC") == 0)
 			{
@@ -2954,6 +3546,19 @@ do_literals:
 
 				found_fdec_chunk = true;
 			}
+			else if (strcmp(chunk_type, "fdSP") == 0)
+			{
+				// Strip table written by fpng_encode_image_to_memory_parallel(): number of strips, then per strip its first scanline and zlib offset.
+				if ((strip_table_ofs) || (chunk_len < 4))
+					return FPNG_DECODE_NOT_FPNG;
+
+				const uint32_t strips_in_chunk = READ_BE32(pChunk_data);
+				if ((!strips_in_chunk) || (strips_in_chunk > FPNG_MAX_STRIPS) || (chunk_len != (4 + strips_in_chunk * 8)))
+					return FPNG_DECODE_NOT_FPNG;
+
+				strip_table_ofs = (uint32_t)((pChunk_data + 4) - static_cast<const uint8_t*>(pImage));
+				num_strips = strips_in_chunk;
+			}
 			else
 			{
 				// Bail if it's a critical chunk - can't be FPNG
@@ -2963,6 +3568,7 @@ do_literals:
 				// ancillary chunk - skip it
 			}
 
+			prev_chunk_was_idat = is_idat;
 			pImage_u8 += sizeof(png_chunk_prefix) + chunk_len + sizeof(uint32_t);
 		}
 
@@ -2972,13 +3578,80 @@ do_literals:
 		return FPNG_DECODE_SUCCESS;
 	}
 
+	static bool fpng_pixel_zlib_decompress(const uint8_t* pSrc, uint32_t src_len, uint32_t zlib_len, uint8_t* pDst, uint32_t w, uint32_t h, 
+										   uint32_t src_chans, uint32_t dst_chans, uint32_t strip_flags)
+	{
+		if (dst_chans == 3)
+		{
+			if (src_chans == 3)
+				return fpng_pixel_zlib_decompress_3<3>(pSrc, src_len, zlib_len, pDst, w, h, strip_flags);
+			return fpng_pixel_zlib_decompress_4<3>(pSrc, src_len, zlib_len, pDst, w, h, strip_flags);
+		}
+		if (src_chans == 3)
+			return fpng_pixel_zlib_decompress_3<4>(pSrc, src_len, zlib_len, pDst, w, h, strip_flags);
+		return fpng_pixel_zlib_decompress_4<4>(pSrc, src_len, zlib_len, pDst, w, h, strip_flags);
+	}
+
+	// Decompresses an image written by fpng_encode_image_to_memory_parallel() or fpng_stream_encoder, using the strip table in the fdSP chunk.
+	// The strips are independent: every strip starts with a filter 0 scanline and writes its own rows, so they're decompressed in parallel on 
+	// up to max_threads threads (0: one per hardware thread), each thread taking the next strip which hasn't been taken yet.
+	static bool fpng_pixel_zlib_decompress_strips(const uint8_t* pStrip_table, uint32_t num_strips, const uint8_t* pSrc, uint32_t src_len, uint32_t zlib_len, 
+												  uint8_t* pDst, uint32_t w, uint32_t h, uint32_t src_chans, uint32_t dst_chans, uint32_t max_threads)
+	{
+		const size_t dst_bpl = (size_t)w * dst_chans;
+
+		// Validate the whole table first, so the threads only have to decompress.
+		for (uint32_t i = 0; i < num_strips; i++)
+		{
+			const uint32_t first_row = READ_BE32(pStrip_table + i * 8);
+			const uint32_t strip_ofs = READ_BE32(pStrip_table + i * 8 + 4);
+			const bool is_last = (i == (num_strips - 1));
+			const uint32_t end_row = is_last ? h : READ_BE32(pStrip_table + (i + 1) * 8);
+			const uint32_t end_ofs = is_last ? zlib_len : READ_BE32(pStrip_table + (i + 1) * 8 + 4);
+
+			if ((!i) && ((first_row != 0) || (strip_ofs != 0)))
+				return false;
+			if ((end_row <= first_row) || (end_row > h) || (end_ofs <= strip_ofs) || (end_ofs > zlib_len))
+				return false;
+		}
+
+		std::atomic<uint32_t> next_strip(0);
+		std::atomic<bool> failed(false);
+		auto decompress_strips = [&]()
+		{
+			for (uint32_t i = next_strip++; (i < num_strips) && (!failed); i = next_strip++)
+			{
+				const uint32_t first_row = READ_BE32(pStrip_table + i * 8);
+				const uint32_t strip_ofs = READ_BE32(pStrip_table + i * 8 + 4);
+				const bool is_last = (i == (num_strips - 1));
+				const uint32_t end_row = is_last ? h : READ_BE32(pStrip_table + (i + 1) * 8);
+				const uint32_t end_ofs = is_last ? zlib_len : READ_BE32(pStrip_table + (i + 1) * 8 + 4);
+
+				const uint32_t strip_flags = ((!i) ? FPNG_STRIP_FIRST : 0) | (is_last ? FPNG_STRIP_LAST : 0);
+				if (!fpng_pixel_zlib_decompress(pSrc + strip_ofs, src_len - strip_ofs, end_ofs - strip_ofs, pDst + first_row * dst_bpl, w, end_row - first_row, src_chans, dst_chans, strip_flags))
+					failed = true;
+			}
+		};
+
+		const uint32_t num_threads = minimum<uint32_t>(num_strips, maximum<uint32_t>(max_threads ? max_threads : std::thread::hardware_concurrency(), 1));
+		std::vector<std::thread> threads;
+		threads.reserve(num_threads - 1);
+		for (uint32_t i = 1; i < num_threads; i++)
+			threads.emplace_back(decompress_strips);
+		decompress_strips();
+		for (std::thread& thread : threads)
+			thread.join();
+
+		return !failed;
+	}
+
 	int fpng_get_info(const void* pImage, uint32_t image_size, uint32_t& width, uint32_t& height, uint32_t& channels_in_file)
 	{
-		uint32_t idat_ofs = 0, idat_len = 0;
-		return fpng_get_info_internal(pImage, image_size, width, height, channels_in_file, idat_ofs, idat_len);
+		uint32_t idat_ofs = 0, idat_len = 0, num_idats = 0, strip_table_ofs = 0, num_strips = 0;
+		return fpng_get_info_internal(pImage, image_size, width, height, channels_in_file, idat_ofs, idat_len, num_idats, strip_table_ofs, num_strips);
 	}
 
-	int fpng_decode_memory(const void *pImage, uint32_t image_size, std::vector<uint8_t> &out, uint32_t& width, uint32_t& height, uint32_t &channels_in_file, uint32_t desired_channels)
+	int fpng_decode_memory(const void *pImage, uint32_t image_size, std::vector<uint8_t> &out, uint32_t& width, uint32_t& height, uint32_t &channels_in_file, uint32_t desired_channels, uint32_t max_threads)
 	{
 		out.resize(0);
 		width = 0;
@@ -2991,8 +3664,8 @@ do_literals:
 			return FPNG_DECODE_INVALID_ARG;
 		}
 
-		uint32_t idat_ofs = 0, idat_len = 0;
-		int status = fpng_get_info_internal(pImage, image_size, width, height, channels_in_file, idat_ofs, idat_len);
+		uint32_t idat_ofs = 0, idat_len = 0, num_idats = 0, strip_table_ofs = 0, num_strips = 0;
+		int status = fpng_get_info_internal(pImage, image_size, width, height, channels_in_file, idat_ofs, idat_len, num_idats, strip_table_ofs, num_strips);
 		if (status)
 			return status;
 				
@@ -3007,23 +3680,31 @@ do_literals:
 		out.resize(mem_needed);
 		
 		const uint8_t* pIDAT_data = static_cast<const uint8_t*>(pImage) + idat_ofs + sizeof(uint32_t) * 2;
-		const uint32_t src_len = image_size - (idat_ofs + sizeof(uint32_t) * 2);
+		uint32_t src_len = image_size - (idat_ofs + sizeof(uint32_t) * 2);
 
-		bool decomp_status;
-		if (desired_channels == 3)
+		std::vector<uint8_t> joined_idat;
+		if (num_idats > 1)
 		{
-			if (channels_in_file == 3)
-				decomp_status = fpng_pixel_zlib_decompress_3<3>(pIDAT_data, src_len, idat_len, out.data(), width, height);
-			else
-				decomp_status = fpng_pixel_zlib_decompress_4<3>(pIDAT_data, src_len, idat_len, out.data(), width, height);
+			// Written by fpng_stream_encoder: join the IDAT chunks' data into one zlib stream.
+			joined_idat.reserve((size_t)idat_len + 16);
+			const uint8_t* pChunk = static_cast<const uint8_t*>(pImage) + idat_ofs;
+			for (uint32_t i = 0; i < num_idats; i++)
+			{
+				const uint32_t chunk_len = READ_BE32(pChunk);
+				vector_append(joined_idat, pChunk + sizeof(uint32_t) * 2, chunk_len);
+				pChunk += sizeof(uint32_t) * 3 + chunk_len;
+			}
+			// The decompressors read ahead, into the IDAT's crc32 and the IEND chunk for a single IDAT.
+			joined_idat.resize(joined_idat.size() + 16);
+			pIDAT_data = joined_idat.data();
+			src_len = (uint32_t)joined_idat.size();
 		}
+
+		bool decomp_status;
+		if (num_strips)
+			decomp_status = fpng_pixel_zlib_decompress_strips(static_cast<const uint8_t*>(pImage) + strip_table_ofs, num_strips, pIDAT_data, src_len, idat_len, out.data(), width, height, channels_in_file, desired_channels, max_threads);
 		else
-		{
-			if (channels_in_file == 3)
-				decomp_status = fpng_pixel_zlib_decompress_3<4>(pIDAT_data, src_len, idat_len, out.data(), width, height);
-			else
-				decomp_status = fpng_pixel_zlib_decompress_4<4>(pIDAT_data, src_len, idat_len, out.data(), width, height);
-		}
+			decomp_status = fpng_pixel_zlib_decompress(pIDAT_data, src_len, idat_len, out.data(), width, height, channels_in_file, desired_channels, FPNG_STRIP_WHOLE_IMAGE);
 		if (!decomp_status)
 		{
 			// Something went wrong. Either the file data was corrupted, or it doesn't conform to one of our zlib/Deflate constraints.
@@ -3035,7 +3716,7 @@ do_literals:
 	}
 
 #ifndef FPNG_NO_STDIO
-	int fpng_decode_file(const char* pFilename, std::vector<uint8_t>& out, uint32_t& width, uint32_t& height, uint32_t& channels_in_file, uint32_t desired_channels)
+	int fpng_decode_file(const char* pFilename, std::vector<uint8_t>& out, uint32_t& width, uint32_t& height, uint32_t& channels_in_file, uint32_t desired_channels, uint32_t max_threads)
 	{
 		FILE* pFile = nullptr;
 
@@ -3081,7 +3762,7 @@ do_literals:
 
 		fclose(pFile);
 
-		return fpng_decode_memory(buf.data(), (uint32_t)buf.size(), out, width, height, channels_in_file, desired_channels);
+		return fpng_decode_memory(buf.data(), (uint32_t)buf.size(), out, width, height, channels_in_file, desired_channels, max_threads);
 	}
 #endif
 
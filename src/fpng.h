@@ -11,12 +11,27 @@ namespace fpng
 	// Otherwise you'll only get scalar fallbacks.
 	void fpng_init();
 
+	// The cpu features fpng can use, detected by the caller.
+	struct fpng_cpu_features
+	{
+		bool m_sse41;		// SSE 4.1 and everything before it
+		bool m_pclmul;
+		bool m_avx2;		// AVX2, and the OS saves the ymm registers
+	};
+
+	// Initializes fpng with cpu features detected by the caller instead of detecting them itself. The features are process wide: only call it again
+	// when no image is being encoded or decoded on any thread, e.g. in a test.
+	void fpng_init(const fpng_cpu_features& features);
+
 	// ---- Useful Utilities
 
 	// Returns true if the CPU supports SSE 4.1, and SSE support wasn't disabled by setting FPNG_NO_SSE=1.
 	// fpng_init() must have been called first, or it'll assert and return false.
 	bool fpng_cpu_supports_sse41();
 
+	// Returns true if the adler32 and filter loops use AVX2. fpng_init() must have been called first.
+	bool fpng_cpu_supports_avx2();
+
 	// Fast CRC-32 SSE4.1+pclmul or a scalar fallback (slice by 4)
 	const uint32_t FPNG_CRC32_INIT = 0;
 	uint32_t fpng_crc32(const void* pData, size_t size, uint32_t prev_crc32 = FPNG_CRC32_INIT);
@@ -42,6 +57,59 @@ namespace fpng
 	// num_chans must be 3 or 4. 
 	bool fpng_encode_image_to_memory(const void* pImage, uint32_t w, uint32_t h, uint32_t num_chans, std::vector<uint8_t>& out_buf, uint32_t flags = 0);
 
+	// Multi-threaded variant of fpng_encode_image_to_memory(). The image is split into horizontal strips which are filtered and compressed in parallel 
+	// on up to max_threads threads (0: one per hardware thread) as separate Deflate blocks, which are then joined into a single zlib stream/IDAT chunk.
+	// The first scanline of every strip uses filter 0 and the strip offsets are stored in a private fdSP chunk, so fpng_decode_memory() can decode 
+	// the strips independently. Standard PNG decoders read the result as a regular PNG. Falls back to fpng_encode_image_to_memory() for small 
+	// images, when a strip doesn't compress, or when FPNG_ENCODE_SLOWER or FPNG_FORCE_UNCOMPRESSED is specified.
+	bool fpng_encode_image_to_memory_parallel(const void* pImage, uint32_t w, uint32_t h, uint32_t num_chans, std::vector<uint8_t>& out_buf, uint32_t flags = 0, uint32_t max_threads = 0);
+
+	// Receives the bytes produced by fpng_stream_encoder. Returns false if they couldn't be written, which fails the encoder.
+	typedef bool (*fpng_write_func)(void* pUser, const void* pData, size_t len);
+
+	// Row streaming variant of fpng_encode_image_to_memory_parallel(), for images which are produced a band at a time. Rows are added top to bottom in 
+	// any number of calls. Every band of rows (at least 64) is filtered and compressed as soon as it's complete and handed to the write function as 
+	// its own IDAT chunk, so only one band is buffered and neither the whole image nor the whole file has to be in memory. Rows passed in a call which 
+	// contains a whole band aren't copied. The file has the same strip layout as the parallel encoder, with the fdSP chunk after the IDAT chunks, so 
+	// fpng_decode_memory() decodes it. A band which doesn't compress is still stored as a dynamic block, so for pure noise the file is larger than 
+	// the raw image, by at most 50%.
+	class fpng_stream_encoder
+	{
+	public:
+		fpng_stream_encoder();
+		~fpng_stream_encoder();
+		fpng_stream_encoder(const fpng_stream_encoder&) = delete;
+		fpng_stream_encoder& operator=(const fpng_stream_encoder&) = delete;
+
+		// Starts a file for an image of w x h pixels of num_chans (3 or 4) channels and writes its header. Can be called again to start another file.
+		bool begin(uint32_t w, uint32_t h, uint32_t num_chans, fpng_write_func pWrite_func, void* pUser);
+		// Adds num_rows rows, w*num_chans bytes per row, rows aren't padded. The file is completed when the last row of the image has been added.
+		bool add_rows(const void* pRows, uint32_t num_rows);
+		// Returns true if all rows have been added and the whole file has been written.
+		bool is_complete() const { return m_complete && !m_failed; }
+		uint32_t get_rows_added() const { return m_rows_added; }
+		uint64_t get_bytes_written() const { return m_bytes_written; }
+
+	private:
+		bool encode_band(const uint8_t* pBand_rows, uint32_t first_row, uint32_t num_rows);
+		bool write_chunk(const char* pType, const uint8_t* pData, uint32_t len);
+		bool write(const void* pData, size_t len);
+
+		uint32_t m_w, m_h, m_num_chans, m_bpl;
+		uint32_t m_band_rows;				// rows per band, the last band can be smaller
+		uint32_t m_rows_added;
+		uint32_t m_rows_in_band;			// rows of the current band in m_band
+		uint32_t m_adler32;					// of the filtered data of the bands written so far
+		uint64_t m_zlib_ofs;				// offset of the next band in the zlib stream
+		fpng_write_func m_pWrite_func;
+		void* m_pUser;
+		uint64_t m_bytes_written;
+		bool m_failed;
+		bool m_complete;
+		std::vector<uint8_t> m_band;
+		std::vector<uint8_t> m_strip_table;	// per band its first scanline and zlib offset, big endian, as in the fdSP chunk
+	};
+
 #ifndef FPNG_NO_STDIO
 	// Fast PNG encoding to the specified file.
 	bool fpng_encode_image_to_file(const char* pFilename, const void* pImage, uint32_t w, uint32_t h, uint32_t num_chans, uint32_t flags = 0);
@@ -96,14 +164,16 @@ namespace fpng
 	// 
 	// If the image is 24bpp and 32bpp is requested, the alpha values will be set to 0xFF. 
 	// If the image is 32bpp and 24bpp is requested, the alpha values will be discarded.
+	// Images written in strips by fpng_encode_image_to_memory_parallel() or fpng_stream_encoder are decoded on up to max_threads threads 
+	// (0: one per hardware thread), a strip per thread at a time. Other images, and all images when max_threads is 1, are decoded on the calling thread.
 	// 
 	// Returns FPNG_DECODE_SUCCESS on success, otherwise one of the failure codes above.
 	// If FPNG_DECODE_NOT_FPNG is returned, you must decompress the file with a general purpose PNG decoder.
 	// If another error occurs, the file is likely corrupted or invalid, but you can still try to decompress the file with another decoder (which will likely fail).
-	int fpng_decode_memory(const void* pImage, uint32_t image_size, std::vector<uint8_t>& out, uint32_t& width, uint32_t& height, uint32_t& channels_in_file, uint32_t desired_channels);
+	int fpng_decode_memory(const void* pImage, uint32_t image_size, std::vector<uint8_t>& out, uint32_t& width, uint32_t& height, uint32_t& channels_in_file, uint32_t desired_channels, uint32_t max_threads = 0);
 
 #ifndef FPNG_NO_STDIO
-	int fpng_decode_file(const char* pFilename, std::vector<uint8_t>& out, uint32_t& width, uint32_t& height, uint32_t& channels_in_file, uint32_t desired_channels);
+	int fpng_decode_file(const char* pFilename, std::vector<uint8_t>& out, uint32_t& width, uint32_t& height, uint32_t& channels_in_file, uint32_t desired_channels, uint32_t max_threads = 0);
 #endif
 
 } // namespace fpng
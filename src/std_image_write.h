@@ -68,6 +68,7 @@ USAGE:
       int stbi_write_tga_with_rle;             // defaults to true; set to 0 to disable RLE
       int stbi_write_png_compression_level;    // defaults to 8; set to higher for more compression
       int stbi_write_force_png_filter;         // defaults to -1; set to 0..5 to force a filter mode
+      int stbi_write_jpg_simd_level;           // defaults to 1 (SSE2) on x86/x64, 0 elsewhere; see below
 
 
    You can define STBI_WRITE_NO_STDIO to disable the file variant of these
@@ -97,7 +98,11 @@ USAGE:
    at the end of the line.)
 
    PNG allows you to set the deflate compression level by setting the global
-   variable 'stbi_write_png_compression_level' (it defaults to 8).
+   variable 'stbi_write_png_compression_level' (it defaults to 8). To use a
+   level for a single image without changing the global, e.g. when images are
+   written on several threads, call
+
+     int stbi_write_png_to_func_with_level(stbi_write_func *func, void *context, int w, int h, int comp, const void *data, int stride_in_bytes, int compression_level);
 
    HDR expects linear float data. Since the format is always 32-bit rgb(e)
    data, alpha (if provided) is discarded, and for monochrome data it is
@@ -108,6 +113,30 @@ USAGE:
 
    JPEG does ignore alpha channels in input data; quality is between 1 and 100.
    Higher quality looks better but results in a bigger image.
+
+   JPEG can also be written in bands of MCU rows, e.g. to encode the bands on
+   separate threads:
+
+     stbi_write_jpg_params params;
+     stbi_write_jpg_init_params(&params, w, h, comp, quality, subsample);
+     stbi_write_jpg_headers_to_func(func, context, &params);
+     stbi_write_jpg_mcu_rows_to_func(func, context, &params, data, first_mcu_row, end_mcu_row);  // for each band, in order
+     stbi_write_jpg_end_to_func(func, context);
+
+   subsample is -1 to pick it from the quality like stbi_write_jpg does, 0 for
+   no chroma subsampling (4:4:4) and 1 for 4:2:0. Every MCU row is written as
+   its own restart interval, so the output of a band doesn't depend on the
+   other bands and the bands' outputs can simply be concatenated in order.
+   params.num_mcu_rows is the number of MCU rows in the image.
+
+   The JPEG writer's color conversion, DCT and quantization have SSE2 and AVX2
+   variants. 'stbi_write_jpg_simd_level' selects them: 0 is the scalar code,
+   1 is SSE2, 2 is AVX2. Only set it to 2 if the cpu supports AVX2. The level
+   is copied into stbi_write_jpg_params.simd_level by
+   stbi_write_jpg_init_params, so it can be overridden per image. The SIMD
+   variants give the same coefficients as the scalar code, give or take a
+   rounding difference of 1 where the compiler contracts the scalar code into
+   fused multiply-adds.
    JPEG baseline (no JPEG progressive).
 
 CREDITS:
@@ -170,6 +199,7 @@ LICENSE
 STBIWDEF int stbi_write_tga_with_rle;
 STBIWDEF int stbi_write_png_compression_level;
 STBIWDEF int stbi_write_force_png_filter;
+STBIWDEF int stbi_write_jpg_simd_level;
 #endif
 
 #ifndef STBI_WRITE_NO_STDIO
@@ -187,11 +217,30 @@ STBIWDEF int stbiw_convert_wchar_to_utf8(char *buffer, size_t bufferlen, const w
 typedef void stbi_write_func(void *context, void *data, int size);
 
 STBIWDEF int stbi_write_png_to_func(stbi_write_func *func, void *context, int w, int h, int comp, const void  *data, int stride_in_bytes);
+STBIWDEF int stbi_write_png_to_func_with_level(stbi_write_func *func, void *context, int w, int h, int comp, const void  *data, int stride_in_bytes, int compression_level);
 STBIWDEF int stbi_write_bmp_to_func(stbi_write_func *func, void *context, int w, int h, int comp, const void  *data);
 STBIWDEF int stbi_write_tga_to_func(stbi_write_func *func, void *context, int w, int h, int comp, const void  *data);
 STBIWDEF int stbi_write_hdr_to_func(stbi_write_func *func, void *context, int w, int h, int comp, const float *data);
 STBIWDEF int stbi_write_jpg_to_func(stbi_write_func *func, void *context, int x, int y, int comp, const void  *data, int quality);
 
+// Banded JPEG writing, see the USAGE notes at the top.
+typedef struct
+{
+   int width, height, comp;
+   int subsample;          // 1 if chroma is subsampled (4:2:0), 0 if not (4:4:4)
+   int mcu_size;           // 16 with subsampling, 8 without
+   int mcus_per_row;
+   int num_mcu_rows;
+   int simd_level;         // 0: scalar, 1: SSE2, 2: AVX2. See stbi_write_jpg_simd_level
+   unsigned char YTable[64], UVTable[64];
+   float fdtbl_Y[64], fdtbl_UV[64];
+} stbi_write_jpg_params;
+
+STBIWDEF int stbi_write_jpg_init_params(stbi_write_jpg_params *params, int x, int y, int comp, int quality, int subsample);
+STBIWDEF int stbi_write_jpg_headers_to_func(stbi_write_func *func, void *context, const stbi_write_jpg_params *params);
+STBIWDEF int stbi_write_jpg_mcu_rows_to_func(stbi_write_func *func, void *context, const stbi_write_jpg_params *params, const void *data, int first_mcu_row, int end_mcu_row);
+STBIWDEF int stbi_write_jpg_end_to_func(stbi_write_func *func, void *context);
+
 STBIWDEF void stbi_flip_vertically_on_write(int flip_boolean);
 
 #endif//INCLUDE_STB_IMAGE_WRITE_H
@@ -247,14 +296,31 @@ STBIWDEF void stbi_flip_vertically_on_write(int flip_boolean);
 
 #define STBIW_UCHAR(x) (unsigned char) ((x) & 0xff)
 
+// SIMD kernels for the JPEG writer. SSE2 is always there on x64. The AVX2 kernels are compiled in where the compiler accepts the
+// intrinsics without a target switch (MSVC) or the target has AVX2 anyway, but only used if stbi_write_jpg_simd_level is set to 2,
+// as we can't check the cpu here.
+#if !defined(STBIW_NO_SIMD) && (defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__))
+#define STBIW_JPG_SSE2
+#include <emmintrin.h>
+#if defined(_MSC_VER) || defined(__AVX2__)
+#define STBIW_JPG_AVX2
+#include <immintrin.h>
+#endif
+#define STBIW_JPG_DEFAULT_SIMD_LEVEL 1
+#else
+#define STBIW_JPG_DEFAULT_SIMD_LEVEL 0
+#endif
+
 #ifdef STB_IMAGE_WRITE_STATIC
 static int stbi_write_png_compression_level = 8;
 static int stbi_write_tga_with_rle = 1;
 static int stbi_write_force_png_filter = -1;
+static int stbi_write_jpg_simd_level = STBIW_JPG_DEFAULT_SIMD_LEVEL;
 #else
 int stbi_write_png_compression_level = 8;
 int stbi_write_tga_with_rle = 1;
 int stbi_write_force_png_filter = -1;
+int stbi_write_jpg_simd_level = STBIW_JPG_DEFAULT_SIMD_LEVEL;
 #endif
 
 static int stbi__flip_vertically_on_write = 0;
@@ -1125,7 +1191,7 @@ static void stbiw__encode_png_line(unsigned char *pixels, int stride_bytes, int
    }
 }
 
-STBIWDEF unsigned char *stbi_write_png_to_mem(const unsigned char *pixels, int stride_bytes, int x, int y, int n, int *out_len)
+static unsigned char *stbiw__write_png_to_mem_with_level(const unsigned char *pixels, int stride_bytes, int x, int y, int n, int *out_len, int compression_level)
 {
    int force_filter = stbi_write_force_png_filter;
    int ctype[5] = { -1, 0, 4, 2, 6 };
@@ -1173,7 +1239,7 @@ STBIWDEF unsigned char *stbi_write_png_to_mem(const unsigned char *pixels, int s
       STBIW_MEMMOVE(filt+j*(x*n+1)+1, line_buffer, x*n);
    }
    STBIW_FREE(line_buffer);
-   zlib = stbi_zlib_compress(filt, y*( x*n+1), &zlen, stbi_write_png_compression_level);
+   zlib = stbi_zlib_compress(filt, y*( x*n+1), &zlen, compression_level);
    STBIW_FREE(filt);
    if (!zlib) return 0;
 
@@ -1211,6 +1277,11 @@ STBIWDEF unsigned char *stbi_write_png_to_mem(const unsigned char *pixels, int s
    return out;
 }
 
+STBIWDEF unsigned char *stbi_write_png_to_mem(const unsigned char *pixels, int stride_bytes, int x, int y, int n, int *out_len)
+{
+   return stbiw__write_png_to_mem_with_level(pixels, stride_bytes, x, y, n, out_len, stbi_write_png_compression_level);
+}
+
 #ifndef STBI_WRITE_NO_STDIO
 STBIWDEF int stbi_write_png(char const *filename, int x, int y, int comp, const void *data, int stride_bytes)
 {
@@ -1229,9 +1300,14 @@ STBIWDEF int stbi_write_png(char const *filename, int x, int y, int comp, const
 #endif
 
 STBIWDEF int stbi_write_png_to_func(stbi_write_func *func, void *context, int x, int y, int comp, const void *data, int stride_bytes)
+{
+   return stbi_write_png_to_func_with_level(func, context, x, y, comp, data, stride_bytes, stbi_write_png_compression_level);
+}
+
+STBIWDEF int stbi_write_png_to_func_with_level(stbi_write_func *func, void *context, int x, int y, int comp, const void *data, int stride_bytes, int compression_level)
 {
    int len;
-   unsigned char *png = stbi_write_png_to_mem((const unsigned char *) data, stride_bytes, x, y, comp, &len);
+   unsigned char *png = stbiw__write_png_to_mem_with_level((const unsigned char *) data, stride_bytes, x, y, comp, &len, compression_level);
    if (png == NULL) return 0;
    func(context, png, len);
    STBIW_FREE(png);
@@ -1256,9 +1332,9 @@ static void stbiw__jpg_writeBits(stbi__write_context *s, int *bitBufP, int *bitC
    bitBuf |= bs[0] << (24 - bitCnt);
    while(bitCnt >= 8) {
       unsigned char c = (bitBuf >> 16) & 255;
-      stbiw__putc(s, c);
+      stbiw__write1(s, c);
       if(c == 255) {
-         stbiw__putc(s, 0);
+         stbiw__write1(s, 0);
       }
       bitBuf <<= 8;
       bitCnt -= 8;
@@ -1325,11 +1401,9 @@ static void stbiw__jpg_calcBits(int val, unsigned short bits[2]) {
    bits[0] = val & ((1<<bits[1])-1);
 }
 
-static int stbiw__jpg_processDU(stbi__write_context *s, int *bitBuf, int *bitCnt, float *CDU, int du_stride, float *fdtbl, int DC, const unsigned short HTDC[256][2], const unsigned short HTAC[256][2]) {
-   const unsigned short EOB[2] = { HTAC[0x00][0], HTAC[0x00][1] };
-   const unsigned short M16zeroes[2] = { HTAC[0xF0][0], HTAC[0xF0][1] };
-   int dataOff, i, j, n, diff, end0pos, x, y;
-   int DU[64];
+// DCTs the rows and then the columns of the 8x8 block in CDU and quantizes/descales/zigzags the coefficients into DU
+static void stbiw__jpg_fdct_quantize_scalar(float *CDU, int du_stride, const float *fdtbl, int *DU) {
+   int dataOff, i, j, n, x, y;
 
    // DCT rows
    for(dataOff=0, n=du_stride*8; dataOff<n; dataOff+=du_stride) {
@@ -1351,6 +1425,243 @@ static int stbiw__jpg_processDU(stbi__write_context *s, int *bitBuf, int *bitCnt
          DU[stbiw__jpg_ZigZag[j]] = (int)(v < 0 ? v - 0.5f : v + 0.5f);
       }
    }
+}
+
+// Converts n pixels (comp 3 or 4) starting at src to level shifted Y, U and V
+static void stbiw__jpg_rgb_to_ycc_scalar(const unsigned char *src, int comp, int n, float *Y, float *U, float *V) {
+   int i;
+   for(i = 0; i < n; ++i, src += comp) {
+      float r = src[0], g = src[1], b = src[2];
+      Y[i]= +0.29900f*r + 0.58700f*g + 0.11400f*b - 128;
+      U[i]= -0.16874f*r - 0.33126f*g + 0.50000f*b;
+      V[i]= +0.50000f*r - 0.41869f*g - 0.08131f*b;
+   }
+}
+
+#ifdef STBIW_JPG_SSE2
+// The vector versions of the kernels do exactly the same operations in the same order as the scalar code, just on 4 or 8 lanes at once.
+// The 1D DCT is applied to 8 vectors, each lane is a separate row/column.
+#define STBIW__JPG_DCT_VECTORS(d, vtype, add, sub, mul, set1) { \
+      vtype tmp0 = add(d[0], d[7]), tmp7 = sub(d[0], d[7]); \
+      vtype tmp1 = add(d[1], d[6]), tmp6 = sub(d[1], d[6]); \
+      vtype tmp2 = add(d[2], d[5]), tmp5 = sub(d[2], d[5]); \
+      vtype tmp3 = add(d[3], d[4]), tmp4 = sub(d[3], d[4]); \
+      vtype tmp10 = add(tmp0, tmp3), tmp13 = sub(tmp0, tmp3); \
+      vtype tmp11 = add(tmp1, tmp2), tmp12 = sub(tmp1, tmp2); \
+      vtype z1, z2, z3, z4, z5, z11, z13; \
+      d[0] = add(tmp10, tmp11); \
+      d[4] = sub(tmp10, tmp11); \
+      z1 = mul(add(tmp12, tmp13), set1(0.707106781f)); \
+      d[2] = add(tmp13, z1); \
+      d[6] = sub(tmp13, z1); \
+      tmp10 = add(tmp4, tmp5); \
+      tmp11 = add(tmp5, tmp6); \
+      tmp12 = add(tmp6, tmp7); \
+      z5 = mul(sub(tmp10, tmp12), set1(0.382683433f)); \
+      z2 = add(mul(tmp10, set1(0.541196100f)), z5); \
+      z4 = add(mul(tmp12, set1(1.306562965f)), z5); \
+      z3 = mul(tmp11, set1(0.707106781f)); \
+      z11 = add(tmp7, z3); \
+      z13 = sub(tmp7, z3); \
+      d[5] = add(z13, z2); \
+      d[3] = sub(z13, z2); \
+      d[1] = add(z11, z4); \
+      d[7] = sub(z11, z4); \
+   }
+
+static void stbiw__jpg_DCT_sse2(__m128 *d) {
+   STBIW__JPG_DCT_VECTORS(d, __m128, _mm_add_ps, _mm_sub_ps, _mm_mul_ps, _mm_set1_ps)
+}
+
+// transposes the 8x8 block stored as left halves l[8] (columns 0-3) and right halves r[8] (columns 4-7) in place
+static void stbiw__jpg_transpose8x8_sse2(__m128 *l, __m128 *r) {
+   __m128 t;
+   _MM_TRANSPOSE4_PS(l[0], l[1], l[2], l[3]);
+   _MM_TRANSPOSE4_PS(r[4], r[5], r[6], r[7]);
+   _MM_TRANSPOSE4_PS(l[4], l[5], l[6], l[7]);
+   _MM_TRANSPOSE4_PS(r[0], r[1], r[2], r[3]);
+   // swap the off-diagonal 4x4 blocks
+   t = l[4]; l[4] = r[0]; r[0] = t;
+   t = l[5]; l[5] = r[1]; r[1] = t;
+   t = l[6]; l[6] = r[2]; r[2] = t;
+   t = l[7]; l[7] = r[3]; r[3] = t;
+}
+
+static __m128i stbiw__jpg_round_sse2(__m128 v) {
+   // (int)(v < 0 ? v - 0.5f : v + 0.5f)
+   const __m128 half = _mm_or_ps(_mm_set1_ps(0.5f), _mm_and_ps(v, _mm_set1_ps(-0.0f)));
+   return _mm_cvttps_epi32(_mm_add_ps(v, half));
+}
+
+static void stbiw__jpg_fdct_quantize_sse2(const float *CDU, int du_stride, const float *fdtbl, int *DU) {
+   __m128 l[8], r[8];
+   int q[64];
+   int i;
+   for(i = 0; i < 8; ++i) {
+      l[i] = _mm_loadu_ps(CDU + i*du_stride);
+      r[i] = _mm_loadu_ps(CDU + i*du_stride + 4);
+   }
+   // DCT rows: transposed, the rows are the columns
+   stbiw__jpg_transpose8x8_sse2(l, r);
+   stbiw__jpg_DCT_sse2(l);
+   stbiw__jpg_DCT_sse2(r);
+   stbiw__jpg_transpose8x8_sse2(l, r);
+   // DCT columns
+   stbiw__jpg_DCT_sse2(l);
+   stbiw__jpg_DCT_sse2(r);
+   // Quantize/descale
+   for(i = 0; i < 8; ++i) {
+      _mm_storeu_si128((__m128i*)(q + i*8), stbiw__jpg_round_sse2(_mm_mul_ps(l[i], _mm_loadu_ps(fdtbl + i*8))));
+      _mm_storeu_si128((__m128i*)(q + i*8 + 4), stbiw__jpg_round_sse2(_mm_mul_ps(r[i], _mm_loadu_ps(fdtbl + i*8 + 4))));
+   }
+   for(i = 0; i < 64; ++i) {
+      DU[stbiw__jpg_ZigZag[i]] = q[i];
+   }
+}
+
+static void stbiw__jpg_ycc_from_rgb_sse2(__m128 r, __m128 g, __m128 b, float *Y, float *U, float *V) {
+   _mm_storeu_ps(Y, _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(0.29900f), r), _mm_mul_ps(_mm_set1_ps(0.58700f), g)), _mm_mul_ps(_mm_set1_ps(0.11400f), b)), _mm_set1_ps(128.0f)));
+   _mm_storeu_ps(U, _mm_add_ps(_mm_sub_ps(_mm_mul_ps(_mm_set1_ps(-0.16874f), r), _mm_mul_ps(_mm_set1_ps(0.33126f), g)), _mm_mul_ps(_mm_set1_ps(0.50000f), b)));
+   _mm_storeu_ps(V, _mm_sub_ps(_mm_sub_ps(_mm_mul_ps(_mm_set1_ps(0.50000f), r), _mm_mul_ps(_mm_set1_ps(0.41869f), g)), _mm_mul_ps(_mm_set1_ps(0.08131f), b)));
+}
+
+// n is a multiple of 4
+static void stbiw__jpg_rgb_to_ycc_sse2(const unsigned char *src, int comp, int n, float *Y, float *U, float *V) {
+   const __m128i mask = _mm_set1_epi32(0xFF);
+   int i;
+   for(i = 0; i < n; i += 4, src += 4*comp) {
+      __m128i rgbx;
+      if(comp == 4) {
+         rgbx = _mm_loadu_si128((const __m128i*)src);
+      } else {
+         // 12 bytes for 4 pixels, spread them over 4 dwords. We can't read 16 bytes here, that could read past the end of the image.
+         int p[4];
+         p[0] = src[0] | (src[1] << 8) | (src[2] << 16);
+         p[1] = src[3] | (src[4] << 8) | (src[5] << 16);
+         p[2] = src[6] | (src[7] << 8) | (src[8] << 16);
+         p[3] = src[9] | (src[10] << 8) | (src[11] << 16);
+         rgbx = _mm_loadu_si128((const __m128i*)p);
+      }
+      stbiw__jpg_ycc_from_rgb_sse2(_mm_cvtepi32_ps(_mm_and_si128(rgbx, mask)), _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(rgbx, 8), mask)),
+                                   _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(rgbx, 16), mask)), Y+i, U+i, V+i);
+   }
+}
+#endif // STBIW_JPG_SSE2
+
+#ifdef STBIW_JPG_AVX2
+static void stbiw__jpg_DCT_avx2(__m256 *d) {
+   STBIW__JPG_DCT_VECTORS(d, __m256, _mm256_add_ps, _mm256_sub_ps, _mm256_mul_ps, _mm256_set1_ps)
+}
+
+static void stbiw__jpg_transpose8x8_avx2(__m256 *m) {
+   __m256 t0 = _mm256_unpacklo_ps(m[0], m[1]), t1 = _mm256_unpackhi_ps(m[0], m[1]);
+   __m256 t2 = _mm256_unpacklo_ps(m[2], m[3]), t3 = _mm256_unpackhi_ps(m[2], m[3]);
+   __m256 t4 = _mm256_unpacklo_ps(m[4], m[5]), t5 = _mm256_unpackhi_ps(m[4], m[5]);
+   __m256 t6 = _mm256_unpacklo_ps(m[6], m[7]), t7 = _mm256_unpackhi_ps(m[6], m[7]);
+   __m256 s0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1,0,1,0)), s1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3,2,3,2));
+   __m256 s2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1,0,1,0)), s3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3,2,3,2));
+   __m256 s4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1,0,1,0)), s5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3,2,3,2));
+   __m256 s6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1,0,1,0)), s7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3,2,3,2));
+   m[0] = _mm256_permute2f128_ps(s0, s4, 0x20);
+   m[1] = _mm256_permute2f128_ps(s1, s5, 0x20);
+   m[2] = _mm256_permute2f128_ps(s2, s6, 0x20);
+   m[3] = _mm256_permute2f128_ps(s3, s7, 0x20);
+   m[4] = _mm256_permute2f128_ps(s0, s4, 0x31);
+   m[5] = _mm256_permute2f128_ps(s1, s5, 0x31);
+   m[6] = _mm256_permute2f128_ps(s2, s6, 0x31);
+   m[7] = _mm256_permute2f128_ps(s3, s7, 0x31);
+}
+
+static void stbiw__jpg_fdct_quantize_avx2(const float *CDU, int du_stride, const float *fdtbl, int *DU) {
+   __m256 m[8];
+   int q[64];
+   int i;
+   for(i = 0; i < 8; ++i) {
+      m[i] = _mm256_loadu_ps(CDU + i*du_stride);
+   }
+   // DCT rows: transposed, the rows are the columns
+   stbiw__jpg_transpose8x8_avx2(m);
+   stbiw__jpg_DCT_avx2(m);
+   stbiw__jpg_transpose8x8_avx2(m);
+   // DCT columns
+   stbiw__jpg_DCT_avx2(m);
+   // Quantize/descale, (int)(v < 0 ? v - 0.5f : v + 0.5f)
+   for(i = 0; i < 8; ++i) {
+      __m256 v = _mm256_mul_ps(m[i], _mm256_loadu_ps(fdtbl + i*8));
+      __m256 half = _mm256_or_ps(_mm256_set1_ps(0.5f), _mm256_and_ps(v, _mm256_set1_ps(-0.0f)));
+      _mm256_storeu_si256((__m256i*)(q + i*8), _mm256_cvttps_epi32(_mm256_add_ps(v, half)));
+   }
+   for(i = 0; i < 64; ++i) {
+      DU[stbiw__jpg_ZigZag[i]] = q[i];
+   }
+}
+
+// n is a multiple of 8
+static void stbiw__jpg_rgb_to_ycc_avx2(const unsigned char *src, int comp, int n, float *Y, float *U, float *V) {
+   // spreads 8 RGB pixels, loaded as bytes 0-15 in the low lane and bytes 8-23 in the high lane, over 8 dwords
+   const __m256i spreadRGB = _mm256_setr_epi8(0,1,2,-1, 3,4,5,-1, 6,7,8,-1, 9,10,11,-1, 4,5,6,-1, 7,8,9,-1, 10,11,12,-1, 13,14,15,-1);
+   const __m256i mask = _mm256_set1_epi32(0xFF);
+   int i;
+   for(i = 0; i < n; i += 8, src += 8*comp) {
+      __m256i rgbx;
+      __m256 r, g, b;
+      if(comp == 4) {
+         rgbx = _mm256_loadu_si256((const __m256i*)src);
+      } else {
+         rgbx = _mm256_shuffle_epi8(_mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)src)), _mm_loadu_si128((const __m128i*)(src + 8)), 1), spreadRGB);
+      }
+      r = _mm256_cvtepi32_ps(_mm256_and_si256(rgbx, mask));
+      g = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(rgbx, 8), mask));
+      b = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(rgbx, 16), mask));
+      _mm256_storeu_ps(Y+i, _mm256_sub_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(0.29900f), r), _mm256_mul_ps(_mm256_set1_ps(0.58700f), g)), _mm256_mul_ps(_mm256_set1_ps(0.11400f), b)), _mm256_set1_ps(128.0f)));
+      _mm256_storeu_ps(U+i, _mm256_add_ps(_mm256_sub_ps(_mm256_mul_ps(_mm256_set1_ps(-0.16874f), r), _mm256_mul_ps(_mm256_set1_ps(0.33126f), g)), _mm256_mul_ps(_mm256_set1_ps(0.50000f), b)));
+      _mm256_storeu_ps(V+i, _mm256_sub_ps(_mm256_sub_ps(_mm256_mul_ps(_mm256_set1_ps(0.50000f), r), _mm256_mul_ps(_mm256_set1_ps(0.41869f), g)), _mm256_mul_ps(_mm256_set1_ps(0.08131f), b)));
+   }
+}
+#endif // STBIW_JPG_AVX2
+
+static void stbiw__jpg_fdct_quantize(float *CDU, int du_stride, const float *fdtbl, int *DU, int simd_level) {
+#ifdef STBIW_JPG_AVX2
+   if(simd_level >= 2) {
+      stbiw__jpg_fdct_quantize_avx2(CDU, du_stride, fdtbl, DU);
+      return;
+   }
+#endif
+#ifdef STBIW_JPG_SSE2
+   if(simd_level >= 1) {
+      stbiw__jpg_fdct_quantize_sse2(CDU, du_stride, fdtbl, DU);
+      return;
+   }
+#endif
+   (void)simd_level;
+   stbiw__jpg_fdct_quantize_scalar(CDU, du_stride, fdtbl, DU);
+}
+
+// Converts n pixels (comp 3 or 4, n a multiple of 8) starting at src to level shifted Y, U and V
+static void stbiw__jpg_rgb_to_ycc(const unsigned char *src, int comp, int n, float *Y, float *U, float *V, int simd_level) {
+#ifdef STBIW_JPG_AVX2
+   if(simd_level >= 2) {
+      stbiw__jpg_rgb_to_ycc_avx2(src, comp, n, Y, U, V);
+      return;
+   }
+#endif
+#ifdef STBIW_JPG_SSE2
+   if(simd_level >= 1) {
+      stbiw__jpg_rgb_to_ycc_sse2(src, comp, n, Y, U, V);
+      return;
+   }
+#endif
+   (void)simd_level;
+   stbiw__jpg_rgb_to_ycc_scalar(src, comp, n, Y, U, V);
+}
+
+static int stbiw__jpg_processDU(stbi__write_context *s, int *bitBuf, int *bitCnt, float *CDU, int du_stride, const float *fdtbl, int DC, const unsigned short HTDC[256][2], const unsigned short HTAC[256][2], int simd_level) {
+   const unsigned short EOB[2] = { HTAC[0x00][0], HTAC[0x00][1] };
+   const unsigned short M16zeroes[2] = { HTAC[0xF0][0], HTAC[0xF0][1] };
+   int i, diff, end0pos;
+   int DU[64];
+
+   stbiw__jpg_fdct_quantize(CDU, du_stride, fdtbl, DU, simd_level);
 
    // Encode DC
    diff = DU[0] - DC;
@@ -1395,207 +1706,259 @@ static int stbiw__jpg_processDU(stbi__write_context *s, int *bitBuf, int *bitCnt
    return DU[0];
 }
 
-static int stbi_write_jpg_core(stbi__write_context *s, int width, int height, int comp, const void* data, int quality) {
-   // Constants that don't pollute global namespace
-   static const unsigned char std_dc_luminance_nrcodes[] = {0,0,1,5,1,1,1,1,1,1,0,0,0,0,0,0,0};
-   static const unsigned char std_dc_luminance_values[] = {0,1,2,3,4,5,6,7,8,9,10,11};
-   static const unsigned char std_ac_luminance_nrcodes[] = {0,0,2,1,3,3,2,4,3,5,5,4,4,0,0,1,0x7d};
-   static const unsigned char std_ac_luminance_values[] = {
-      0x01,0x02,0x03,0x00,0x04,0x11,0x05,0x12,0x21,0x31,0x41,0x06,0x13,0x51,0x61,0x07,0x22,0x71,0x14,0x32,0x81,0x91,0xa1,0x08,
-      0x23,0x42,0xb1,0xc1,0x15,0x52,0xd1,0xf0,0x24,0x33,0x62,0x72,0x82,0x09,0x0a,0x16,0x17,0x18,0x19,0x1a,0x25,0x26,0x27,0x28,
-      0x29,0x2a,0x34,0x35,0x36,0x37,0x38,0x39,0x3a,0x43,0x44,0x45,0x46,0x47,0x48,0x49,0x4a,0x53,0x54,0x55,0x56,0x57,0x58,0x59,
-      0x5a,0x63,0x64,0x65,0x66,0x67,0x68,0x69,0x6a,0x73,0x74,0x75,0x76,0x77,0x78,0x79,0x7a,0x83,0x84,0x85,0x86,0x87,0x88,0x89,
-      0x8a,0x92,0x93,0x94,0x95,0x96,0x97,0x98,0x99,0x9a,0xa2,0xa3,0xa4,0xa5,0xa6,0xa7,0xa8,0xa9,0xaa,0xb2,0xb3,0xb4,0xb5,0xb6,
-      0xb7,0xb8,0xb9,0xba,0xc2,0xc3,0xc4,0xc5,0xc6,0xc7,0xc8,0xc9,0xca,0xd2,0xd3,0xd4,0xd5,0xd6,0xd7,0xd8,0xd9,0xda,0xe1,0xe2,
-      0xe3,0xe4,0xe5,0xe6,0xe7,0xe8,0xe9,0xea,0xf1,0xf2,0xf3,0xf4,0xf5,0xf6,0xf7,0xf8,0xf9,0xfa
-   };
-   static const unsigned char std_dc_chrominance_nrcodes[] = {0,0,3,1,1,1,1,1,1,1,1,1,0,0,0,0,0};
-   static const unsigned char std_dc_chrominance_values[] = {0,1,2,3,4,5,6,7,8,9,10,11};
-   static const unsigned char std_ac_chrominance_nrcodes[] = {0,0,2,1,2,4,4,3,4,7,5,4,4,0,1,2,0x77};
-   static const unsigned char std_ac_chrominance_values[] = {
-      0x00,0x01,0x02,0x03,0x11,0x04,0x05,0x21,0x31,0x06,0x12,0x41,0x51,0x07,0x61,0x71,0x13,0x22,0x32,0x81,0x08,0x14,0x42,0x91,
-      0xa1,0xb1,0xc1,0x09,0x23,0x33,0x52,0xf0,0x15,0x62,0x72,0xd1,0x0a,0x16,0x24,0x34,0xe1,0x25,0xf1,0x17,0x18,0x19,0x1a,0x26,
-      0x27,0x28,0x29,0x2a,0x35,0x36,0x37,0x38,0x39,0x3a,0x43,0x44,0x45,0x46,0x47,0x48,0x49,0x4a,0x53,0x54,0x55,0x56,0x57,0x58,
-      0x59,0x5a,0x63,0x64,0x65,0x66,0x67,0x68,0x69,0x6a,0x73,0x74,0x75,0x76,0x77,0x78,0x79,0x7a,0x82,0x83,0x84,0x85,0x86,0x87,
-      0x88,0x89,0x8a,0x92,0x93,0x94,0x95,0x96,0x97,0x98,0x99,0x9a,0xa2,0xa3,0xa4,0xa5,0xa6,0xa7,0xa8,0xa9,0xaa,0xb2,0xb3,0xb4,
-      0xb5,0xb6,0xb7,0xb8,0xb9,0xba,0xc2,0xc3,0xc4,0xc5,0xc6,0xc7,0xc8,0xc9,0xca,0xd2,0xd3,0xd4,0xd5,0xd6,0xd7,0xd8,0xd9,0xda,
-      0xe2,0xe3,0xe4,0xe5,0xe6,0xe7,0xe8,0xe9,0xea,0xf2,0xf3,0xf4,0xf5,0xf6,0xf7,0xf8,0xf9,0xfa
-   };
-   // Huffman tables
-   static const unsigned short YDC_HT[256][2] = { {0,2},{2,3},{3,3},{4,3},{5,3},{6,3},{14,4},{30,5},{62,6},{126,7},{254,8},{510,9}};
-   static const unsigned short UVDC_HT[256][2] = { {0,2},{1,2},{2,2},{6,3},{14,4},{30,5},{62,6},{126,7},{254,8},{510,9},{1022,10},{2046,11}};
-   static const unsigned short YAC_HT[256][2] = {
-      {10,4},{0,2},{1,2},{4,3},{11,4},{26,5},{120,7},{248,8},{1014,10},{65410,16},{65411,16},{0,0},{0,0},{0,0},{0,0},{0,0},{0,0},
-      {12,4},{27,5},{121,7},{502,9},{2038,11},{65412,16},{65413,16},{65414,16},{65415,16},{65416,16},{0,0},{0,0},{0,0},{0,0},{0,0},{0,0},
-      {28,5},{249,8},{1015,10},{4084,12},{65417,16},{65418,16},{65419,16},{65420,16},{65421,16},{65422,16},{0,0},{0,0},{0,0},{0,0},{0,0},{0,0},
-      {58,6},{503,9},{4085,12},{65423,16},{65424,16},{65425,16},{65426,16},{65427,16},{65428,16},{65429,16},{0,0},{0,0},{0,0},{0,0},{0,0},{0,0},
-      {59,6},{1016,10},{65430,16},{65431,16},{65432,16},{65433,16},{65434,16},{65435,16},{65436,16},{65437,16},{0,0},{0,0},{0,0},{0,0},{0,0},{0,0},
-      {122,7},{2039,11},{65438,16},{65439,16},{65440,16},{65441,16},{65442,16},{65443,16},{65444,16},{65445,16},{0,0},{0,0},{0,0},{0,0},{0,0},{0,0},
-      {123,7},{4086,12},{65446,16},{65447,16},{65448,16},{65449,16},{65450,16},{65451,16},{65452,16},{65453,16},{0,0},{0,0},{0,0},{0,0},{0,0},{0,0},
-      {250,8},{4087,12},{65454,16},{65455,16},{65456,16},{65457,16},{65458,16},{65459,16},{65460,16},{65461,16},{0,0},{0,0},{0,0},{0,0},{0,0},{0,0},
-      {504,9},{32704,15},{65462,16},{65463,16},{65464,16},{65465,16},{65466,16},{65467,16},{65468,16},{65469,16},{0,0},{0,0},{0,0},{0,0},{0,0},{0,0},
-      {505,9},{65470,16},{65471,16},{65472,16},{65473,16},{65474,16},{65475,16},{65476,16},{65477,16},{65478,16},{0,0},{0,0},{0,0},{0,0},{0,0},{0,0},
-      {506,9},{65479,16},{65480,16},{65481,16},{65482,16},{65483,16},{65484,16},{65485,16},{65486,16},{65487,16},{0,0},{0,0},{0,0},{0,0},{0,0},{0,0},
-      {1017,10},{65488,16},{65489,16},{65490,16},{65491,16},{65492,16},{65493,16},{65494,16},{65495,16},{65496,16},{0,0},{0,0},{0,0},{0,0},{0,0},{0,0},
-      {1018,10},{65497,16},{65498,16},{65499,16},{65500,16},{65501,16},{65502,16},{65503,16},{65504,16},{65505,16},{0,0},{0,0},{0,0},{0,0},{0,0},{0,0},
-      {2040,11},{65506,16},{65507,16},{65508,16},{65509,16},{65510,16},{65511,16},{65512,16},{65513,16},{65514,16},{0,0},{0,0},{0,0},{0,0},{0,0},{0,0},
-      {65515,16},{65516,16},{65517,16},{65518,16},{65519,16},{65520,16},{65521,16},{65522,16},{65523,16},{65524,16},{0,0},{0,0},{0,0},{0,0},{0,0},
-      {2041,11},{65525,16},{65526,16},{65527,16},{65528,16},{65529,16},{65530,16},{65531,16},{65532,16},{65533,16},{65534,16},{0,0},{0,0},{0,0},{0,0},{0,0}
-   };
-   static const unsigned short UVAC_HT[256][2] = {
-      {0,2},{1,2},{4,3},{10,4},{24,5},{25,5},{56,6},{120,7},{500,9},{1014,10},{4084,12},{0,0},{0,0},{0,0},{0,0},{0,0},{0,0},
-      {11,4},{57,6},{246,8},{501,9},{2038,11},{4085,12},{65416,16},{65417,16},{65418,16},{65419,16},{0,0},{0,0},{0,0},{0,0},{0,0},{0,0},
-      {26,5},{247,8},{1015,10},{4086,12},{32706,15},{65420,16},{65421,16},{65422,16},{65423,16},{65424,16},{0,0},{0,0},{0,0},{0,0},{0,0},{0,0},
-      {27,5},{248,8},{1016,10},{4087,12},{65425,16},{65426,16},{65427,16},{65428,16},{65429,16},{65430,16},{0,0},{0,0},{0,0},{0,0},{0,0},{0,0},
-      {58,6},{502,9},{65431,16},{65432,16},{65433,16},{65434,16},{65435,16},{65436,16},{65437,16},{65438,16},{0,0},{0,0},{0,0},{0,0},{0,0},{0,0},
-      {59,6},{1017,10},{65439,16},{65440,16},{65441,16},{65442,16},{65443,16},{65444,16},{65445,16},{65446,16},{0,0},{0,0},{0,0},{0,0},{0,0},{0,0},
-      {121,7},{2039,11},{65447,16},{65448,16},{65449,16},{65450,16},{65451,16},{65452,16},{65453,16},{65454,16},{0,0},{0,0},{0,0},{0,0},{0,0},{0,0},
-      {122,7},{2040,11},{65455,16},{65456,16},{65457,16},{65458,16},{65459,16},{65460,16},{65461,16},{65462,16},{0,0},{0,0},{0,0},{0,0},{0,0},{0,0},
-      {249,8},{65463,16},{65464,16},{65465,16},{65466,16},{65467,16},{65468,16},{65469,16},{65470,16},{65471,16},{0,0},{0,0},{0,0},{0,0},{0,0},{0,0},
-      {503,9},{65472,16},{65473,16},{65474,16},{65475,16},{65476,16},{65477,16},{65478,16},{65479,16},{65480,16},{0,0},{0,0},{0,0},{0,0},{0,0},{0,0},
-      {504,9},{65481,16},{65482,16},{65483,16},{65484,16},{65485,16},{65486,16},{65487,16},{65488,16},{65489,16},{0,0},{0,0},{0,0},{0,0},{0,0},{0,0},
-      {505,9},{65490,16},{65491,16},{65492,16},{65493,16},{65494,16},{65495,16},{65496,16},{65497,16},{65498,16},{0,0},{0,0},{0,0},{0,0},{0,0},{0,0},
-      {506,9},{65499,16},{65500,16},{65501,16},{65502,16},{65503,16},{65504,16},{65505,16},{65506,16},{65507,16},{0,0},{0,0},{0,0},{0,0},{0,0},{0,0},
-      {2041,11},{65508,16},{65509,16},{65510,16},{65511,16},{65512,16},{65513,16},{65514,16},{65515,16},{65516,16},{0,0},{0,0},{0,0},{0,0},{0,0},{0,0},
-      {16352,14},{65517,16},{65518,16},{65519,16},{65520,16},{65521,16},{65522,16},{65523,16},{65524,16},{65525,16},{0,0},{0,0},{0,0},{0,0},{0,0},
-      {1018,10},{32707,15},{65526,16},{65527,16},{65528,16},{65529,16},{65530,16},{65531,16},{65532,16},{65533,16},{65534,16},{0,0},{0,0},{0,0},{0,0},{0,0}
-   };
-   static const int YQT[] = {16,11,10,16,24,40,51,61,12,12,14,19,26,58,60,55,14,13,16,24,40,57,69,56,14,17,22,29,51,87,80,62,18,22,
-                             37,56,68,109,103,77,24,35,55,64,81,104,113,92,49,64,78,87,103,121,120,101,72,92,95,98,112,100,103,99};
-   static const int UVQT[] = {17,18,24,47,99,99,99,99,18,21,26,66,99,99,99,99,24,26,56,99,99,99,99,99,47,66,99,99,99,99,99,99,
-                              99,99,99,99,99,99,99,99,99,99,99,99,99,99,99,99,99,99,99,99,99,99,99,99,99,99,99,99,99,99,99,99};
-   static const float aasf[] = { 1.0f * 2.828427125f, 1.387039845f * 2.828427125f, 1.306562965f * 2.828427125f, 1.175875602f * 2.828427125f,
-                                 1.0f * 2.828427125f, 0.785694958f * 2.828427125f, 0.541196100f * 2.828427125f, 0.275899379f * 2.828427125f };
-
-   int row, col, i, k, subsample;
-   float fdtbl_Y[64], fdtbl_UV[64];
-   unsigned char YTable[64], UVTable[64];
-
-   if(!data || !width || !height || comp > 4 || comp < 1) {
+static const unsigned char stbiw__jpg_std_dc_luminance_nrcodes[] = {0,0,1,5,1,1,1,1,1,1,0,0,0,0,0,0,0};
+static const unsigned char stbiw__jpg_std_dc_luminance_values[] = {0,1,2,3,4,5,6,7,8,9,10,11};
+static const unsigned char stbiw__jpg_std_ac_luminance_nrcodes[] = {0,0,2,1,3,3,2,4,3,5,5,4,4,0,0,1,0x7d};
+static const unsigned char stbiw__jpg_std_ac_luminance_values[] = {
+   0x01,0x02,0x03,0x00,0x04,0x11,0x05,0x12,0x21,0x31,0x41,0x06,0x13,0x51,0x61,0x07,0x22,0x71,0x14,0x32,0x81,0x91,0xa1,0x08,
+   0x23,0x42,0xb1,0xc1,0x15,0x52,0xd1,0xf0,0x24,0x33,0x62,0x72,0x82,0x09,0x0a,0x16,0x17,0x18,0x19,0x1a,0x25,0x26,0x27,0x28,
+   0x29,0x2a,0x34,0x35,0x36,0x37,0x38,0x39,0x3a,0x43,0x44,0x45,0x46,0x47,0x48,0x49,0x4a,0x53,0x54,0x55,0x56,0x57,0x58,0x59,
+   0x5a,0x63,0x64,0x65,0x66,0x67,0x68,0x69,0x6a,0x73,0x74,0x75,0x76,0x77,0x78,0x79,0x7a,0x83,0x84,0x85,0x86,0x87,0x88,0x89,
+   0x8a,0x92,0x93,0x94,0x95,0x96,0x97,0x98,0x99,0x9a,0xa2,0xa3,0xa4,0xa5,0xa6,0xa7,0xa8,0xa9,0xaa,0xb2,0xb3,0xb4,0xb5,0xb6,
+   0xb7,0xb8,0xb9,0xba,0xc2,0xc3,0xc4,0xc5,0xc6,0xc7,0xc8,0xc9,0xca,0xd2,0xd3,0xd4,0xd5,0xd6,0xd7,0xd8,0xd9,0xda,0xe1,0xe2,
+   0xe3,0xe4,0xe5,0xe6,0xe7,0xe8,0xe9,0xea,0xf1,0xf2,0xf3,0xf4,0xf5,0xf6,0xf7,0xf8,0xf9,0xfa
+};
+static const unsigned char stbiw__jpg_std_dc_chrominance_nrcodes[] = {0,0,3,1,1,1,1,1,1,1,1,1,0,0,0,0,0};
+static const unsigned char stbiw__jpg_std_dc_chrominance_values[] = {0,1,2,3,4,5,6,7,8,9,10,11};
+static const unsigned char stbiw__jpg_std_ac_chrominance_nrcodes[] = {0,0,2,1,2,4,4,3,4,7,5,4,4,0,1,2,0x77};
+static const unsigned char stbiw__jpg_std_ac_chrominance_values[] = {
+   0x00,0x01,0x02,0x03,0x11,0x04,0x05,0x21,0x31,0x06,0x12,0x41,0x51,0x07,0x61,0x71,0x13,0x22,0x32,0x81,0x08,0x14,0x42,0x91,
+   0xa1,0xb1,0xc1,0x09,0x23,0x33,0x52,0xf0,0x15,0x62,0x72,0xd1,0x0a,0x16,0x24,0x34,0xe1,0x25,0xf1,0x17,0x18,0x19,0x1a,0x26,
+   0x27,0x28,0x29,0x2a,0x35,0x36,0x37,0x38,0x39,0x3a,0x43,0x44,0x45,0x46,0x47,0x48,0x49,0x4a,0x53,0x54,0x55,0x56,0x57,0x58,
+   0x59,0x5a,0x63,0x64,0x65,0x66,0x67,0x68,0x69,0x6a,0x73,0x74,0x75,0x76,0x77,0x78,0x79,0x7a,0x82,0x83,0x84,0x85,0x86,0x87,
+   0x88,0x89,0x8a,0x92,0x93,0x94,0x95,0x96,0x97,0x98,0x99,0x9a,0xa2,0xa3,0xa4,0xa5,0xa6,0xa7,0xa8,0xa9,0xaa,0xb2,0xb3,0xb4,
+   0xb5,0xb6,0xb7,0xb8,0xb9,0xba,0xc2,0xc3,0xc4,0xc5,0xc6,0xc7,0xc8,0xc9,0xca,0xd2,0xd3,0xd4,0xd5,0xd6,0xd7,0xd8,0xd9,0xda,
+   0xe2,0xe3,0xe4,0xe5,0xe6,0xe7,0xe8,0xe9,0xea,0xf2,0xf3,0xf4,0xf5,0xf6,0xf7,0xf8,0xf9,0xfa
+};
+// Huffman tables
+static const unsigned short stbiw__jpg_YDC_HT[256][2] = { {0,2},{2,3},{3,3},{4,3},{5,3},{6,3},{14,4},{30,5},{62,6},{126,7},{254,8},{510,9}};
+static const unsigned short stbiw__jpg_UVDC_HT[256][2] = { {0,2},{1,2},{2,2},{6,3},{14,4},{30,5},{62,6},{126,7},{254,8},{510,9},{1022,10},{2046,11}};
+static const unsigned short stbiw__jpg_YAC_HT[256][2] = {
+   {10,4},{0,2},{1,2},{4,3},{11,4},{26,5},{120,7},{248,8},{1014,10},{65410,16},{65411,16},{0,0},{0,0},{0,0},{0,0},{0,0},{0,0},
+   {12,4},{27,5},{121,7},{502,9},{2038,11},{65412,16},{65413,16},{65414,16},{65415,16},{65416,16},{0,0},{0,0},{0,0},{0,0},{0,0},{0,0},
+   {28,5},{249,8},{1015,10},{4084,12},{65417,16},{65418,16},{65419,16},{65420,16},{65421,16},{65422,16},{0,0},{0,0},{0,0},{0,0},{0,0},{0,0},
+   {58,6},{503,9},{4085,12},{65423,16},{65424,16},{65425,16},{65426,16},{65427,16},{65428,16},{65429,16},{0,0},{0,0},{0,0},{0,0},{0,0},{0,0},
+   {59,6},{1016,10},{65430,16},{65431,16},{65432,16},{65433,16},{65434,16},{65435,16},{65436,16},{65437,16},{0,0},{0,0},{0,0},{0,0},{0,0},{0,0},
+   {122,7},{2039,11},{65438,16},{65439,16},{65440,16},{65441,16},{65442,16},{65443,16},{65444,16},{65445,16},{0,0},{0,0},{0,0},{0,0},{0,0},{0,0},
+   {123,7},{4086,12},{65446,16},{65447,16},{65448,16},{65449,16},{65450,16},{65451,16},{65452,16},{65453,16},{0,0},{0,0},{0,0},{0,0},{0,0},{0,0},
+   {250,8},{4087,12},{65454,16},{65455,16},{65456,16},{65457,16},{65458,16},{65459,16},{65460,16},{65461,16},{0,0},{0,0},{0,0},{0,0},{0,0},{0,0},
+   {504,9},{32704,15},{65462,16},{65463,16},{65464,16},{65465,16},{65466,16},{65467,16},{65468,16},{65469,16},{0,0},{0,0},{0,0},{0,0},{0,0},{0,0},
+   {505,9},{65470,16},{65471,16},{65472,16},{65473,16},{65474,16},{65475,16},{65476,16},{65477,16},{65478,16},{0,0},{0,0},{0,0},{0,0},{0,0},{0,0},
+   {506,9},{65479,16},{65480,16},{65481,16},{65482,16},{65483,16},{65484,16},{65485,16},{65486,16},{65487,16},{0,0},{0,0},{0,0},{0,0},{0,0},{0,0},
+   {1017,10},{65488,16},{65489,16},{65490,16},{65491,16},{65492,16},{65493,16},{65494,16},{65495,16},{65496,16},{0,0},{0,0},{0,0},{0,0},{0,0},{0,0},
+   {1018,10},{65497,16},{65498,16},{65499,16},{65500,16},{65501,16},{65502,16},{65503,16},{65504,16},{65505,16},{0,0},{0,0},{0,0},{0,0},{0,0},{0,0},
+   {2040,11},{65506,16},{65507,16},{65508,16},{65509,16},{65510,16},{65511,16},{65512,16},{65513,16},{65514,16},{0,0},{0,0},{0,0},{0,0},{0,0},{0,0},
+   {65515,16},{65516,16},{65517,16},{65518,16},{65519,16},{65520,16},{65521,16},{65522,16},{65523,16},{65524,16},{0,0},{0,0},{0,0},{0,0},{0,0},
+   {2041,11},{65525,16},{65526,16},{65527,16},{65528,16},{65529,16},{65530,16},{65531,16},{65532,16},{65533,16},{65534,16},{0,0},{0,0},{0,0},{0,0},{0,0}
+};
+static const unsigned short stbiw__jpg_UVAC_HT[256][2] = {
+   {0,2},{1,2},{4,3},{10,4},{24,5},{25,5},{56,6},{120,7},{500,9},{1014,10},{4084,12},{0,0},{0,0},{0,0},{0,0},{0,0},{0,0},
+   {11,4},{57,6},{246,8},{501,9},{2038,11},{4085,12},{65416,16},{65417,16},{65418,16},{65419,16},{0,0},{0,0},{0,0},{0,0},{0,0},{0,0},
+   {26,5},{247,8},{1015,10},{4086,12},{32706,15},{65420,16},{65421,16},{65422,16},{65423,16},{65424,16},{0,0},{0,0},{0,0},{0,0},{0,0},{0,0},
+   {27,5},{248,8},{1016,10},{4087,12},{65425,16},{65426,16},{65427,16},{65428,16},{65429,16},{65430,16},{0,0},{0,0},{0,0},{0,0},{0,0},{0,0},
+   {58,6},{502,9},{65431,16},{65432,16},{65433,16},{65434,16},{65435,16},{65436,16},{65437,16},{65438,16},{0,0},{0,0},{0,0},{0,0},{0,0},{0,0},
+   {59,6},{1017,10},{65439,16},{65440,16},{65441,16},{65442,16},{65443,16},{65444,16},{65445,16},{65446,16},{0,0},{0,0},{0,0},{0,0},{0,0},{0,0},
+   {121,7},{2039,11},{65447,16},{65448,16},{65449,16},{65450,16},{65451,16},{65452,16},{65453,16},{65454,16},{0,0},{0,0},{0,0},{0,0},{0,0},{0,0},
+   {122,7},{2040,11},{65455,16},{65456,16},{65457,16},{65458,16},{65459,16},{65460,16},{65461,16},{65462,16},{0,0},{0,0},{0,0},{0,0},{0,0},{0,0},
+   {249,8},{65463,16},{65464,16},{65465,16},{65466,16},{65467,16},{65468,16},{65469,16},{65470,16},{65471,16},{0,0},{0,0},{0,0},{0,0},{0,0},{0,0},
+   {503,9},{65472,16},{65473,16},{65474,16},{65475,16},{65476,16},{65477,16},{65478,16},{65479,16},{65480,16},{0,0},{0,0},{0,0},{0,0},{0,0},{0,0},
+   {504,9},{65481,16},{65482,16},{65483,16},{65484,16},{65485,16},{65486,16},{65487,16},{65488,16},{65489,16},{0,0},{0,0},{0,0},{0,0},{0,0},{0,0},
+   {505,9},{65490,16},{65491,16},{65492,16},{65493,16},{65494,16},{65495,16},{65496,16},{65497,16},{65498,16},{0,0},{0,0},{0,0},{0,0},{0,0},{0,0},
+   {506,9},{65499,16},{65500,16},{65501,16},{65502,16},{65503,16},{65504,16},{65505,16},{65506,16},{65507,16},{0,0},{0,0},{0,0},{0,0},{0,0},{0,0},
+   {2041,11},{65508,16},{65509,16},{65510,16},{65511,16},{65512,16},{65513,16},{65514,16},{65515,16},{65516,16},{0,0},{0,0},{0,0},{0,0},{0,0},{0,0},
+   {16352,14},{65517,16},{65518,16},{65519,16},{65520,16},{65521,16},{65522,16},{65523,16},{65524,16},{65525,16},{0,0},{0,0},{0,0},{0,0},{0,0},
+   {1018,10},{32707,15},{65526,16},{65527,16},{65528,16},{65529,16},{65530,16},{65531,16},{65532,16},{65533,16},{65534,16},{0,0},{0,0},{0,0},{0,0},{0,0}
+};
+static const int stbiw__jpg_YQT[] = {16,11,10,16,24,40,51,61,12,12,14,19,26,58,60,55,14,13,16,24,40,57,69,56,14,17,22,29,51,87,80,62,18,22,
+                                     37,56,68,109,103,77,24,35,55,64,81,104,113,92,49,64,78,87,103,121,120,101,72,92,95,98,112,100,103,99};
+static const int stbiw__jpg_UVQT[] = {17,18,24,47,99,99,99,99,18,21,26,66,99,99,99,99,24,26,56,99,99,99,99,99,47,66,99,99,99,99,99,99,
+                                      99,99,99,99,99,99,99,99,99,99,99,99,99,99,99,99,99,99,99,99,99,99,99,99,99,99,99,99,99,99,99,99};
+static const float stbiw__jpg_aasf[] = { 1.0f * 2.828427125f, 1.387039845f * 2.828427125f, 1.306562965f * 2.828427125f, 1.175875602f * 2.828427125f,
+                                         1.0f * 2.828427125f, 0.785694958f * 2.828427125f, 0.541196100f * 2.828427125f, 0.275899379f * 2.828427125f };
+
+static int stbiw__jpg_init_params(stbi_write_jpg_params *p, int width, int height, int comp, int quality, int subsample) {
+   int row, col, i, k;
+
+   if(!p || !width || !height || width > 65535 || height > 65535 || comp > 4 || comp < 1) {
       return 0;
    }
 
    quality = quality ? quality : 90;
-   subsample = quality <= 90 ? 1 : 0;
+   subsample = subsample < 0 ? (quality <= 90 ? 1 : 0) : (subsample ? 1 : 0);
    quality = quality < 1 ? 1 : quality > 100 ? 100 : quality;
    quality = quality < 50 ? 5000 / quality : 200 - quality * 2;
 
+   p->width = width;
+   p->height = height;
+   p->comp = comp;
+   p->subsample = subsample;
+   p->mcu_size = subsample ? 16 : 8;
+   p->mcus_per_row = (width + p->mcu_size - 1) / p->mcu_size;
+   p->num_mcu_rows = (height + p->mcu_size - 1) / p->mcu_size;
+   p->simd_level = stbi_write_jpg_simd_level;
+
    for(i = 0; i < 64; ++i) {
-      int uvti, yti = (YQT[i]*quality+50)/100;
-      YTable[stbiw__jpg_ZigZag[i]] = (unsigned char) (yti < 1 ? 1 : yti > 255 ? 255 : yti);
-      uvti = (UVQT[i]*quality+50)/100;
-      UVTable[stbiw__jpg_ZigZag[i]] = (unsigned char) (uvti < 1 ? 1 : uvti > 255 ? 255 : uvti);
+      int uvti, yti = (stbiw__jpg_YQT[i]*quality+50)/100;
+      p->YTable[stbiw__jpg_ZigZag[i]] = (unsigned char) (yti < 1 ? 1 : yti > 255 ? 255 : yti);
+      uvti = (stbiw__jpg_UVQT[i]*quality+50)/100;
+      p->UVTable[stbiw__jpg_ZigZag[i]] = (unsigned char) (uvti < 1 ? 1 : uvti > 255 ? 255 : uvti);
    }
 
    for(row = 0, k = 0; row < 8; ++row) {
       for(col = 0; col < 8; ++col, ++k) {
-         fdtbl_Y[k]  = 1 / (YTable [stbiw__jpg_ZigZag[k]] * aasf[row] * aasf[col]);
-         fdtbl_UV[k] = 1 / (UVTable[stbiw__jpg_ZigZag[k]] * aasf[row] * aasf[col]);
+         p->fdtbl_Y[k]  = 1 / (p->YTable [stbiw__jpg_ZigZag[k]] * stbiw__jpg_aasf[row] * stbiw__jpg_aasf[col]);
+         p->fdtbl_UV[k] = 1 / (p->UVTable[stbiw__jpg_ZigZag[k]] * stbiw__jpg_aasf[row] * stbiw__jpg_aasf[col]);
       }
    }
+   return 1;
+}
 
-   // Write Headers
-   {
-      static const unsigned char head0[] = { 0xFF,0xD8,0xFF,0xE0,0,0x10,'J','F','I','F',0,1,1,0,0,1,0,1,0,0,0xFF,0xDB,0,0x84,0 };
-      static const unsigned char head2[] = { 0xFF,0xDA,0,0xC,3,1,0,2,0x11,3,0x11,0,0x3F,0 };
-      const unsigned char head1[] = { 0xFF,0xC0,0,0x11,8,(unsigned char)(height>>8),STBIW_UCHAR(height),(unsigned char)(width>>8),STBIW_UCHAR(width),
-                                      3,1,(unsigned char)(subsample?0x22:0x11),0,2,0x11,1,3,0x11,1,0xFF,0xC4,0x01,0xA2,0 };
-      s->func(s->context, (void*)head0, sizeof(head0));
-      s->func(s->context, (void*)YTable, sizeof(YTable));
-      stbiw__putc(s, 1);
-      s->func(s->context, UVTable, sizeof(UVTable));
-      s->func(s->context, (void*)head1, sizeof(head1));
-      s->func(s->context, (void*)(std_dc_luminance_nrcodes+1), sizeof(std_dc_luminance_nrcodes)-1);
-      s->func(s->context, (void*)std_dc_luminance_values, sizeof(std_dc_luminance_values));
-      stbiw__putc(s, 0x10); // HTYACinfo
-      s->func(s->context, (void*)(std_ac_luminance_nrcodes+1), sizeof(std_ac_luminance_nrcodes)-1);
-      s->func(s->context, (void*)std_ac_luminance_values, sizeof(std_ac_luminance_values));
-      stbiw__putc(s, 1); // HTUDCinfo
-      s->func(s->context, (void*)(std_dc_chrominance_nrcodes+1), sizeof(std_dc_chrominance_nrcodes)-1);
-      s->func(s->context, (void*)std_dc_chrominance_values, sizeof(std_dc_chrominance_values));
-      stbiw__putc(s, 0x11); // HTUACinfo
-      s->func(s->context, (void*)(std_ac_chrominance_nrcodes+1), sizeof(std_ac_chrominance_nrcodes)-1);
-      s->func(s->context, (void*)std_ac_chrominance_values, sizeof(std_ac_chrominance_values));
-      s->func(s->context, (void*)head2, sizeof(head2));
+// restart_interval is the number of MCUs per restart interval, 0 means no restart markers (and no DRI segment)
+static void stbiw__jpg_write_headers(stbi__write_context *s, const stbi_write_jpg_params *p, int restart_interval) {
+   static const unsigned char head0[] = { 0xFF,0xD8,0xFF,0xE0,0,0x10,'J','F','I','F',0,1,1,0,0,1,0,1,0,0,0xFF,0xDB,0,0x84,0 };
+   static const unsigned char head2[] = { 0xFF,0xDA,0,0xC,3,1,0,2,0x11,3,0x11,0,0x3F,0 };
+   const unsigned char head1[] = { 0xFF,0xC0,0,0x11,8,(unsigned char)(p->height>>8),STBIW_UCHAR(p->height),(unsigned char)(p->width>>8),STBIW_UCHAR(p->width),
+                                   3,1,(unsigned char)(p->subsample?0x22:0x11),0,2,0x11,1,3,0x11,1,0xFF,0xC4,0x01,0xA2,0 };
+   const unsigned char dri[] = { 0xFF,0xDD,0,4,(unsigned char)(restart_interval>>8),STBIW_UCHAR(restart_interval) };
+   s->func(s->context, (void*)head0, sizeof(head0));
+   s->func(s->context, (void*)p->YTable, sizeof(p->YTable));
+   stbiw__putc(s, 1);
+   s->func(s->context, (void*)p->UVTable, sizeof(p->UVTable));
+   s->func(s->context, (void*)head1, sizeof(head1));
+   s->func(s->context, (void*)(stbiw__jpg_std_dc_luminance_nrcodes+1), sizeof(stbiw__jpg_std_dc_luminance_nrcodes)-1);
+   s->func(s->context, (void*)stbiw__jpg_std_dc_luminance_values, sizeof(stbiw__jpg_std_dc_luminance_values));
+   stbiw__putc(s, 0x10); // HTYACinfo
+   s->func(s->context, (void*)(stbiw__jpg_std_ac_luminance_nrcodes+1), sizeof(stbiw__jpg_std_ac_luminance_nrcodes)-1);
+   s->func(s->context, (void*)stbiw__jpg_std_ac_luminance_values, sizeof(stbiw__jpg_std_ac_luminance_values));
+   stbiw__putc(s, 1); // HTUDCinfo
+   s->func(s->context, (void*)(stbiw__jpg_std_dc_chrominance_nrcodes+1), sizeof(stbiw__jpg_std_dc_chrominance_nrcodes)-1);
+   s->func(s->context, (void*)stbiw__jpg_std_dc_chrominance_values, sizeof(stbiw__jpg_std_dc_chrominance_values));
+   stbiw__putc(s, 0x11); // HTUACinfo
+   s->func(s->context, (void*)(stbiw__jpg_std_ac_chrominance_nrcodes+1), sizeof(stbiw__jpg_std_ac_chrominance_nrcodes)-1);
+   s->func(s->context, (void*)stbiw__jpg_std_ac_chrominance_values, sizeof(stbiw__jpg_std_ac_chrominance_values));
+   if(restart_interval > 0) {
+      s->func(s->context, (void*)dri, sizeof(dri));
    }
+   s->func(s->context, (void*)head2, sizeof(head2));
+}
 
-   // Encode 8x8 macroblocks
-   {
-      static const unsigned short fillBits[] = {0x7F, 7};
-      int DCY=0, DCU=0, DCV=0;
-      int bitBuf=0, bitCnt=0;
-      // comp == 2 is grey+alpha (alpha is ignored)
-      int ofsG = comp > 2 ? 1 : 0, ofsB = comp > 2 ? 2 : 0;
-      const unsigned char *dataR = (const unsigned char *)data;
-      const unsigned char *dataG = dataR + ofsG;
-      const unsigned char *dataB = dataR + ofsB;
-      int x, y, pos;
-      if(subsample) {
-         for(y = 0; y < height; y += 16) {
-            for(x = 0; x < width; x += 16) {
-               float Y[256], U[256], V[256];
-               for(row = y, pos = 0; row < y+16; ++row) {
-                  // row >= height => use last input row
-                  int clamped_row = (row < height) ? row : height - 1;
-                  int base_p = (stbi__flip_vertically_on_write ? (height-1-clamped_row) : clamped_row)*width*comp;
-                  for(col = x; col < x+16; ++col, ++pos) {
-                     // if col >= width => use pixel from last input column
-                     int p = base_p + ((col < width) ? col : (width-1))*comp;
-                     float r = dataR[p], g = dataG[p], b = dataB[p];
-                     Y[pos]= +0.29900f*r + 0.58700f*g + 0.11400f*b - 128;
-                     U[pos]= -0.16874f*r - 0.33126f*g + 0.50000f*b;
-                     V[pos]= +0.50000f*r - 0.41869f*g - 0.08131f*b;
-                  }
+// Encodes the MCU rows [first_mcu_row, end_mcu_row). If restart_per_mcu_row is set, every MCU row is its own restart interval:
+// it's padded to a byte boundary, the DC predictors are reset and a RST marker follows it, except after the last MCU row of the image.
+// This makes the output of a range of MCU rows independent of the other rows, so ranges can be encoded separately and concatenated.
+static void stbiw__jpg_encode_mcu_rows(stbi__write_context *s, const stbi_write_jpg_params *p, const void *data, int first_mcu_row, int end_mcu_row, int restart_per_mcu_row) {
+   static const unsigned short fillBits[] = {0x7F, 7};
+   int DCY=0, DCU=0, DCV=0;
+   int bitBuf=0, bitCnt=0;
+   int width = p->width, height = p->height, comp = p->comp;
+   const float *fdtbl_Y = p->fdtbl_Y, *fdtbl_UV = p->fdtbl_UV;
+   // comp == 2 is grey+alpha (alpha is ignored)
+   int ofsG = comp > 2 ? 1 : 0, ofsB = comp > 2 ? 2 : 0;
+   const unsigned char *dataR = (const unsigned char *)data;
+   const unsigned char *dataG = dataR + ofsG;
+   const unsigned char *dataB = dataR + ofsB;
+   int simd_level = p->simd_level;
+   int simd_color_conversion = comp > 2 && simd_level;   // the color conversion kernels need RGB(A) input
+   int x, y, row, col, pos, mcu_row;
+   for(mcu_row = first_mcu_row; mcu_row < end_mcu_row; ++mcu_row) {
+      y = mcu_row * p->mcu_size;
+      if(p->subsample) {
+         for(x = 0; x < width; x += 16) {
+            float Y[256], U[256], V[256];
+            for(row = y, pos = 0; row < y+16; ++row) {
+               // row >= height => use last input row
+               int clamped_row = (row < height) ? row : height - 1;
+               int base_p = (stbi__flip_vertically_on_write ? (height-1-clamped_row) : clamped_row)*width*comp;
+               if(simd_color_conversion && x+16 <= width) {
+                  stbiw__jpg_rgb_to_ycc(dataR + base_p + x*comp, comp, 16, Y+pos, U+pos, V+pos, simd_level);
+                  pos += 16;
+                  continue;
                }
-               DCY = stbiw__jpg_processDU(s, &bitBuf, &bitCnt, Y+0,   16, fdtbl_Y, DCY, YDC_HT, YAC_HT);
-               DCY = stbiw__jpg_processDU(s, &bitBuf, &bitCnt, Y+8,   16, fdtbl_Y, DCY, YDC_HT, YAC_HT);
-               DCY = stbiw__jpg_processDU(s, &bitBuf, &bitCnt, Y+128, 16, fdtbl_Y, DCY, YDC_HT, YAC_HT);
-               DCY = stbiw__jpg_processDU(s, &bitBuf, &bitCnt, Y+136, 16, fdtbl_Y, DCY, YDC_HT, YAC_HT);
-
-               // subsample U,V
-               {
-                  float subU[64], subV[64];
-                  int yy, xx;
-                  for(yy = 0, pos = 0; yy < 8; ++yy) {
-                     for(xx = 0; xx < 8; ++xx, ++pos) {
-                        int j = yy*32+xx*2;
-                        subU[pos] = (U[j+0] + U[j+1] + U[j+16] + U[j+17]) * 0.25f;
-                        subV[pos] = (V[j+0] + V[j+1] + V[j+16] + V[j+17]) * 0.25f;
-                     }
+               for(col = x; col < x+16; ++col, ++pos) {
+                  // if col >= width => use pixel from last input column
+                  int pix = base_p + ((col < width) ? col : (width-1))*comp;
+                  float r = dataR[pix], g = dataG[pix], b = dataB[pix];
+                  Y[pos]= +0.29900f*r + 0.58700f*g + 0.11400f*b - 128;
+                  U[pos]= -0.16874f*r - 0.33126f*g + 0.50000f*b;
+                  V[pos]= +0.50000f*r - 0.41869f*g - 0.08131f*b;
+               }
+            }
+            DCY = stbiw__jpg_processDU(s, &bitBuf, &bitCnt, Y+0,   16, fdtbl_Y, DCY, stbiw__jpg_YDC_HT, stbiw__jpg_YAC_HT, simd_level);
+            DCY = stbiw__jpg_processDU(s, &bitBuf, &bitCnt, Y+8,   16, fdtbl_Y, DCY, stbiw__jpg_YDC_HT, stbiw__jpg_YAC_HT, simd_level);
+            DCY = stbiw__jpg_processDU(s, &bitBuf, &bitCnt, Y+128, 16, fdtbl_Y, DCY, stbiw__jpg_YDC_HT, stbiw__jpg_YAC_HT, simd_level);
+            DCY = stbiw__jpg_processDU(s, &bitBuf, &bitCnt, Y+136, 16, fdtbl_Y, DCY, stbiw__jpg_YDC_HT, stbiw__jpg_YAC_HT, simd_level);
+
+            // subsample U,V
+            {
+               float subU[64], subV[64];
+               int yy, xx;
+               for(yy = 0, pos = 0; yy < 8; ++yy) {
+                  for(xx = 0; xx < 8; ++xx, ++pos) {
+                     int j = yy*32+xx*2;
+                     subU[pos] = (U[j+0] + U[j+1] + U[j+16] + U[j+17]) * 0.25f;
+                     subV[pos] = (V[j+0] + V[j+1] + V[j+16] + V[j+17]) * 0.25f;
                   }
-                  DCU = stbiw__jpg_processDU(s, &bitBuf, &bitCnt, subU, 8, fdtbl_UV, DCU, UVDC_HT, UVAC_HT);
-                  DCV = stbiw__jpg_processDU(s, &bitBuf, &bitCnt, subV, 8, fdtbl_UV, DCV, UVDC_HT, UVAC_HT);
                }
+               DCU = stbiw__jpg_processDU(s, &bitBuf, &bitCnt, subU, 8, fdtbl_UV, DCU, stbiw__jpg_UVDC_HT, stbiw__jpg_UVAC_HT, simd_level);
+               DCV = stbiw__jpg_processDU(s, &bitBuf, &bitCnt, subV, 8, fdtbl_UV, DCV, stbiw__jpg_UVDC_HT, stbiw__jpg_UVAC_HT, simd_level);
             }
          }
       } else {
-         for(y = 0; y < height; y += 8) {
-            for(x = 0; x < width; x += 8) {
-               float Y[64], U[64], V[64];
-               for(row = y, pos = 0; row < y+8; ++row) {
-                  // row >= height => use last input row
-                  int clamped_row = (row < height) ? row : height - 1;
-                  int base_p = (stbi__flip_vertically_on_write ? (height-1-clamped_row) : clamped_row)*width*comp;
-                  for(col = x; col < x+8; ++col, ++pos) {
-                     // if col >= width => use pixel from last input column
-                     int p = base_p + ((col < width) ? col : (width-1))*comp;
-                     float r = dataR[p], g = dataG[p], b = dataB[p];
-                     Y[pos]= +0.29900f*r + 0.58700f*g + 0.11400f*b - 128;
-                     U[pos]= -0.16874f*r - 0.33126f*g + 0.50000f*b;
-                     V[pos]= +0.50000f*r - 0.41869f*g - 0.08131f*b;
-                  }
+         for(x = 0; x < width; x += 8) {
+            float Y[64], U[64], V[64];
+            for(row = y, pos = 0; row < y+8; ++row) {
+               // row >= height => use last input row
+               int clamped_row = (row < height) ? row : height - 1;
+               int base_p = (stbi__flip_vertically_on_write ? (height-1-clamped_row) : clamped_row)*width*comp;
+               if(simd_color_conversion && x+8 <= width) {
+                  stbiw__jpg_rgb_to_ycc(dataR + base_p + x*comp, comp, 8, Y+pos, U+pos, V+pos, simd_level);
+                  pos += 8;
+                  continue;
+               }
+               for(col = x; col < x+8; ++col, ++pos) {
+                  // if col >= width => use pixel from last input column
+                  int pix = base_p + ((col < width) ? col : (width-1))*comp;
+                  float r = dataR[pix], g = dataG[pix], b = dataB[pix];
+                  Y[pos]= +0.29900f*r + 0.58700f*g + 0.11400f*b - 128;
+                  U[pos]= -0.16874f*r - 0.33126f*g + 0.50000f*b;
+                  V[pos]= +0.50000f*r - 0.41869f*g - 0.08131f*b;
                }
-
-               DCY = stbiw__jpg_processDU(s, &bitBuf, &bitCnt, Y, 8, fdtbl_Y,  DCY, YDC_HT, YAC_HT);
-               DCU = stbiw__jpg_processDU(s, &bitBuf, &bitCnt, U, 8, fdtbl_UV, DCU, UVDC_HT, UVAC_HT);
-               DCV = stbiw__jpg_processDU(s, &bitBuf, &bitCnt, V, 8, fdtbl_UV, DCV, UVDC_HT, UVAC_HT);
             }
+
+            DCY = stbiw__jpg_processDU(s, &bitBuf, &bitCnt, Y, 8, fdtbl_Y,  DCY, stbiw__jpg_YDC_HT, stbiw__jpg_YAC_HT, simd_level);
+            DCU = stbiw__jpg_processDU(s, &bitBuf, &bitCnt, U, 8, fdtbl_UV, DCU, stbiw__jpg_UVDC_HT, stbiw__jpg_UVAC_HT, simd_level);
+            DCV = stbiw__jpg_processDU(s, &bitBuf, &bitCnt, V, 8, fdtbl_UV, DCV, stbiw__jpg_UVDC_HT, stbiw__jpg_UVAC_HT, simd_level);
          }
       }
 
+      if(restart_per_mcu_row) {
+         // Byte align the restart interval, the remaining bits in bitBuf are padding
+         stbiw__jpg_writeBits(s, &bitBuf, &bitCnt, fillBits);
+         bitBuf = 0;
+         bitCnt = 0;
+         DCY = DCU = DCV = 0;
+         if(mcu_row < p->num_mcu_rows - 1) {
+            stbiw__write1(s, 0xFF);
+            stbiw__write1(s, (unsigned char)(0xD0 + (mcu_row & 7)));
+         }
+      }
+   }
+
+   if(!restart_per_mcu_row) {
       // Do the bit alignment of the EOI marker
       stbiw__jpg_writeBits(s, &bitBuf, &bitCnt, fillBits);
    }
+   stbiw__write_flush(s);
+}
+
+static int stbi_write_jpg_core(stbi__write_context *s, int width, int height, int comp, const void* data, int quality) {
+   stbi_write_jpg_params p;
+
+   if(!data || !stbiw__jpg_init_params(&p, width, height, comp, quality, -1)) {
+      return 0;
+   }
+
+   stbiw__jpg_write_headers(s, &p, 0);
+   stbiw__jpg_encode_mcu_rows(s, &p, data, 0, p.num_mcu_rows, 0);
 
    // EOI
    stbiw__putc(s, 0xFF);
@@ -1611,6 +1974,37 @@ STBIWDEF int stbi_write_jpg_to_func(stbi_write_func *func, void *context, int x,
    return stbi_write_jpg_core(&s, x, y, comp, (void *) data, quality);
 }
 
+STBIWDEF int stbi_write_jpg_init_params(stbi_write_jpg_params *params, int x, int y, int comp, int quality, int subsample)
+{
+   return stbiw__jpg_init_params(params, x, y, comp, quality, subsample);
+}
+
+STBIWDEF int stbi_write_jpg_headers_to_func(stbi_write_func *func, void *context, const stbi_write_jpg_params *params)
+{
+   stbi__write_context s = { 0 };
+   stbi__start_write_callbacks(&s, func, context);
+   stbiw__jpg_write_headers(&s, params, params->mcus_per_row);
+   return 1;
+}
+
+STBIWDEF int stbi_write_jpg_mcu_rows_to_func(stbi_write_func *func, void *context, const stbi_write_jpg_params *params, const void *data, int first_mcu_row, int end_mcu_row)
+{
+   stbi__write_context s = { 0 };
+   if(!data || first_mcu_row < 0 || end_mcu_row > params->num_mcu_rows || first_mcu_row >= end_mcu_row) {
+      return 0;
+   }
+   stbi__start_write_callbacks(&s, func, context);
+   stbiw__jpg_encode_mcu_rows(&s, params, data, first_mcu_row, end_mcu_row, 1);
+   return 1;
+}
+
+STBIWDEF int stbi_write_jpg_end_to_func(stbi_write_func *func, void *context)
+{
+   static const unsigned char eoi[] = { 0xFF, 0xD9 };
+   func(context, (void*)eoi, sizeof(eoi));
+   return 1;
+}
+
 
 #ifndef STBI_WRITE_NO_STDIO
 STBIWDEF int stbi_write_jpg(char const *filename, int x, int y, int comp, const void *data, int quality)